@@ -18,6 +18,51 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// sim_ensemble_ano
+RObject sim_ensemble_ano(DataFrame user_input_df, List user_sim_params, List user_model_params, int n_replicates, int threads, std::string output_format);
+RcppExport SEXP _CalciumModelsLibrary_sim_ensemble_ano(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP n_replicatesSEXP, SEXP threadsSEXP, SEXP output_formatSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_replicates(n_replicatesSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output_format(output_formatSEXP);
+    rcpp_result_gen = Rcpp::wrap(sim_ensemble_ano(user_input_df, user_sim_params, user_model_params, n_replicates, threads, output_format));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sweep_ano
+RObject sweep_ano(DataFrame user_input_df, List user_sim_params, List user_model_params, DataFrame param_sets, int threads, std::string output);
+RcppExport SEXP _CalciumModelsLibrary_sweep_ano(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP param_setsSEXP, SEXP threadsSEXP, SEXP outputSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type param_sets(param_setsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output(outputSEXP);
+    rcpp_result_gen = Rcpp::wrap(sweep_ano(user_input_df, user_sim_params, user_model_params, param_sets, threads, output));
+    return rcpp_result_gen;
+END_RCPP
+}
+// detSim_native_ano
+DataFrame detSim_native_ano(DataFrame user_input_df, List user_sim_params, List user_model_params);
+RcppExport SEXP _CalciumModelsLibrary_detSim_native_ano(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    rcpp_result_gen = Rcpp::wrap(detSim_native_ano(user_input_df, user_sim_params, user_model_params));
+    return rcpp_result_gen;
+END_RCPP
+}
 // sim_calcineurin
 DataFrame sim_calcineurin(DataFrame user_input_df, List user_sim_params, List user_model_params);
 RcppExport SEXP _CalciumModelsLibrary_sim_calcineurin(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
@@ -31,6 +76,75 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// sim_ensemble_calcineurin
+RObject sim_ensemble_calcineurin(DataFrame user_input_df, List user_sim_params, List user_model_params, int n_replicates, int threads, std::string output_format);
+RcppExport SEXP _CalciumModelsLibrary_sim_ensemble_calcineurin(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP n_replicatesSEXP, SEXP threadsSEXP, SEXP output_formatSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_replicates(n_replicatesSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output_format(output_formatSEXP);
+    rcpp_result_gen = Rcpp::wrap(sim_ensemble_calcineurin(user_input_df, user_sim_params, user_model_params, n_replicates, threads, output_format));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sweep_calcineurin
+RObject sweep_calcineurin(DataFrame user_input_df, List user_sim_params, List user_model_params, DataFrame param_sets, int threads, std::string output);
+RcppExport SEXP _CalciumModelsLibrary_sweep_calcineurin(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP param_setsSEXP, SEXP threadsSEXP, SEXP outputSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type param_sets(param_setsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output(outputSEXP);
+    rcpp_result_gen = Rcpp::wrap(sweep_calcineurin(user_input_df, user_sim_params, user_model_params, param_sets, threads, output));
+    return rcpp_result_gen;
+END_RCPP
+}
+// detSim_native_calcineurin
+DataFrame detSim_native_calcineurin(DataFrame user_input_df, List user_sim_params, List user_model_params);
+RcppExport SEXP _CalciumModelsLibrary_detSim_native_calcineurin(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    rcpp_result_gen = Rcpp::wrap(detSim_native_calcineurin(user_input_df, user_sim_params, user_model_params));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_calcium_trace
+DataFrame read_calcium_trace(std::string file, double ca_factor);
+RcppExport SEXP _CalciumModelsLibrary_read_calcium_trace(SEXP fileSEXP, SEXP ca_factorSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
+    Rcpp::traits::input_parameter< double >::type ca_factor(ca_factorSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_calcium_trace(file, ca_factor));
+    return rcpp_result_gen;
+END_RCPP
+}
+// write_calcium_trace
+double write_calcium_trace(DataFrame input_df, std::string file);
+RcppExport SEXP _CalciumModelsLibrary_write_calcium_trace(SEXP input_dfSEXP, SEXP fileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type input_df(input_dfSEXP);
+    Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
+    rcpp_result_gen = Rcpp::wrap(write_calcium_trace(input_df, file));
+    return rcpp_result_gen;
+END_RCPP
+}
 // sim_calmodulin
 DataFrame sim_calmodulin(DataFrame user_input_df, List user_sim_params, List user_model_params);
 RcppExport SEXP _CalciumModelsLibrary_sim_calmodulin(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
@@ -44,6 +158,51 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// sim_ensemble_calmodulin
+RObject sim_ensemble_calmodulin(DataFrame user_input_df, List user_sim_params, List user_model_params, int n_replicates, int threads, std::string output_format);
+RcppExport SEXP _CalciumModelsLibrary_sim_ensemble_calmodulin(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP n_replicatesSEXP, SEXP threadsSEXP, SEXP output_formatSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_replicates(n_replicatesSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output_format(output_formatSEXP);
+    rcpp_result_gen = Rcpp::wrap(sim_ensemble_calmodulin(user_input_df, user_sim_params, user_model_params, n_replicates, threads, output_format));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sweep_calmodulin
+RObject sweep_calmodulin(DataFrame user_input_df, List user_sim_params, List user_model_params, DataFrame param_sets, int threads, std::string output);
+RcppExport SEXP _CalciumModelsLibrary_sweep_calmodulin(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP param_setsSEXP, SEXP threadsSEXP, SEXP outputSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type param_sets(param_setsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output(outputSEXP);
+    rcpp_result_gen = Rcpp::wrap(sweep_calmodulin(user_input_df, user_sim_params, user_model_params, param_sets, threads, output));
+    return rcpp_result_gen;
+END_RCPP
+}
+// detSim_native_calmodulin
+DataFrame detSim_native_calmodulin(DataFrame user_input_df, List user_sim_params, List user_model_params);
+RcppExport SEXP _CalciumModelsLibrary_detSim_native_calmodulin(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    rcpp_result_gen = Rcpp::wrap(detSim_native_calmodulin(user_input_df, user_sim_params, user_model_params));
+    return rcpp_result_gen;
+END_RCPP
+}
 // sim_camkii
 DataFrame sim_camkii(DataFrame user_input_df, List user_sim_params, List user_model_params);
 RcppExport SEXP _CalciumModelsLibrary_sim_camkii(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
@@ -57,6 +216,51 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// sim_ensemble_camkii
+RObject sim_ensemble_camkii(DataFrame user_input_df, List user_sim_params, List user_model_params, int n_replicates, int threads, std::string output_format);
+RcppExport SEXP _CalciumModelsLibrary_sim_ensemble_camkii(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP n_replicatesSEXP, SEXP threadsSEXP, SEXP output_formatSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_replicates(n_replicatesSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output_format(output_formatSEXP);
+    rcpp_result_gen = Rcpp::wrap(sim_ensemble_camkii(user_input_df, user_sim_params, user_model_params, n_replicates, threads, output_format));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sweep_camkii
+RObject sweep_camkii(DataFrame user_input_df, List user_sim_params, List user_model_params, DataFrame param_sets, int threads, std::string output);
+RcppExport SEXP _CalciumModelsLibrary_sweep_camkii(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP param_setsSEXP, SEXP threadsSEXP, SEXP outputSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type param_sets(param_setsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output(outputSEXP);
+    rcpp_result_gen = Rcpp::wrap(sweep_camkii(user_input_df, user_sim_params, user_model_params, param_sets, threads, output));
+    return rcpp_result_gen;
+END_RCPP
+}
+// detSim_native_camkii
+DataFrame detSim_native_camkii(DataFrame user_input_df, List user_sim_params, List user_model_params);
+RcppExport SEXP _CalciumModelsLibrary_detSim_native_camkii(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    rcpp_result_gen = Rcpp::wrap(detSim_native_camkii(user_input_df, user_sim_params, user_model_params));
+    return rcpp_result_gen;
+END_RCPP
+}
 // sim_glycphos
 DataFrame sim_glycphos(DataFrame user_input_df, List user_sim_params, List user_model_params);
 RcppExport SEXP _CalciumModelsLibrary_sim_glycphos(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
@@ -70,6 +274,140 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// sim_ensemble_glycphos
+RObject sim_ensemble_glycphos(DataFrame user_input_df, List user_sim_params, List user_model_params, int n_replicates, int threads, std::string output_format);
+RcppExport SEXP _CalciumModelsLibrary_sim_ensemble_glycphos(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP n_replicatesSEXP, SEXP threadsSEXP, SEXP output_formatSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_replicates(n_replicatesSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output_format(output_formatSEXP);
+    rcpp_result_gen = Rcpp::wrap(sim_ensemble_glycphos(user_input_df, user_sim_params, user_model_params, n_replicates, threads, output_format));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sweep_glycphos
+RObject sweep_glycphos(DataFrame user_input_df, List user_sim_params, List user_model_params, DataFrame param_sets, int threads, std::string output);
+RcppExport SEXP _CalciumModelsLibrary_sweep_glycphos(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP param_setsSEXP, SEXP threadsSEXP, SEXP outputSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type param_sets(param_setsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output(outputSEXP);
+    rcpp_result_gen = Rcpp::wrap(sweep_glycphos(user_input_df, user_sim_params, user_model_params, param_sets, threads, output));
+    return rcpp_result_gen;
+END_RCPP
+}
+// detSim_native_glycphos
+DataFrame detSim_native_glycphos(DataFrame user_input_df, List user_sim_params, List user_model_params);
+RcppExport SEXP _CalciumModelsLibrary_detSim_native_glycphos(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    rcpp_result_gen = Rcpp::wrap(detSim_native_glycphos(user_input_df, user_sim_params, user_model_params));
+    return rcpp_result_gen;
+END_RCPP
+}
+// network_model
+List network_model(NumericVector init_conc, NumericVector params, NumericMatrix stoichiometry, CharacterVector propensities, double vol);
+RcppExport SEXP _CalciumModelsLibrary_network_model(SEXP init_concSEXP, SEXP paramsSEXP, SEXP stoichiometrySEXP, SEXP propensitiesSEXP, SEXP volSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type init_conc(init_concSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< NumericMatrix >::type stoichiometry(stoichiometrySEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type propensities(propensitiesSEXP);
+    Rcpp::traits::input_parameter< double >::type vol(volSEXP);
+    rcpp_result_gen = Rcpp::wrap(network_model(init_conc, params, stoichiometry, propensities, vol));
+    return rcpp_result_gen;
+END_RCPP
+}
+// import_network_model
+List import_network_model(std::string file, std::string calcium);
+RcppExport SEXP _CalciumModelsLibrary_import_network_model(SEXP fileSEXP, SEXP calciumSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
+    Rcpp::traits::input_parameter< std::string >::type calcium(calciumSEXP);
+    rcpp_result_gen = Rcpp::wrap(import_network_model(file, calcium));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sim_network
+DataFrame sim_network(List model, DataFrame user_input_df, List user_sim_params, List user_model_params);
+RcppExport SEXP _CalciumModelsLibrary_sim_network(SEXP modelSEXP, SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    rcpp_result_gen = Rcpp::wrap(sim_network(model, user_input_df, user_sim_params, user_model_params));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sim_ensemble_network
+RObject sim_ensemble_network(List model, DataFrame user_input_df, List user_sim_params, List user_model_params, int n_replicates, int threads, std::string output_format);
+RcppExport SEXP _CalciumModelsLibrary_sim_ensemble_network(SEXP modelSEXP, SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP n_replicatesSEXP, SEXP threadsSEXP, SEXP output_formatSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_replicates(n_replicatesSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output_format(output_formatSEXP);
+    rcpp_result_gen = Rcpp::wrap(sim_ensemble_network(model, user_input_df, user_sim_params, user_model_params, n_replicates, threads, output_format));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sweep_network
+RObject sweep_network(List model, DataFrame user_input_df, List user_sim_params, List user_model_params, DataFrame param_sets, int threads, std::string output);
+RcppExport SEXP _CalciumModelsLibrary_sweep_network(SEXP modelSEXP, SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP param_setsSEXP, SEXP threadsSEXP, SEXP outputSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type param_sets(param_setsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output(outputSEXP);
+    rcpp_result_gen = Rcpp::wrap(sweep_network(model, user_input_df, user_sim_params, user_model_params, param_sets, threads, output));
+    return rcpp_result_gen;
+END_RCPP
+}
+// detSim_native_network
+DataFrame detSim_native_network(List model, DataFrame user_input_df, List user_sim_params, List user_model_params);
+RcppExport SEXP _CalciumModelsLibrary_detSim_native_network(SEXP modelSEXP, SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    rcpp_result_gen = Rcpp::wrap(detSim_native_network(model, user_input_df, user_sim_params, user_model_params));
+    return rcpp_result_gen;
+END_RCPP
+}
 // sim_pkc
 DataFrame sim_pkc(DataFrame user_input_df, List user_sim_params, List user_model_params);
 RcppExport SEXP _CalciumModelsLibrary_sim_pkc(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
@@ -83,18 +421,118 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// sim_ensemble_pkc
+RObject sim_ensemble_pkc(DataFrame user_input_df, List user_sim_params, List user_model_params, int n_replicates, int threads, std::string output_format);
+RcppExport SEXP _CalciumModelsLibrary_sim_ensemble_pkc(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP n_replicatesSEXP, SEXP threadsSEXP, SEXP output_formatSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< int >::type n_replicates(n_replicatesSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output_format(output_formatSEXP);
+    rcpp_result_gen = Rcpp::wrap(sim_ensemble_pkc(user_input_df, user_sim_params, user_model_params, n_replicates, threads, output_format));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sweep_pkc
+RObject sweep_pkc(DataFrame user_input_df, List user_sim_params, List user_model_params, DataFrame param_sets, int threads, std::string output);
+RcppExport SEXP _CalciumModelsLibrary_sweep_pkc(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP, SEXP param_setsSEXP, SEXP threadsSEXP, SEXP outputSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    Rcpp::traits::input_parameter< DataFrame >::type param_sets(param_setsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output(outputSEXP);
+    rcpp_result_gen = Rcpp::wrap(sweep_pkc(user_input_df, user_sim_params, user_model_params, param_sets, threads, output));
+    return rcpp_result_gen;
+END_RCPP
+}
+// detSim_native_pkc
+DataFrame detSim_native_pkc(DataFrame user_input_df, List user_sim_params, List user_model_params);
+RcppExport SEXP _CalciumModelsLibrary_detSim_native_pkc(SEXP user_input_dfSEXP, SEXP user_sim_paramsSEXP, SEXP user_model_paramsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< DataFrame >::type user_input_df(user_input_dfSEXP);
+    Rcpp::traits::input_parameter< List >::type user_sim_params(user_sim_paramsSEXP);
+    Rcpp::traits::input_parameter< List >::type user_model_params(user_model_paramsSEXP);
+    rcpp_result_gen = Rcpp::wrap(detSim_native_pkc(user_input_df, user_sim_params, user_model_params));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_trajectory
+DataFrame read_trajectory(std::string file, CharacterVector species, double from, double to);
+RcppExport SEXP _CalciumModelsLibrary_read_trajectory(SEXP fileSEXP, SEXP speciesSEXP, SEXP fromSEXP, SEXP toSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type species(speciesSEXP);
+    Rcpp::traits::input_parameter< double >::type from(fromSEXP);
+    Rcpp::traits::input_parameter< double >::type to(toSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_trajectory(file, species, from, to));
+    return rcpp_result_gen;
+END_RCPP
+}
+// trajectory_info
+List trajectory_info(std::string file);
+RcppExport SEXP _CalciumModelsLibrary_trajectory_info(SEXP fileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
+    rcpp_result_gen = Rcpp::wrap(trajectory_info(file));
+    return rcpp_result_gen;
+END_RCPP
+}
 
+void register_ode_det_models(DllInfo* dll);
 static const R_CallMethodDef CallEntries[] = {
     {"_CalciumModelsLibrary_sim_ano", (DL_FUNC) &_CalciumModelsLibrary_sim_ano, 3},
+    {"_CalciumModelsLibrary_sim_ensemble_ano", (DL_FUNC) &_CalciumModelsLibrary_sim_ensemble_ano, 6},
+    {"_CalciumModelsLibrary_sweep_ano", (DL_FUNC) &_CalciumModelsLibrary_sweep_ano, 6},
+    {"_CalciumModelsLibrary_detSim_native_ano", (DL_FUNC) &_CalciumModelsLibrary_detSim_native_ano, 3},
     {"_CalciumModelsLibrary_sim_calcineurin", (DL_FUNC) &_CalciumModelsLibrary_sim_calcineurin, 3},
+    {"_CalciumModelsLibrary_sim_ensemble_calcineurin", (DL_FUNC) &_CalciumModelsLibrary_sim_ensemble_calcineurin, 6},
+    {"_CalciumModelsLibrary_sweep_calcineurin", (DL_FUNC) &_CalciumModelsLibrary_sweep_calcineurin, 6},
+    {"_CalciumModelsLibrary_detSim_native_calcineurin", (DL_FUNC) &_CalciumModelsLibrary_detSim_native_calcineurin, 3},
+    {"_CalciumModelsLibrary_read_calcium_trace", (DL_FUNC) &_CalciumModelsLibrary_read_calcium_trace, 2},
+    {"_CalciumModelsLibrary_write_calcium_trace", (DL_FUNC) &_CalciumModelsLibrary_write_calcium_trace, 2},
     {"_CalciumModelsLibrary_sim_calmodulin", (DL_FUNC) &_CalciumModelsLibrary_sim_calmodulin, 3},
+    {"_CalciumModelsLibrary_sim_ensemble_calmodulin", (DL_FUNC) &_CalciumModelsLibrary_sim_ensemble_calmodulin, 6},
+    {"_CalciumModelsLibrary_sweep_calmodulin", (DL_FUNC) &_CalciumModelsLibrary_sweep_calmodulin, 6},
+    {"_CalciumModelsLibrary_detSim_native_calmodulin", (DL_FUNC) &_CalciumModelsLibrary_detSim_native_calmodulin, 3},
     {"_CalciumModelsLibrary_sim_camkii", (DL_FUNC) &_CalciumModelsLibrary_sim_camkii, 3},
+    {"_CalciumModelsLibrary_sim_ensemble_camkii", (DL_FUNC) &_CalciumModelsLibrary_sim_ensemble_camkii, 6},
+    {"_CalciumModelsLibrary_sweep_camkii", (DL_FUNC) &_CalciumModelsLibrary_sweep_camkii, 6},
+    {"_CalciumModelsLibrary_detSim_native_camkii", (DL_FUNC) &_CalciumModelsLibrary_detSim_native_camkii, 3},
     {"_CalciumModelsLibrary_sim_glycphos", (DL_FUNC) &_CalciumModelsLibrary_sim_glycphos, 3},
+    {"_CalciumModelsLibrary_sim_ensemble_glycphos", (DL_FUNC) &_CalciumModelsLibrary_sim_ensemble_glycphos, 6},
+    {"_CalciumModelsLibrary_sweep_glycphos", (DL_FUNC) &_CalciumModelsLibrary_sweep_glycphos, 6},
+    {"_CalciumModelsLibrary_detSim_native_glycphos", (DL_FUNC) &_CalciumModelsLibrary_detSim_native_glycphos, 3},
+    {"_CalciumModelsLibrary_network_model", (DL_FUNC) &_CalciumModelsLibrary_network_model, 5},
+    {"_CalciumModelsLibrary_import_network_model", (DL_FUNC) &_CalciumModelsLibrary_import_network_model, 2},
+    {"_CalciumModelsLibrary_sim_network", (DL_FUNC) &_CalciumModelsLibrary_sim_network, 4},
+    {"_CalciumModelsLibrary_sim_ensemble_network", (DL_FUNC) &_CalciumModelsLibrary_sim_ensemble_network, 7},
+    {"_CalciumModelsLibrary_sweep_network", (DL_FUNC) &_CalciumModelsLibrary_sweep_network, 7},
+    {"_CalciumModelsLibrary_detSim_native_network", (DL_FUNC) &_CalciumModelsLibrary_detSim_native_network, 4},
     {"_CalciumModelsLibrary_sim_pkc", (DL_FUNC) &_CalciumModelsLibrary_sim_pkc, 3},
+    {"_CalciumModelsLibrary_sim_ensemble_pkc", (DL_FUNC) &_CalciumModelsLibrary_sim_ensemble_pkc, 6},
+    {"_CalciumModelsLibrary_sweep_pkc", (DL_FUNC) &_CalciumModelsLibrary_sweep_pkc, 6},
+    {"_CalciumModelsLibrary_detSim_native_pkc", (DL_FUNC) &_CalciumModelsLibrary_detSim_native_pkc, 3},
+    {"_CalciumModelsLibrary_read_trajectory", (DL_FUNC) &_CalciumModelsLibrary_read_trajectory, 4},
+    {"_CalciumModelsLibrary_trajectory_info", (DL_FUNC) &_CalciumModelsLibrary_trajectory_info, 1},
     {NULL, NULL, 0}
 };
 
 RcppExport void R_init_CalciumModelsLibrary(DllInfo *dll) {
     R_registerRoutines(dll, NULL, CallEntries, NULL, NULL);
     R_useDynamicSymbols(dll, FALSE);
+    register_ode_det_models(dll);
 }
@@ -5,13 +5,39 @@ using namespace Rcpp;
 
 //********************************/* R EXPORT OPTIONS */********************************
 
-// 1. USER INPUT for new models: Change value of the macro variable MODEL_NAME to the name of the new model.
-#define MODEL_NAME ano
-// include the simulation function with macros (#define statements) that make it model specific (based on MODEL_NAME)
-#include "simulator.cpp"
-// Global variables
-static std::map <std::string, double> prop_params_map;
-// 2. USER INPUT for new models: Change the name of the wrapper function to sim_<MODEL_NAME> and the names of the internally called functions to init_<MODEL_NAME> and simulator_<MODEL_NAME>.
+// include the simulation engine (instantiated for the model traits by the wrapper functions)
+#include "simulator.hpp"
+// 1. USER INPUT for new models: Declare the traits of the new model (see simulator.hpp): its name, the numbers of species and reactions,
+// the stoichiometric matrix and the model specific functions (defined in the MODEL DEFINITION section below).
+struct AnoModel {
+  static std::string name() { return "ano"; }
+  static constexpr int nspecies = 13;
+  static constexpr int nreactions = 40;
+  // Stoichiometric matrix (rows: species, columns: reactions)
+  static constexpr int stoichiometry[nspecies][nreactions] = {
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {-1, 1, -1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 1, -1, -1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 1, -1, 0, 0, 0, 0, 0, 0, -1, 1, -1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 1, -1, -1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, -1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 1, -1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, -1, 1, -1, 1, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 1, -1, -1, 1, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, -1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 1, -1}
+  };
+  static List init();
+  static void compile_params(SimulationContext &ctx);
+  static void calculate_ca_factors(SimulationContext &ctx);
+  template <typename T>
+  static double propensity(const SimulationContext &ctx, const T *x, unsigned int j);
+  static double propensity_derivative(const SimulationContext &ctx, const double *x, unsigned int j, unsigned int i);
+  static NumericMatrix get_depM();
+};
+// 2. USER INPUT for new models: Change the name of the wrapper function to sim_<model name> and the model traits in the internally called functions AnoModel::init and simulator<AnoModel>.
 //' Ano1 Model R Wrapper Function (exported to R)
 //'
 //' This function compares user-supplied parameters to defaults parameter values, overwrites the defaults if neccessary, and calls the internal C++ simulation function for the ano model.
@@ -77,96 +103,144 @@ DataFrame sim_ano(DataFrame user_input_df,
                   List user_sim_params,
                   List user_model_params) {
 
-  // READ INPUT
-  // Provide default model parameters list
-  List default_model_params = init_ano();
-  // Extract default vectors from list
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = AnoModel::init();
   NumericVector default_vols = default_model_params["vols"];
   NumericVector default_init_conc = default_model_params["init_conc"];
   NumericVector default_params = default_model_params["params"];
-  // Extract vectors from user supplied list 
-  // If they exist: definition with the default vector gets overwritten
-  NumericVector user_vols = default_vols;
-  if (user_model_params.containsElementNamed("vols")) {
-      user_vols = user_model_params["vols"];
-  } else {
-    Rcout << "Default volume(s) have been used." << std::endl;
-  } 
-  NumericVector user_init_conc = default_init_conc;
-  if (user_model_params.containsElementNamed("init_conc")) {
-    user_init_conc = user_model_params["init_conc"];
-  } else {
-    Rcout << "Default initial condition(s) have been used." << std::endl;
-  }
-  NumericVector user_params = default_params;
-  if (user_model_params.containsElementNamed("params")) {
-    user_params = user_model_params["params"];
-  } else {
-    Rcout << "Default reaction parameter(s) have been used." << std::endl;
-  }
-  // UPDATE DEFAULTS 
-  // Replace entries in default_model_params with user-supplied values if necessary
-  // 1.) Volumes update:
-  CharacterVector user_vols_names = user_vols.names();
-  for (int i = 0; i < user_vols_names.length(); i++) {
-    std::string current_vol_name = as<std::string>(user_vols_names[i]);
-    if (default_vols.containsElementNamed((current_vol_name).c_str())) {
-      // update default values
-      default_vols[current_vol_name] = user_vols[current_vol_name];    
-    } else {
-      Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
-    }
-  }
-  // 2.) Initial conditions update:
-  CharacterVector user_init_conc_names = user_init_conc.names();
-  for (int i = 0; i < user_init_conc_names.length(); i++) {
-    std::string current_init_conc_name = as<std::string>(user_init_conc_names[i]);
-    if (default_init_conc.containsElementNamed((current_init_conc_name).c_str())) {
-      // update default values
-      default_init_conc[current_init_conc_name] = user_init_conc[current_init_conc_name];    
-    } else {
-      Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
-    }
-  }
-  // 3.) Propensity equation parameters update:
-  CharacterVector user_params_names = user_params.names();
-  for (int i = 0; i < user_params_names.length(); i++) {
-    std::string current_param_name = as<std::string>(user_params_names[i]);
-    if (default_params.containsElementNamed((current_param_name).c_str())) {
-      // update default values
-      default_params[current_param_name] = user_params[current_param_name];    
-    } else {
-      Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
-    }
-  }
-  // Put propensity reaction parameters in a map (for function calculate_amu)
-  // (take parameters from vector "default_params" which contains the updated values)
-  CharacterVector default_params_names = default_params.names();
-  for (int n = 0; n < default_params.length(); n++) {
-    std::string current_param_name = as<std::string>(default_params_names[n]);
-    prop_params_map[current_param_name] = default_params[current_param_name];  
-  }
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
   // RUN SIMULATION
-  // Return result of the included, model-specific copy of the function "simulator" 
-  return simulator_ano(user_input_df,
-                       user_sim_params,
-                       default_vols,
-                       default_init_conc);
+  // Return result of the function "simulator" of the engine, instantiated for the model traits
+  return simulator<AnoModel>(user_input_df,
+                             user_sim_params,
+                             default_vols,
+                             default_init_conc,
+                             default_params);
    
 }
 
 
 
+//' Ano1 Model Ensemble R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters with the user-supplied ones (as sim_ano) and simulates n_replicates independent
+//' stochastic replicates of the Ano1 model on a pool of threads, each replicate with its own stream of the native random number generator.
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "seed" and first "stream" of the random number generator and the "output_species".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters). 
+//' @param n_replicates An integer: the number of replicates.
+//' @param threads An integer: the number of threads (<= 0: all available cores).
+//' @param output_format A string: "long" (data frame of the stacked replicates with a "replicate" column) or "array" (3-D array: output times x columns x replicates).
+//' @return the result of calling the model specific version of the function "ensemble_simulator" 
+//' @examples
+//' sim_ensemble_ano()
+//' @export
+// [[Rcpp::export]]
+RObject sim_ensemble_ano(DataFrame user_input_df,
+                         List user_sim_params,
+                         List user_model_params,
+                         int n_replicates,
+                         int threads = 1,
+                         std::string output_format = "long") {
+
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = AnoModel::init();
+  NumericVector default_vols = default_model_params["vols"];
+  NumericVector default_init_conc = default_model_params["init_conc"];
+  NumericVector default_params = default_model_params["params"];
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATIONS
+  return ensemble_simulator<AnoModel>(user_input_df,
+                                      user_sim_params,
+                                      default_vols,
+                                      default_init_conc,
+                                      default_params,
+                                      n_replicates,
+                                      threads,
+                                      output_format);
+}
+
+
+
+//' Ano1 Model Parameter Sweep R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters with the user-supplied ones (as sim_ano) and simulates the Ano1 model once for every row of
+//' param_sets on a pool of threads. The column names of param_sets are resolved once against the model's volumes, initial conditions and parameters.
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "seed" and first "stream" of the random number generator and the "output_species".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters). 
+//' @param param_sets A Dataframe (or matrix): one parameter set per row, with columns named like the volumes, initial conditions or parameters to vary (and optionally a per-row "seed").
+//' @param threads An integer: the number of threads (<= 0: all available cores).
+//' @param output A string: "summary" (time average and final value of every species per parameter set) or "trajectory" (stacked trajectories with a "set" column).
+//' @return the result of calling the model specific version of the function "sweep_simulator" 
+//' @examples
+//' sweep_ano()
+//' @export
+// [[Rcpp::export]]
+RObject sweep_ano(DataFrame user_input_df,
+                  List user_sim_params,
+                  List user_model_params,
+                  DataFrame param_sets,
+                  int threads = 1,
+                  std::string output = "summary") {
+
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = AnoModel::init();
+  NumericVector default_vols = default_model_params["vols"];
+  NumericVector default_init_conc = default_model_params["init_conc"];
+  NumericVector default_params = default_model_params["params"];
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATIONS
+  return sweep_simulator<AnoModel>(user_input_df,
+                                   user_sim_params,
+                                   default_vols,
+                                   default_init_conc,
+                                   default_params,
+                                   param_sets,
+                                   threads,
+                                   output);
+}
+
+
+
+//' Ano1 Model Deterministic R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters with the user-supplied ones (as sim_ano) and integrates the reaction rate equations of the Ano1 model
+//' natively (deterministic limit of the stochastic model of sim_ano; same output columns as detSim_ano).
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "solver" ("rosenbrock" or "rk45") and its tolerances "rtol" and "atol".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters). 
+//' @return the result of calling the model specific version of the function "det_simulator" 
+//' @examples
+//' detSim_native_ano()
+//' @export
+// [[Rcpp::export]]
+DataFrame detSim_native_ano(DataFrame user_input_df,
+                            List user_sim_params,
+                            List user_model_params) {
+
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = AnoModel::init();
+  NumericVector default_vols = default_model_params["vols"];
+  NumericVector default_init_conc = default_model_params["init_conc"];
+  NumericVector default_params = default_model_params["params"];
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATION
+  return det_simulator<AnoModel>(user_input_df,
+                                 user_sim_params,
+                                 default_vols,
+                                 default_init_conc,
+                                 default_params);
+}
+
+
+
 //********************************/* MODEL DEFINITION */********************************
-// 3. USER INPUT for new models: define model parameters, number of species, 
-// number of reactions, propensity equations and update_system function 
+// 3. USER INPUT for new models: define the model specific functions of the traits: model parameters, their compilation into the indexed parameter array,
+// the calcium dependent factors, propensity equations and the species each propensity depends on
 
 // Default model parameters
-List init() {
-  // Model dimensions
-  nspecies = 13;
-  nreactions = 40;
-  
+List AnoModel::init() {
   // Default volume(s)
   NumericVector vols = NumericVector::create(
     _["vol"] = 1e-11
@@ -229,46 +303,45 @@ List init() {
   );
 }
 
-// Propensity calculation:
-// Calculates the propensities of all Ano1 model reactions and stores them in the vector amu.
-void calculate_amu() {
+// Parameter compilation:
+// Resolves the parameter names once per run and pre-computes the parameter-only part of every propensity:
+// k[j] is the rate constant of reaction j including its voltage dependent factor exp(+-z * vterm), which is constant for fixed Vm and T.
+void AnoModel::compile_params(SimulationContext &ctx) {
   
-  // Look up model parameters in array 'model_params' initially
-  double Vm = prop_params_map["Vm"];
-  double T = prop_params_map["T"];
-  double a1 = prop_params_map["a1"];
-  double b1 = prop_params_map["b1"];
-  double k01 = prop_params_map["k01"];
-  double k02 = prop_params_map["k02"];
-  double acl1 = prop_params_map["acl1"];
-  double bcl1 = prop_params_map["bcl1"];
-  double kccl1 = prop_params_map["kccl1"];
-  double kccl2 = prop_params_map["kccl2"];
-  double kocl1 = prop_params_map["kocl1"];
-  double kocl2 = prop_params_map["kocl2"];
-  double za1 = prop_params_map["za1"];
-  double zb1 = prop_params_map["zb1"];
-  double zk01 = prop_params_map["zk01"];
-  double zk02 = prop_params_map["zk02"];
-  double zacl1 = prop_params_map["zacl1"];
-  double zbcl1 = prop_params_map["zbcl1"];
-  double zkccl1 = prop_params_map["zkccl1"];
-  double zkccl2 = prop_params_map["zkccl2"];
-  double zkocl1 = prop_params_map["zkocl1"];
-  double zkocl2 = prop_params_map["zkocl2"];
-  double l = prop_params_map["l"];
-  double L = prop_params_map["L"];
-  double m = prop_params_map["m"];
-  double M = prop_params_map["M"];
-  double h = prop_params_map["h"];
-  double H = prop_params_map["H"];
+  // Look up model parameters by name
+  double Vm = prop_param(ctx, "Vm");
+  double T = prop_param(ctx, "T");
+  double a1 = prop_param(ctx, "a1");
+  double b1 = prop_param(ctx, "b1");
+  double k01 = prop_param(ctx, "k01");
+  double k02 = prop_param(ctx, "k02");
+  double acl1 = prop_param(ctx, "acl1");
+  double bcl1 = prop_param(ctx, "bcl1");
+  double kccl1 = prop_param(ctx, "kccl1");
+  double kccl2 = prop_param(ctx, "kccl2");
+  double kocl1 = prop_param(ctx, "kocl1");
+  double kocl2 = prop_param(ctx, "kocl2");
+  double za1 = prop_param(ctx, "za1");
+  double zb1 = prop_param(ctx, "zb1");
+  double zk01 = prop_param(ctx, "zk01");
+  double zk02 = prop_param(ctx, "zk02");
+  double zacl1 = prop_param(ctx, "zacl1");
+  double zbcl1 = prop_param(ctx, "zbcl1");
+  double zkccl1 = prop_param(ctx, "zkccl1");
+  double zkccl2 = prop_param(ctx, "zkccl2");
+  double zkocl1 = prop_param(ctx, "zkocl1");
+  double zkocl2 = prop_param(ctx, "zkocl2");
+  double l = prop_param(ctx, "l");
+  double L = prop_param(ctx, "L");
+  double m = prop_param(ctx, "m");
+  double M = prop_param(ctx, "M");
+  double h = prop_param(ctx, "h");
+  double H = prop_param(ctx, "H");
   
   // Required constants
   // faradayConst = 96485.3329;
   // gasConst = 8.3144598; 
-  double vterm;
-  // vterm = 96485.3329 * model_params["Vm"] / (8.3144598 * model_params["T"]);
-  vterm = 96485.3329 * Vm / (8.3144598 * T);
+  double vterm = 96485.3329 * Vm / (8.3144598 * T);
   
   //forward:      k1 * exp( z * vterm ) * x[0];
   //backward:     k1 * exp( -z * vterm ) * x[0];
@@ -279,93 +352,214 @@ void calculate_amu() {
   //forward2rev:  k1 * exp( z * vterm ) * x[0];
   //backward2rev: k1 * exp( -z * vterm ) * 2 * x[0];
   
-  // Propensity Equations (results are stored cumulative)
-  amu[0] =             a1 * exp(za1 * vterm) * x[1]; //f: C - O
-  amu[1] = amu[0] +    b1 * exp(-zb1 * vterm) * x[7]; //b: C - O
-  amu[2] = amu[1] +    k01 * exp(zk01 * vterm) * 2 * calcium[ntimepoint] * x[1]; //f: C - Ca
-  amu[3] = amu[2] +    l/L * k02 * exp(-zk02 * vterm) * x[3]; //b: C - Ca
-  amu[4] = amu[3] +    kccl1 * exp(zkccl1 * vterm) * x[0] * x[1]; //f: C - Cl
-  amu[5] = amu[4] +    kccl2 * exp(-zkccl2 * vterm) * x[2]; //b: C - Cl
+  // Voltage dependent factors
+  double a1_v = a1 * exp(za1 * vterm);
+  double b1_v = b1 * exp(-zb1 * vterm);
+  double k01_v = k01 * exp(zk01 * vterm);
+  double k02_v = k02 * exp(-zk02 * vterm);
+  double kccl1_v = kccl1 * exp(zkccl1 * vterm);
+  double kccl2_v = kccl2 * exp(-zkccl2 * vterm);
+  double acl1_v = acl1 * exp(zacl1 * vterm);
+  double bcl1_v = bcl1 * exp(-zbcl1 * vterm);
+  double kocl1_v = kocl1 * exp(zkocl1 * vterm);
+  double kocl2_v = kocl2 * exp(-zkocl2 * vterm);
+  
+  // Rate constants
+  ctx.k.assign(40, 0);
+  double *k = ctx.k.data();
+  k[0] =              a1_v; //f: C - O
+  k[1] =              b1_v; //b: C - O
+  k[2] =              k01_v * 2; //f: C - Ca
+  k[3] =              l/L * k02_v; //b: C - Ca
+  k[4] =              kccl1_v; //f: C - Cl
+  k[5] =              kccl2_v; //b: C - Cl
+  
+  k[6] =              acl1_v; //f: C_c - O
+  k[7] =              bcl1_v; //b: C_c - O
+  k[8] =              h/H * k01_v * 2; //f: C_c - Ca
+  k[9] =              l/L * k02_v; //b: C_c - Ca
+  
+  k[10] =             l * a1_v; //f: C_1 - O
+  k[11] =             L * b1_v; //b: C_1 - O
+  k[12] =             k01_v; //f: C_1 - Ca
+  k[13] =             l/L * 2 * k02_v; //b: C_1 - Ca
+  k[14] =             h * kccl1_v; //f: C_1 - Cl
+  k[15] =             H * kccl2_v; //b: C_1 - Cl
   
-  amu[6] = amu[5] +    acl1 * exp(zacl1 * vterm) * x[2]; //f: C_c - O
-  amu[7] = amu[6] +    bcl1 * exp(-zbcl1 * vterm) * x[8]; //b: C_c - O
-  amu[8] = amu[7] +    h/H * k01 * exp(zk01 * vterm) * 2 * calcium[ntimepoint] * x[2]; //f: C_c - Ca
-  amu[9] = amu[8] +    l/L * k02 * exp(-zk02 * vterm) * x[4]; //b: C_c - Ca
+  k[16] =             H*m*l/M * acl1_v; //f: C_1c - O
+  k[17] =             h*L * bcl1_v; //b: C_1c - O
+  k[18] =             h/H * k01_v; //f: C_1c - Ca
+  k[19] =             l/L * 2 * k02_v; //b: C_1c - Ca
   
-  amu[10] = amu[9] +   l * a1 * exp(za1 * vterm) * x[3]; //f: C_1 - O
-  amu[11] = amu[10] +  L * b1 * exp(-zb1 * vterm) * x[9]; //b: C_1 - O
-  amu[12] = amu[11] +  k01 * exp(zk01 * vterm) * calcium[ntimepoint] * x[3]; //f: C_1 - Ca
-  amu[13] = amu[12] +  l/L * 2 * k02 * exp(-zk02 * vterm) * x[5]; //b: C_1 - Ca
-  amu[14] = amu[13] +  h * kccl1 * exp(zkccl1 * vterm) * x[0] * x[3]; //f: C_1 - Cl
-  amu[15] = amu[14] +  H * kccl2 * exp(-zkccl2 * vterm) * x[4]; //b: C_1 - Cl
+  k[20] =             pow(l,2) * a1_v; //f: C_2 - O
+  k[21] =             pow(L,2) * b1_v; //b: C_2 - O
+  k[22] =             pow(h,2) * kccl1_v; //f: C_2 - Cl
+  k[23] =             pow(H,2) * kccl2_v; //b: C_2 - Cl
   
-  amu[16] = amu[15] +  H*m*l/M * acl1 * exp(zacl1 * vterm) * x[4]; //f: C_1c - O
-  amu[17] = amu[16] +  h*L * bcl1 * exp(-zbcl1 * vterm) * x[10]; //b: C_1c - O
-  amu[18] = amu[17] +  h/H * k01 * exp(zk01 * vterm) * calcium[ntimepoint] * x[4]; //f: C_1c - Ca
-  amu[19] = amu[18] +  l/L * 2 * k02 * exp(-zk02 * vterm) * x[6]; //b: C_1c - Ca
+  k[24] =             H*m*pow(l,2)/pow(M,2) * acl1_v; //f: C_2c - O
+  k[25] =             pow(h,2)*pow(L,2) * bcl1_v; //b: C_2c - O
   
-  amu[20] = amu[19] +  pow(l,2) * a1 * exp(za1 * vterm) * x[5]; //f: C_2 - O
-  amu[21] = amu[20] +  pow(L,2) * b1 * exp(-zb1 * vterm) * x[11]; //b: C_2 - O
-  amu[22] = amu[21] +  pow(h,2) * kccl1 * exp(zkccl1 * vterm) * x[0] * x[5]; //f: C_2 - Cl
-  amu[23] = amu[22] +  pow(H,2) * kccl2 * exp(-zkccl2 * vterm) * x[6]; //b: C_2 - Cl
+  k[26] =             k01_v * 2; //f: O - Ca
+  k[27] =             k02_v; //b: O - Ca
+  k[28] =             kocl1_v; //f: O - Cl
+  k[29] =             kocl2_v; //b: O - Cl
   
-  amu[24] = amu[23] +  H*m*pow(l,2)/pow(M,2) * acl1 * exp(zacl1 * vterm) * x[6]; //f: C_2c - O
-  amu[25] = amu[24] +  pow(h,2)*pow(L,2) * bcl1 * exp(-zbcl1 * vterm) * x[12]; //b: C_2c - O
+  k[30] =             m/M * k01_v * 2; //f: O_c - Ca
+  k[31] =             k02_v; //b: O_c - Ca
   
-  amu[26] = amu[25] +  k01 * exp(zk01 * vterm) * 2 * calcium[ntimepoint] * x[7]; //f: O - Ca
-  amu[27] = amu[26] +  k02 * exp(-zk02 * vterm) * x[9]; //b: O - Ca
-  amu[28] = amu[27] +  kocl1 * exp(zkocl1 * vterm) * x[0] * x[7]; //f: O - Cl
-  amu[29] = amu[28] +  kocl2 * exp(-zkocl2 * vterm) * x[8]; //b: O - Cl
+  k[32] =             k01_v; //f: O_1 - Ca
+  k[33] =             2 * k02_v; //b: O_1 - Ca
+  k[34] =             m * kocl1_v; //f: O_1 - Cl
+  k[35] =             M * kocl2_v; //b: O_1 - Cl
   
-  amu[30] = amu[29] +  m/M * k01 * exp(zk01 * vterm) * 2 * calcium[ntimepoint] * x[8]; //f: O_c - Ca
-  amu[31] = amu[30] +  k02 * exp(-zk02 * vterm) * x[10]; //b: O_c - Ca
+  k[36] =             m/M * k01_v; //f: O_1c - Ca
+  k[37] =             2 * k02_v; //b: O_1c - Ca
+  
+  k[38] =             pow(m,2) * kocl1_v; //f: O_2 - Cl
+  k[39] =             pow(M,2) * kocl2_v; //b: O_2 - Cl
+}
+
+// Calcium dependent factors:
+// Tabulates the calcium dependent part of the propensities for every sample of the input signal (one pass over the whole trace before the simulation):
+// CA_j = k[j] * Ca for the calcium binding reactions j.
+enum {
+  CA_2, CA_8, CA_12, CA_18, CA_26, CA_30, CA_32, CA_36,
+  NCAFACTORS
+};
+void AnoModel::calculate_ca_factors(SimulationContext &ctx) {
+  
+  const double *k = ctx.k.data();
+  const double *calcium = ctx.calcium.data();
+  unsigned int nsamples = ctx.calcium.size();
+  ctx.ca_table.assign(nsamples*NCAFACTORS, 0);
+  double *table = ctx.ca_table.data();
+  for (unsigned int t = 0; t < nsamples; t++) {
+    double *factors = table + t*NCAFACTORS;
+    factors[CA_2] = k[2] * calcium[t];
+    factors[CA_8] = k[8] * calcium[t];
+    factors[CA_12] = k[12] * calcium[t];
+    factors[CA_18] = k[18] * calcium[t];
+    factors[CA_26] = k[26] * calcium[t];
+    factors[CA_30] = k[30] * calcium[t];
+    factors[CA_32] = k[32] * calcium[t];
+    factors[CA_36] = k[36] * calcium[t];
+  }
+}
+
+// Propensity calculation:
+// Calculates the propensity of reaction j of the Ano1 model for the particle numbers x
+// (called by the simulation engine for all reactions, or only for the reactions affected by a firing).
+template <typename T>
+inline double AnoModel::propensity(const SimulationContext &ctx, const T *x, unsigned int j) {
   
-  amu[32] = amu[31] +  k01 * exp(zk01 * vterm) * calcium[ntimepoint] * x[9]; //f: O_1 - Ca
-  amu[33] = amu[32] +  2 * k02 * exp(-zk02 * vterm) * x[11]; //b: O_1 - Ca
-  amu[34] = amu[33] +  m * kocl1 * exp(zkocl1 * vterm) * x[0] * x[9]; //f: O_1 - Cl
-  amu[35] = amu[34] +  M * kocl2 * exp(-zkocl2 * vterm) * x[10]; //b: O_1 - Cl
+  // Compiled parameters and calcium dependent factors (of the current input sample) of the context
+  const double *k = ctx.k.data();
+  const double *ca = ctx.ca_table.data() + ctx.ntimepoint*NCAFACTORS;
   
-  amu[36] = amu[35] +  m/M * k01 * exp(zk01 * vterm) * calcium[ntimepoint] * x[10]; //f: O_1c - Ca
-  amu[37] = amu[36] +  2 * k02 * exp(-zk02 * vterm) * x[12]; //b: O_1c - Ca
+  switch (j) {
+    case 0: return k[0] * x[1]; //f: C - O
+    case 1: return k[1] * x[7]; //b: C - O
+    case 2: return ca[CA_2] * x[1]; //f: C - Ca
+    case 3: return k[3] * x[3]; //b: C - Ca
+    case 4: return k[4] * x[0] * x[1]; //f: C - Cl
+    case 5: return k[5] * x[2]; //b: C - Cl
+
+    case 6: return k[6] * x[2]; //f: C_c - O
+    case 7: return k[7] * x[8]; //b: C_c - O
+    case 8: return ca[CA_8] * x[2]; //f: C_c - Ca
+    case 9: return k[9] * x[4]; //b: C_c - Ca
+
+    case 10: return k[10] * x[3]; //f: C_1 - O
+    case 11: return k[11] * x[9]; //b: C_1 - O
+    case 12: return ca[CA_12] * x[3]; //f: C_1 - Ca
+    case 13: return k[13] * x[5]; //b: C_1 - Ca
+    case 14: return k[14] * x[0] * x[3]; //f: C_1 - Cl
+    case 15: return k[15] * x[4]; //b: C_1 - Cl
+
+    case 16: return k[16] * x[4]; //f: C_1c - O
+    case 17: return k[17] * x[10]; //b: C_1c - O
+    case 18: return ca[CA_18] * x[4]; //f: C_1c - Ca
+    case 19: return k[19] * x[6]; //b: C_1c - Ca
+
+    case 20: return k[20] * x[5]; //f: C_2 - O
+    case 21: return k[21] * x[11]; //b: C_2 - O
+    case 22: return k[22] * x[0] * x[5]; //f: C_2 - Cl
+    case 23: return k[23] * x[6]; //b: C_2 - Cl
+
+    case 24: return k[24] * x[6]; //f: C_2c - O
+    case 25: return k[25] * x[12]; //b: C_2c - O
+
+    case 26: return ca[CA_26] * x[7]; //f: O - Ca
+    case 27: return k[27] * x[9]; //b: O - Ca
+    case 28: return k[28] * x[0] * x[7]; //f: O - Cl
+    case 29: return k[29] * x[8]; //b: O - Cl
+
+    case 30: return ca[CA_30] * x[8]; //f: O_c - Ca
+    case 31: return k[31] * x[10]; //b: O_c - Ca
+
+    case 32: return ca[CA_32] * x[9]; //f: O_1 - Ca
+    case 33: return k[33] * x[11]; //b: O_1 - Ca
+    case 34: return k[34] * x[0] * x[9]; //f: O_1 - Cl
+    case 35: return k[35] * x[10]; //b: O_1 - Cl
+
+    case 36: return ca[CA_36] * x[10]; //f: O_1c - Ca
+    case 37: return k[37] * x[12]; //b: O_1c - Ca
+
+    case 38: return k[38] * x[0] * x[11]; //f: O_2 - Cl
+    case 39: return k[39] * x[12]; //b: O_2 - Cl
+  }
+  return 0;
+}
+
+// Propensity derivatives:
+// Partial derivative of the propensity of reaction j by the particle number x[i] of a species it depends on (see get_depM)
+// (analytic Jacobian of the deterministic simulation).
+inline double AnoModel::propensity_derivative(const SimulationContext &ctx, const double *x, unsigned int j, unsigned int i) {
   
-  amu[38] = amu[37] +  pow(m,2) * kocl1 * exp(zkocl1 * vterm) * x[0] * x[11]; //f: O_2 - Cl
-  amu[39] = amu[38] +  pow(M,2) * kocl2 * exp(-zkocl2 * vterm) * x[12]; //b: O_2 - Cl
+  const double *k = ctx.k.data();
+  const double *ca = ctx.ca_table.data() + ctx.ntimepoint*NCAFACTORS;
   
+  switch (j) {
+    // calcium binding
+    case 2: return ca[CA_2];
+    case 8: return ca[CA_8];
+    case 12: return ca[CA_12];
+    case 18: return ca[CA_18];
+    case 26: return ca[CA_26];
+    case 30: return ca[CA_30];
+    case 32: return ca[CA_32];
+    case 36: return ca[CA_36];
+    // Cl_ext (x[0]) binding
+    case 4: return k[4] * (i == 0 ? x[1] : x[0]);
+    case 14: return k[14] * (i == 0 ? x[3] : x[0]);
+    case 22: return k[22] * (i == 0 ? x[5] : x[0]);
+    case 28: return k[28] * (i == 0 ? x[7] : x[0]);
+    case 34: return k[34] * (i == 0 ? x[9] : x[0]);
+    case 38: return k[38] * (i == 0 ? x[11] : x[0]);
+  }
+  // all other reactions are first order in their reactant
+  return k[j];
 }
 
-// Stoichiometric matrix
-NumericMatrix get_stM() {
+// Stoichiometric matrix (declared with the model traits)
+constexpr int AnoModel::stoichiometry[AnoModel::nspecies][AnoModel::nreactions];
+
+// Propensity dependencies:
+// Species (rows, plus a last row for the input calcium signal) on which the propensity of each reaction (columns) depends.
+// Starts from the reactants of every reaction; all other species and calcium entering a propensity are added as modifiers.
+NumericMatrix AnoModel::get_depM() {
   
-  // initialize stoich matrix (with zeroes)
-  NumericMatrix stM(nspecies, nreactions);
-  // create stoich matrix row vectors
-  NumericVector stM_row1 = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row2 = {-1, 1, -1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row3 = {0, 0, 0, 0, 1, -1, -1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row4 = {0, 0, 1, -1, 0, 0, 0, 0, 0, 0, -1, 1, -1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row5 = {0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 1, -1, -1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row6 = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, -1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row7 = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 1, -1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row8 = {1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row9 = {0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row10 = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, -1, 1, -1, 1, 0, 0, 0, 0};
-  NumericVector stM_row11 = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 1, -1, -1, 1, 0, 0};
-  NumericVector stM_row12 = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, -1, 1};
-  NumericVector stM_row13 = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 1, -1};
-  // fill rows of stoich matrix
-  stM(0, _) = stM_row1;
-  stM(1, _) = stM_row2;
-  stM(2, _) = stM_row3;
-  stM(3, _) = stM_row4;
-  stM(4, _) = stM_row5;
-  stM(5, _) = stM_row6;
-  stM(6, _) = stM_row7;
-  stM(7, _) = stM_row8;
-  stM(8, _) = stM_row9;
-  stM(9, _) = stM_row10;
-  stM(10, _) = stM_row11;
-  stM(11, _) = stM_row12;
-  stM(12, _) = stM_row13;
+  NumericMatrix depM = reactant_pattern(stoichiometry_matrix<AnoModel>());
+  // Cl_ext (x[0]) binding
+  int cl_reactions[6] = {4, 14, 22, 28, 34, 38};
+  for (int r = 0; r < 6; r++) {
+    depM(0, cl_reactions[r]) = 1;
+  }
+  // calcium binding
+  int ca_reactions[8] = {2, 8, 12, 18, 26, 30, 32, 36};
+  for (int r = 0; r < 8; r++) {
+    depM(13, ca_reactions[r]) = 1;
+  }
   
-  return stM;  
+  return depM;
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include <vector>
+#include <cmath>
+#include "ode_det.hpp"
+
+
+// Compiled Ano1 model of detSim_ano (deSolve compiled code interface, see ode_det.hpp)
+// State: Cl_ext (constant), C, C_c, C_1, C_1c, C_2, C_2c, O, O_c, O_1, O_1c, O_2, O_2c
+// Parameters: Vm, T, a1, b1, k01, k02, acl1, bcl1, kccl1, kccl2, kocl1, kocl2, za1, zb1, zk01, zk02, zacl1, zbcl1, zkccl1, zkccl2,
+//             zkocl1, zkocl2, l, L, m, M, h, H
+
+static double ano_parms[28];
+static double ano_forcings[1];
+static std::vector<Transition> ano_network;
+
+extern "C" void initmod_ano(void (*odeparms)(int *, double *)) {
+  int n = 28;
+  odeparms(&n, ano_parms);
+  const double *p = ano_parms;
+  double l = p[22], L = p[23], m = p[24], M = p[25], h = p[26], H = p[27];
+  // voltage dependent rate constants (at 293.15 K, as in detSim_ano)
+  double Vterm = 96485.3329*p[0]/(8.3144598*293.15);
+  double a = p[2]*exp(p[12]*Vterm), b = p[3]*exp(-p[13]*Vterm);
+  double k1 = p[4]*exp(p[14]*Vterm), k2 = p[5]*exp(-p[15]*Vterm);
+  double ac = p[6]*exp(p[16]*Vterm), bc = p[7]*exp(-p[17]*Vterm);
+  double kc1 = p[8]*exp(p[18]*Vterm), kc2 = p[9]*exp(-p[19]*Vterm);
+  double ko1 = p[10]*exp(p[20]*Vterm), ko2 = p[11]*exp(-p[21]*Vterm);
+  enum {Cl_ext, C, C_c, C_1, C_1c, C_2, C_2c, O, O_c, O_1, O_1c, O_2, O_2c};
+  const bool Ca = true;
+  ano_network.clear();
+  // channel opening
+  ano_network.push_back(transition(C, O, a, b));
+  ano_network.push_back(transition(C_1, O_1, l*a, L*b));
+  ano_network.push_back(transition(C_2, O_2, l*l*a, L*L*b));
+  ano_network.push_back(transition(C_c, O_c, ac, bc));
+  ano_network.push_back(transition(C_1c, O_1c, H*m*l/M*ac, h*L*bc));
+  ano_network.push_back(transition(C_2c, O_2c, H*m*l*l/(M*M)*ac, h*h*L*L*bc));
+  // calcium binding
+  ano_network.push_back(transition(C, C_1, 2*k1, l/L*k2, Ca));
+  ano_network.push_back(transition(C_1, C_2, k1, l/L*2*k2, Ca));
+  ano_network.push_back(transition(C_c, C_1c, h/H*2*k1, l/L*k2, Ca));
+  ano_network.push_back(transition(C_1c, C_2c, h/H*k1, l/L*2*k2, Ca));
+  ano_network.push_back(transition(O, O_1, 2*k1, k2, Ca));
+  ano_network.push_back(transition(O_1, O_2, k1, 2*k2, Ca));
+  ano_network.push_back(transition(O_c, O_1c, m/M*2*k1, k2, Ca));
+  ano_network.push_back(transition(O_1c, O_2c, m/M*k1, 2*k2, Ca));
+  // chloride binding
+  ano_network.push_back(transition(C, C_c, kc1, kc2, false, Cl_ext));
+  ano_network.push_back(transition(C_1, C_1c, h*kc1, H*kc2, false, Cl_ext));
+  ano_network.push_back(transition(C_2, C_2c, h*h*kc1, H*H*kc2, false, Cl_ext));
+  ano_network.push_back(transition(O, O_c, ko1, ko2, false, Cl_ext));
+  ano_network.push_back(transition(O_1, O_1c, m*ko1, M*ko2, false, Cl_ext));
+  ano_network.push_back(transition(O_2, O_2c, m*m*ko1, M*M*ko2, false, Cl_ext));
+}
+
+extern "C" void initforc_ano(void (*odeforcs)(int *, double *)) {
+  int n = 1;
+  odeforcs(&n, ano_forcings);
+}
+
+extern "C" void derivs_ano(int *neq, double *t, double *y, double *ydot, double *yout, int *ip) {
+  transitions_rhs(ano_network, *neq, ano_forcings[0], y, ydot);
+  if (ip[0] > 0) {
+    yout[0] = ano_forcings[0];
+  }
+}
+
+extern "C" void jac_ano(int *neq, double *t, double *y, int *ml, int *mu, double *pd, int *nrowpd, double *yout, int *ip) {
+  transitions_jacobian(ano_network, *neq, ano_forcings[0], y, pd, *nrowpd);
+}
@@ -5,13 +5,28 @@ using namespace Rcpp;
 
 //********************************/* R EXPORT OPTIONS */********************************
 
-// 1. USER INPUT for new models: Change value of the macro variable MODEL_NAME to the name of the new model.
-#define MODEL_NAME calcineurin
-// include the simulation function with macros (#define statements) that make it model specific (based on MODEL_NAME)
-#include "simulator.cpp"
-// Global variables
-static std::map <std::string, double> prop_params_map;
-// 2. USER INPUT for new models: Change the name of the wrapper function to sim_<MODEL_NAME> and the names of the internally called functions to init_<MODEL_NAME> and simulator_<MODEL_NAME>.
+// include the simulation engine (instantiated for the model traits by the wrapper functions)
+#include "simulator.hpp"
+// 1. USER INPUT for new models: Declare the traits of the new model (see simulator.hpp): its name, the numbers of species and reactions,
+// the stoichiometric matrix and the model specific functions (defined in the MODEL DEFINITION section below).
+struct CalcineurinModel {
+  static std::string name() { return "calcineurin"; }
+  static constexpr int nspecies = 2;
+  static constexpr int nreactions = 2;
+  // Stoichiometric matrix (rows: species, columns: reactions)
+  static constexpr int stoichiometry[nspecies][nreactions] = {
+    {-1, 1},
+    {1, -1}
+  };
+  static List init();
+  static void compile_params(SimulationContext &ctx);
+  static void calculate_ca_factors(SimulationContext &ctx);
+  template <typename T>
+  static double propensity(const SimulationContext &ctx, const T *x, unsigned int j);
+  static double propensity_derivative(const SimulationContext &ctx, const double *x, unsigned int j, unsigned int i);
+  static NumericMatrix get_depM();
+};
+// 2. USER INPUT for new models: Change the name of the wrapper function to sim_<model name> and the model traits in the internally called functions CalcineurinModel::init and simulator<CalcineurinModel>.
 //' Calcineurin Model R Wrapper Function (exported to R)
 //'
 //' This function compares user-supplied parameters to defaults parameter values, overwrites the defaults if neccessary, and calls the internal C++ simulation function for the calcineurin model.
@@ -41,96 +56,144 @@ DataFrame sim_calcineurin(DataFrame user_input_df,
                           List user_sim_params,
                           List user_model_params) {
 
-  // READ INPUT
-  // Provide default model parameters list
-  List default_model_params = init_calcineurin();
-  // Extract default vectors from list
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = CalcineurinModel::init();
   NumericVector default_vols = default_model_params["vols"];
   NumericVector default_init_conc = default_model_params["init_conc"];
   NumericVector default_params = default_model_params["params"];
-  // Extract vectors from user supplied list 
-  // If they exist: definition with the default vector gets overwritten
-  NumericVector user_vols = default_vols;
-  if (user_model_params.containsElementNamed("vols")) {
-      user_vols = user_model_params["vols"];
-  } else {
-    Rcout << "Default volume(s) have been used." << std::endl;
-  } 
-  NumericVector user_init_conc = default_init_conc;
-  if (user_model_params.containsElementNamed("init_conc")) {
-    user_init_conc = user_model_params["init_conc"];
-  } else {
-    Rcout << "Default initial condition(s) have been used." << std::endl;
-  }
-  NumericVector user_params = default_params;
-  if (user_model_params.containsElementNamed("params")) {
-    user_params = user_model_params["params"];
-  } else {
-    Rcout << "Default reaction parameter(s) have been used." << std::endl;
-  }
-  // UPDATE DEFAULTS 
-  // Replace entries in default_model_params with user-supplied values if necessary
-  // 1.) Volumes update:
-  CharacterVector user_vols_names = user_vols.names();
-  for (int i = 0; i < user_vols_names.length(); i++) {
-    std::string current_vol_name = as<std::string>(user_vols_names[i]);
-    if (default_vols.containsElementNamed((current_vol_name).c_str())) {
-      // update default values
-      default_vols[current_vol_name] = user_vols[current_vol_name];    
-    } else {
-      Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
-    }
-  }
-  // 2.) Initial conditions update:
-  CharacterVector user_init_conc_names = user_init_conc.names();
-  for (int i = 0; i < user_init_conc_names.length(); i++) {
-    std::string current_init_conc_name = as<std::string>(user_init_conc_names[i]);
-    if (default_init_conc.containsElementNamed((current_init_conc_name).c_str())) {
-      // update default values
-      default_init_conc[current_init_conc_name] = user_init_conc[current_init_conc_name];    
-    } else {
-      Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
-    }
-  }
-  // 3.) Propensity equation parameters update:
-  CharacterVector user_params_names = user_params.names();
-  for (int i = 0; i < user_params_names.length(); i++) {
-    std::string current_param_name = as<std::string>(user_params_names[i]);
-    if (default_params.containsElementNamed((current_param_name).c_str())) {
-      // update default values
-      default_params[current_param_name] = user_params[current_param_name];    
-    } else {
-      Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
-    }
-  }
-  // Put propensity reaction parameters in a map (for function calculate_amu)
-  // (take parameters from vector "default_params" which contains the updated values)
-  CharacterVector default_params_names = default_params.names();
-  for (int n = 0; n < default_params.length(); n++) {
-    std::string current_param_name = as<std::string>(default_params_names[n]);
-    prop_params_map[current_param_name] = default_params[current_param_name];  
-  }
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
   // RUN SIMULATION
-  // Return result of the included, model-specific copy of the function "simulator" 
-  return simulator_calcineurin(user_input_df,
-                               user_sim_params,
-                               default_vols,
-                               default_init_conc);
+  // Return result of the function "simulator" of the engine, instantiated for the model traits
+  return simulator<CalcineurinModel>(user_input_df,
+                                     user_sim_params,
+                                     default_vols,
+                                     default_init_conc,
+                                     default_params);
    
 }
 
 
 
+//' Calcineurin Model Ensemble R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters with the user-supplied ones (as sim_calcineurin) and simulates n_replicates independent
+//' stochastic replicates of the Calcineurin model on a pool of threads, each replicate with its own stream of the native random number generator.
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "seed" and first "stream" of the random number generator and the "output_species".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters). 
+//' @param n_replicates An integer: the number of replicates.
+//' @param threads An integer: the number of threads (<= 0: all available cores).
+//' @param output_format A string: "long" (data frame of the stacked replicates with a "replicate" column) or "array" (3-D array: output times x columns x replicates).
+//' @return the result of calling the model specific version of the function "ensemble_simulator" 
+//' @examples
+//' sim_ensemble_calcineurin()
+//' @export
+// [[Rcpp::export]]
+RObject sim_ensemble_calcineurin(DataFrame user_input_df,
+                                 List user_sim_params,
+                                 List user_model_params,
+                                 int n_replicates,
+                                 int threads = 1,
+                                 std::string output_format = "long") {
+
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = CalcineurinModel::init();
+  NumericVector default_vols = default_model_params["vols"];
+  NumericVector default_init_conc = default_model_params["init_conc"];
+  NumericVector default_params = default_model_params["params"];
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATIONS
+  return ensemble_simulator<CalcineurinModel>(user_input_df,
+                                              user_sim_params,
+                                              default_vols,
+                                              default_init_conc,
+                                              default_params,
+                                              n_replicates,
+                                              threads,
+                                              output_format);
+}
+
+
+
+//' Calcineurin Model Parameter Sweep R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters with the user-supplied ones (as sim_calcineurin) and simulates the Calcineurin model once for every row of
+//' param_sets on a pool of threads. The column names of param_sets are resolved once against the model's volumes, initial conditions and parameters.
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "seed" and first "stream" of the random number generator and the "output_species".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters). 
+//' @param param_sets A Dataframe (or matrix): one parameter set per row, with columns named like the volumes, initial conditions or parameters to vary (and optionally a per-row "seed").
+//' @param threads An integer: the number of threads (<= 0: all available cores).
+//' @param output A string: "summary" (time average and final value of every species per parameter set) or "trajectory" (stacked trajectories with a "set" column).
+//' @return the result of calling the model specific version of the function "sweep_simulator" 
+//' @examples
+//' sweep_calcineurin()
+//' @export
+// [[Rcpp::export]]
+RObject sweep_calcineurin(DataFrame user_input_df,
+                          List user_sim_params,
+                          List user_model_params,
+                          DataFrame param_sets,
+                          int threads = 1,
+                          std::string output = "summary") {
+
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = CalcineurinModel::init();
+  NumericVector default_vols = default_model_params["vols"];
+  NumericVector default_init_conc = default_model_params["init_conc"];
+  NumericVector default_params = default_model_params["params"];
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATIONS
+  return sweep_simulator<CalcineurinModel>(user_input_df,
+                                           user_sim_params,
+                                           default_vols,
+                                           default_init_conc,
+                                           default_params,
+                                           param_sets,
+                                           threads,
+                                           output);
+}
+
+
+
+//' Calcineurin Model Deterministic R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters with the user-supplied ones (as sim_calcineurin) and integrates the reaction rate equations of the Calcineurin model
+//' natively (deterministic limit of the stochastic model of sim_calcineurin; same output columns as detSim_calcineurin).
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "solver" ("rosenbrock" or "rk45") and its tolerances "rtol" and "atol".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters). 
+//' @return the result of calling the model specific version of the function "det_simulator" 
+//' @examples
+//' detSim_native_calcineurin()
+//' @export
+// [[Rcpp::export]]
+DataFrame detSim_native_calcineurin(DataFrame user_input_df,
+                                    List user_sim_params,
+                                    List user_model_params) {
+
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = CalcineurinModel::init();
+  NumericVector default_vols = default_model_params["vols"];
+  NumericVector default_init_conc = default_model_params["init_conc"];
+  NumericVector default_params = default_model_params["params"];
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATION
+  return det_simulator<CalcineurinModel>(user_input_df,
+                                         user_sim_params,
+                                         default_vols,
+                                         default_init_conc,
+                                         default_params);
+}
+
+
+
 //********************************/* MODEL DEFINITION */********************************
-// 3. USER INPUT for new models: define model parameters, number of species, 
-// number of reactions, propensity equations and update_system function 
+// 3. USER INPUT for new models: define the model specific functions of the traits: model parameters, their compilation into the indexed parameter array,
+// the calcium dependent factors, propensity equations and the species each propensity depends on
 
 // Default model parameters
-List init() {
-  // Model dimensions
-  nspecies = 2;
-  nreactions = 2;
-  
+List CalcineurinModel::init() {
   // Default volume(s)
   NumericVector vols = NumericVector::create(
     _["vol"] = 5e-14
@@ -155,30 +218,85 @@ List init() {
   );
 }
 
+// Indices of the compiled parameters in the context's parameter array k
+enum {
+  P_k_on,
+  P_k_off,
+  P_p,
+  NPARAMS
+};
+
+// Parameter compilation:
+// Resolves the parameter names once per run.
+void CalcineurinModel::compile_params(SimulationContext &ctx) {
+  
+  ctx.k.assign(NPARAMS, 0);
+  double *k = ctx.k.data();
+  k[P_k_on] = prop_param(ctx, "k_on");
+  k[P_k_off] = prop_param(ctx, "k_off");
+  k[P_p] = prop_param(ctx, "p");
+}
+
+// Calcium dependent factors:
+// Tabulates the calcium dependent part of the propensities for every sample of the input signal (one pass over the whole trace before the simulation).
+enum {
+  CA_k_on_p,  // k_on * Ca^p
+  NCAFACTORS
+};
+void CalcineurinModel::calculate_ca_factors(SimulationContext &ctx) {
+  
+  const double *k = ctx.k.data();
+  const double *calcium = ctx.calcium.data();
+  unsigned int nsamples = ctx.calcium.size();
+  ctx.ca_table.assign(nsamples*NCAFACTORS, 0);
+  double *table = ctx.ca_table.data();
+  for (unsigned int t = 0; t < nsamples; t++) {
+    table[t*NCAFACTORS+CA_k_on_p] = k[P_k_on] * pow((double)calcium[t],(double)k[P_p]);
+  }
+}
+
 // Propensity calculation:
-// Calculates the propensities of all Calcineurin model reactions and stores them in the vector amu.
-void calculate_amu() {
+// Calculates the propensity of reaction j of the Calcineurin model for the particle numbers x
+// (called by the simulation engine for all reactions, or only for the reactions affected by a firing).
+template <typename T>
+inline double CalcineurinModel::propensity(const SimulationContext &ctx, const T *x, unsigned int j) {
+  
+  // Compiled parameters and calcium dependent factors (of the current input sample) of the context
+  const double *k = ctx.k.data();
+  const double *ca = ctx.ca_table.data() + ctx.ntimepoint*NCAFACTORS;
+  
+  switch (j) {
+    case 0: return ca[CA_k_on_p] * x[0];
+    case 1: return k[P_k_off] * x[1];
+  }
+  return 0;
+}
+
+// Propensity derivatives:
+// Partial derivative of the propensity of reaction j by the particle number x[i] of a species it depends on (see get_depM)
+// (analytic Jacobian of the deterministic simulation).
+inline double CalcineurinModel::propensity_derivative(const SimulationContext &ctx, const double *x, unsigned int j, unsigned int i) {
   
-  // Look up model parameters in array 'model_params' initially
-  double k_on = prop_params_map["k_on"];
-  double k_off = prop_params_map["k_off"];
-  double p = prop_params_map["p"];  
+  const double *k = ctx.k.data();
+  const double *ca = ctx.ca_table.data() + ctx.ntimepoint*NCAFACTORS;
   
-  amu[0] = k_on * pow((double)calcium[ntimepoint],(double)p) * x[0];
-  amu[1] = amu[0] + k_off * x[1];
+  switch (j) {
+    case 0: return ca[CA_k_on_p];
+    case 1: return k[P_k_off];
+  }
+  return 0;
 }
 
-// Stoichiometric matrix
-NumericMatrix get_stM() {
+// Stoichiometric matrix (declared with the model traits)
+constexpr int CalcineurinModel::stoichiometry[CalcineurinModel::nspecies][CalcineurinModel::nreactions];
+
+// Propensity dependencies:
+// Species (rows, plus a last row for the input calcium signal) on which the propensity of each reaction (columns) depends.
+// Starts from the reactants of every reaction; all other species and calcium entering a propensity are added as modifiers.
+NumericMatrix CalcineurinModel::get_depM() {
   
-  // initialize stoich matrix (with zeroes)
-  NumericMatrix stM(nspecies, nreactions);
-  // create stoich matrix row vectors
-  NumericVector stM_row1 = {-1,  1};
-  NumericVector stM_row2 = { 1, -1};
-  // fill rows of stoich matrix
-  stM(0, _) = stM_row1;
-  stM(1, _) = stM_row2;
+  NumericMatrix depM = reactant_pattern(stoichiometry_matrix<CalcineurinModel>());
+  depM(2, 0) = 1; // calcium
   
-  return stM;  
+  return depM;
 }
\ No newline at end of file
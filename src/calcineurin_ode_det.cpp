@@ -0,0 +1,41 @@
+#include <cmath>
+
+
+// Compiled calcineurin model of detSim_calcineurin (deSolve compiled code interface, see ode_det.hpp)
+// State: Prot_inact, Prot_act
+// Parameters: k_on, k_off, p
+
+static double calcineurin_parms[3];
+static double calcineurin_forcings[1];
+
+extern "C" void initmod_calcineurin(void (*odeparms)(int *, double *)) {
+  int n = 3;
+  odeparms(&n, calcineurin_parms);
+}
+
+extern "C" void initforc_calcineurin(void (*odeforcs)(int *, double *)) {
+  int n = 1;
+  odeforcs(&n, calcineurin_forcings);
+}
+
+// activation rate constant k_on*Ca^p
+static double calcineurin_activation() {
+  return calcineurin_parms[0]*pow(calcineurin_forcings[0], calcineurin_parms[2]);
+}
+
+extern "C" void derivs_calcineurin(int *neq, double *t, double *y, double *ydot, double *yout, int *ip) {
+  double flux = calcineurin_activation()*y[0] - calcineurin_parms[1]*y[1];
+  ydot[0] = -flux;
+  ydot[1] = flux;
+  if (ip[0] > 0) {
+    yout[0] = calcineurin_forcings[0];
+  }
+}
+
+extern "C" void jac_calcineurin(int *neq, double *t, double *y, int *ml, int *mu, double *pd, int *nrowpd, double *yout, int *ip) {
+  double kf = calcineurin_activation(), kb = calcineurin_parms[1];
+  pd[0] = -kf;
+  pd[1] = kf;
+  pd[*nrowpd] = kb;
+  pd[*nrowpd+1] = -kb;
+}
@@ -0,0 +1,47 @@
+#include "calcium_trace.hpp"
+#include <Rcpp.h>
+using namespace Rcpp;
+
+
+//' Read a Calcium Input Trace.
+//'
+//' Parse a calcium trace file natively into an input data frame for the simulators: a binary calcium trace (see write_calcium_trace())
+//' or a whitespace delimited text file as the ".out" files in inst/extdata (a '#' header line "time steps G_alpha PLC Ca", then one line per sample;
+//' the columns "time" and "Ca" of the header, without header the first and the last column).
+//' The simulators can also read the file themselves (user_sim_params "input_file"), without the data frame.
+//' @param file A string: the path of the trace file.
+//' @param ca_factor A number: the calcium values of the file are divided by it (e.g. 6.0221415e14*vol to convert particle numbers to nmol/l).
+//' @return A data frame with the columns "time" [s] and "Ca".
+//' @examples
+//' read_calcium_trace(system.file("extdata", "ca5e-14_2.85_1000_0.05s.out", package = "CalciumModelsLibrary"), 6.0221415e14*5e-14)
+//' @export
+// [[Rcpp::export]]
+DataFrame read_calcium_trace(std::string file, double ca_factor = 1) {
+  SampledSignal time;
+  SampledSignal calcium;
+  load_calcium_trace(file, ca_factor, time, calcium);
+  return DataFrame::create(_["time"] = NumericVector(time.data(), time.data() + time.size()),
+                           _["Ca"] = NumericVector(calcium.data(), calcium.data() + calcium.size()));
+}
+
+//' Write a Binary Calcium Trace.
+//'
+//' Write an input calcium signal in the binary trace format: the 8 bytes "CMLCATR1", the number of samples n (64 bit integer),
+//' then the n observation times and the n calcium concentrations (doubles, native byte order). The simulators use binary traces
+//' memory-mapped (user_sim_params "input_file"), so that large trace libraries are loaded without copies.
+//' @param input_df A data frame: contains the times of the observations (column "time") and the cytosolic calcium concentration [nmol/l] (column "Ca").
+//' @param file A string: the path of the trace file.
+//' @return The number of samples written.
+//' @examples
+//' write_calcium_trace(data.frame(time = c(0, 0.05), Ca = c(0.1, 0.2)), tempfile())
+//' @export
+// [[Rcpp::export]]
+double write_calcium_trace(DataFrame input_df, std::string file) {
+  NumericVector time = input_df["time"];
+  NumericVector calcium = input_df["Ca"];
+  if (time.length() != calcium.length()) {
+    stop("The columns time and Ca must have the same length.");
+  }
+  save_calcium_trace(file, time.begin(), calcium.begin(), time.length());
+  return time.length();
+}
@@ -0,0 +1,230 @@
+#ifndef CALCIUM_TRACE_HPP
+#define CALCIUM_TRACE_HPP
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+// Samples of the input calcium signal (observation times or concentrations): a read-only view of values that are either owned
+// (and shared between the copies of a simulation context) or part of a memory-mapped trace file (zero-copy)
+class SampledSignal {
+public:
+  SampledSignal() : values(NULL), n(0) {}
+  template <typename It>
+  void assign(It begin, It end) {
+    std::vector<double> copy(begin, end);
+    assign(copy);
+  }
+  // take over the values of samples (leaves samples empty)
+  void assign(std::vector<double> &samples) {
+    std::shared_ptr<std::vector<double> > owned = std::make_shared<std::vector<double> >();
+    owned->swap(samples);
+    view(owned, owned->data(), owned->size());
+  }
+  // view n values owned by owner
+  void view(std::shared_ptr<const void> owner, const double *values, size_t n) {
+    this->owner = owner;
+    this->values = values;
+    this->n = n;
+  }
+  const double &operator[](size_t i) const {
+    return values[i];
+  }
+  const double *data() const {
+    return values;
+  }
+  size_t size() const {
+    return n;
+  }
+private:
+  std::shared_ptr<const void> owner;
+  const double *values;
+  size_t n;
+};
+
+
+// Read-only memory mapping of a file (read into memory where mmap is not available)
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path) : bytes(NULL), nbytes(0), mapped(false) {
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        bytes = static_cast<const char *>(p);
+        nbytes = st.st_size;
+        mapped = true;
+      }
+    }
+    close(fd);
+    if (mapped) {
+      return;
+    }
+#endif
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == NULL) {
+      throw std::runtime_error("Cannot open " + path);
+    }
+    char block[65536];
+    size_t n;
+    while ((n = std::fread(block, 1, sizeof(block), file)) > 0) {
+      buffer.insert(buffer.end(), block, block + n);
+    }
+    std::fclose(file);
+    bytes = buffer.data();
+    nbytes = buffer.size();
+  }
+  ~MappedFile() {
+#ifndef _WIN32
+    if (mapped) {
+      munmap(const_cast<char *>(bytes), nbytes);
+    }
+#endif
+  }
+  const char *data() const {
+    return bytes;
+  }
+  size_t size() const {
+    return nbytes;
+  }
+private:
+  MappedFile(const MappedFile &);
+  MappedFile &operator=(const MappedFile &);
+  const char *bytes;
+  size_t nbytes;
+  bool mapped;
+  std::vector<char> buffer;
+};
+
+
+// Binary calcium trace: the 8 bytes "CMLCATR1", the number of samples n (64 bit integer), then the n observation times [s]
+// and the n calcium concentrations (doubles, native byte order). The samples start at byte 16 (aligned), so that the simulations
+// can use a memory-mapped file directly.
+static const char calcium_trace_magic[8] = {'C', 'M', 'L', 'C', 'A', 'T', 'R', '1'};
+
+inline void save_calcium_trace(const std::string &path, const double *time, const double *calcium, size_t n) {
+  FILE *file = std::fopen(path.c_str(), "wb");
+  if (file == NULL) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  long long nsamples = n;
+  bool ok = std::fwrite(calcium_trace_magic, 1, 8, file) == 8 && std::fwrite(&nsamples, sizeof(nsamples), 1, file) == 1 &&
+            std::fwrite(time, sizeof(double), n, file) == n && std::fwrite(calcium, sizeof(double), n, file) == n;
+  ok = std::fclose(file) == 0 && ok;
+  if (!ok) {
+    throw std::runtime_error("Cannot write to " + path);
+  }
+}
+
+// Parse a whitespace delimited trace ('\0' terminated text, e.g. the ".out" files: a '#' header line with the column names
+// "time steps G_alpha PLC Ca", then one line per sample) into the columns "time" and "Ca" of the header
+// (without header: the first and the last column)
+inline void parse_calcium_trace(const char *text, std::vector<double> &time, std::vector<double> &calcium) {
+  int time_column = 0;
+  int ca_column = -1;
+  unsigned int line = 0;
+  std::vector<double> values;
+  while (*text != '\0') {
+    line++;
+    const char *end = std::strchr(text, '\n');
+    if (end == NULL) {
+      end = text + std::strlen(text);
+    }
+    while (text < end && (*text == ' ' || *text == '\t' || *text == '\r')) {
+      text++;
+    }
+    if (text < end && *text == '#') {
+      // header: positions of the columns "time" and "Ca"
+      std::string header(text+1, end);
+      std::vector<std::string> names;
+      size_t pos = 0;
+      while ((pos = header.find_first_not_of(" \t\r", pos)) != std::string::npos) {
+        size_t next = header.find_first_of(" \t\r", pos);
+        names.push_back(header.substr(pos, next == std::string::npos ? std::string::npos : next - pos));
+        pos = next;
+      }
+      for (unsigned int c = 0; c < names.size(); c++) {
+        if (names[c] == "time") {
+          time_column = c;
+        } else if (names[c] == "Ca") {
+          ca_column = c;
+        }
+      }
+    } else if (text < end) {
+      values.clear();
+      while (text < end) {
+        char *next;
+        double value = std::strtod(text, &next);
+        if (next == text) {
+          throw std::runtime_error("Cannot parse line " + std::to_string(line) + " of the calcium trace");
+        }
+        values.push_back(value);
+        text = next;
+        while (text < end && (*text == ' ' || *text == '\t' || *text == '\r')) {
+          text++;
+        }
+      }
+      int ca = ca_column >= 0 ? ca_column : (int)values.size()-1;
+      if (time_column >= (int)values.size() || ca >= (int)values.size()) {
+        throw std::runtime_error("Missing column in line " + std::to_string(line) + " of the calcium trace");
+      }
+      time.push_back(values[time_column]);
+      calcium.push_back(values[ca]);
+    }
+    text = *end == '\n' ? end+1 : end;
+  }
+}
+
+// Load a calcium trace file (binary trace, used memory-mapped, or text as parse_calcium_trace) into the samples of the input signal;
+// the calcium values are divided by ca_factor (e.g. 6.0221415e14*vol for particle numbers)
+inline void load_calcium_trace(const std::string &path, double ca_factor, SampledSignal &time, SampledSignal &calcium) {
+  std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+  if (file->size() >= 16 && std::memcmp(file->data(), calcium_trace_magic, 8) == 0) {
+    long long n;
+    std::memcpy(&n, file->data() + 8, sizeof(n));
+    if (n < 0 || file->size() != 16 + 2*sizeof(double)*(size_t)n) {
+      throw std::runtime_error("Invalid binary calcium trace " + path);
+    }
+    const double *samples = reinterpret_cast<const double *>(file->data() + 16);
+    time.view(file, samples, n);
+    if (ca_factor == 1) {
+      calcium.view(file, samples + n, n);
+    } else {
+      std::vector<double> scaled(samples + n, samples + 2*n);
+      for (size_t i = 0; i < scaled.size(); i++) {
+        scaled[i] /= ca_factor;
+      }
+      calcium.assign(scaled);
+    }
+    return;
+  }
+  std::string text(file->data(), file->size());
+  std::vector<double> t;
+  std::vector<double> ca;
+  parse_calcium_trace(text.c_str(), t, ca);
+  if (ca_factor != 1) {
+    for (size_t i = 0; i < ca.size(); i++) {
+      ca[i] /= ca_factor;
+    }
+  }
+  time.assign(t);
+  calcium.assign(ca);
+}
+
+#endif
@@ -0,0 +1,42 @@
+#include <cmath>
+
+
+// Compiled calmodulin model of detSim_calmodulin (deSolve compiled code interface, see ode_det.hpp)
+// State: Prot_inact, Prot_act
+// Parameters: k_on, k_off, Km, h
+
+static double calmodulin_parms[4];
+static double calmodulin_forcings[1];
+
+extern "C" void initmod_calmodulin(void (*odeparms)(int *, double *)) {
+  int n = 4;
+  odeparms(&n, calmodulin_parms);
+}
+
+extern "C" void initforc_calmodulin(void (*odeforcs)(int *, double *)) {
+  int n = 1;
+  odeforcs(&n, calmodulin_forcings);
+}
+
+// activation rate constant k_on*Ca^h/(Km^h + Ca^h)
+static double calmodulin_activation() {
+  double ca_h = pow(calmodulin_forcings[0], calmodulin_parms[3]);
+  return calmodulin_parms[0]*ca_h/(pow(calmodulin_parms[2], calmodulin_parms[3]) + ca_h);
+}
+
+extern "C" void derivs_calmodulin(int *neq, double *t, double *y, double *ydot, double *yout, int *ip) {
+  double flux = calmodulin_activation()*y[0] - calmodulin_parms[1]*y[1];
+  ydot[0] = -flux;
+  ydot[1] = flux;
+  if (ip[0] > 0) {
+    yout[0] = calmodulin_forcings[0];
+  }
+}
+
+extern "C" void jac_calmodulin(int *neq, double *t, double *y, int *ml, int *mu, double *pd, int *nrowpd, double *yout, int *ip) {
+  double kf = calmodulin_activation(), kb = calmodulin_parms[1];
+  pd[0] = -kf;
+  pd[1] = kf;
+  pd[*nrowpd] = kb;
+  pd[*nrowpd+1] = -kb;
+}
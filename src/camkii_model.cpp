@@ -5,13 +5,31 @@ using namespace Rcpp;
 
 //********************************/* R EXPORT OPTIONS */********************************
 
-// 1. USER INPUT for new models: Change value of the macro variable MODEL_NAME to the name of the new model.
-#define MODEL_NAME camkii
-// include the simulation function with macros (#define statements) that make it model specific (based on MODEL_NAME)
-#include "simulator.cpp"
-// Global variables
-static std::map <std::string, double> prop_params_map;
-// 2. USER INPUT for new models: Change the name of the wrapper function to sim_<MODEL_NAME> and the names of the internally called functions to init_<MODEL_NAME> and simulator_<MODEL_NAME>.
+// include the simulation engine (instantiated for the model traits by the wrapper functions)
+#include "simulator.hpp"
+// 1. USER INPUT for new models: Declare the traits of the new model (see simulator.hpp): its name, the numbers of species and reactions,
+// the stoichiometric matrix and the model specific functions (defined in the MODEL DEFINITION section below).
+struct CamkiiModel {
+  static std::string name() { return "camkii"; }
+  static constexpr int nspecies = 5;
+  static constexpr int nreactions = 10;
+  // Stoichiometric matrix (rows: species, columns: reactions)
+  static constexpr int stoichiometry[nspecies][nreactions] = {
+    {-1, 1, 0, 0, 0, 0, 0, 0, 0, 1},
+    {1, -1, -1, 0, 0, 0, 0, 1, 1, 0},
+    {0, 0, 1, -1, 1, 0, 0, -1, 0, 0},
+    {0, 0, 0, 1, -1, -1, 1, 0, -1, 0},
+    {0, 0, 0, 0, 0, 1, -1, 0, 0, -1}
+  };
+  static List init();
+  static void compile_params(SimulationContext &ctx);
+  static void calculate_ca_factors(SimulationContext &ctx);
+  template <typename T>
+  static double propensity(const SimulationContext &ctx, const T *x, unsigned int j);
+  static double propensity_derivative(const SimulationContext &ctx, const double *x, unsigned int j, unsigned int i);
+  static NumericMatrix get_depM();
+};
+// 2. USER INPUT for new models: Change the name of the wrapper function to sim_<model name> and the model traits in the internally called functions CamkiiModel::init and simulator<CamkiiModel>.
 //' CamKII Model R Wrapper Function (exported to R)
 //'
 //' This function compares user-supplied parameters to defaults parameter values, overwrites the defaults if neccessary, and calls the internal C++ simulation function for the camkii model.
@@ -60,96 +78,144 @@ DataFrame sim_camkii(DataFrame user_input_df,
                      List user_sim_params,
                      List user_model_params) {
 
-  // READ INPUT
-  // Provide default model parameters list
-  List default_model_params = init_camkii();
-  // Extract default vectors from list
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = CamkiiModel::init();
   NumericVector default_vols = default_model_params["vols"];
   NumericVector default_init_conc = default_model_params["init_conc"];
   NumericVector default_params = default_model_params["params"];
-  // Extract vectors from user supplied list 
-  // If they exist: definition with the default vector gets overwritten
-  NumericVector user_vols = default_vols;
-  if (user_model_params.containsElementNamed("vols")) {
-      user_vols = user_model_params["vols"];
-  } else {
-    Rcout << "Default volume(s) have been used." << std::endl;
-  } 
-  NumericVector user_init_conc = default_init_conc;
-  if (user_model_params.containsElementNamed("init_conc")) {
-    user_init_conc = user_model_params["init_conc"];
-  } else {
-    Rcout << "Default initial condition(s) have been used." << std::endl;
-  }
-  NumericVector user_params = default_params;
-  if (user_model_params.containsElementNamed("params")) {
-    user_params = user_model_params["params"];
-  } else {
-    Rcout << "Default reaction parameter(s) have been used." << std::endl;
-  }
-  // UPDATE DEFAULTS 
-  // Replace entries in default_model_params with user-supplied values if necessary
-  // 1.) Volumes update:
-  CharacterVector user_vols_names = user_vols.names();
-  for (int i = 0; i < user_vols_names.length(); i++) {
-    std::string current_vol_name = as<std::string>(user_vols_names[i]);
-    if (default_vols.containsElementNamed((current_vol_name).c_str())) {
-      // update default values
-      default_vols[current_vol_name] = user_vols[current_vol_name];    
-    } else {
-      Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
-    }
-  }
-  // 2.) Initial conditions update:
-  CharacterVector user_init_conc_names = user_init_conc.names();
-  for (int i = 0; i < user_init_conc_names.length(); i++) {
-    std::string current_init_conc_name = as<std::string>(user_init_conc_names[i]);
-    if (default_init_conc.containsElementNamed((current_init_conc_name).c_str())) {
-      // update default values
-      default_init_conc[current_init_conc_name] = user_init_conc[current_init_conc_name];    
-    } else {
-      Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
-    }
-  }
-  // 3.) Propensity equation parameters update:
-  CharacterVector user_params_names = user_params.names();
-  for (int i = 0; i < user_params_names.length(); i++) {
-    std::string current_param_name = as<std::string>(user_params_names[i]);
-    if (default_params.containsElementNamed((current_param_name).c_str())) {
-      // update default values
-      default_params[current_param_name] = user_params[current_param_name];    
-    } else {
-      Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
-    }
-  }
-  // Put propensity reaction parameters in a map (for function calculate_amu)
-  // (take parameters from vector "default_params" which contains the updated values)
-  CharacterVector default_params_names = default_params.names();
-  for (int n = 0; n < default_params.length(); n++) {
-    std::string current_param_name = as<std::string>(default_params_names[n]);
-    prop_params_map[current_param_name] = default_params[current_param_name];  
-  }
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
   // RUN SIMULATION
-  // Return result of the included, model-specific copy of the function "simulator" 
-  return simulator_camkii(user_input_df,
-                          user_sim_params,
-                          default_vols,
-                          default_init_conc);
+  // Return result of the function "simulator" of the engine, instantiated for the model traits
+  return simulator<CamkiiModel>(user_input_df,
+                                user_sim_params,
+                                default_vols,
+                                default_init_conc,
+                                default_params);
    
 }
 
 
 
+//' CamKII Model Ensemble R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters with the user-supplied ones (as sim_camkii) and simulates n_replicates independent
+//' stochastic replicates of the CamKII model on a pool of threads, each replicate with its own stream of the native random number generator.
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "seed" and first "stream" of the random number generator and the "output_species".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters). 
+//' @param n_replicates An integer: the number of replicates.
+//' @param threads An integer: the number of threads (<= 0: all available cores).
+//' @param output_format A string: "long" (data frame of the stacked replicates with a "replicate" column) or "array" (3-D array: output times x columns x replicates).
+//' @return the result of calling the model specific version of the function "ensemble_simulator" 
+//' @examples
+//' sim_ensemble_camkii()
+//' @export
+// [[Rcpp::export]]
+RObject sim_ensemble_camkii(DataFrame user_input_df,
+                            List user_sim_params,
+                            List user_model_params,
+                            int n_replicates,
+                            int threads = 1,
+                            std::string output_format = "long") {
+
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = CamkiiModel::init();
+  NumericVector default_vols = default_model_params["vols"];
+  NumericVector default_init_conc = default_model_params["init_conc"];
+  NumericVector default_params = default_model_params["params"];
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATIONS
+  return ensemble_simulator<CamkiiModel>(user_input_df,
+                                         user_sim_params,
+                                         default_vols,
+                                         default_init_conc,
+                                         default_params,
+                                         n_replicates,
+                                         threads,
+                                         output_format);
+}
+
+
+
+//' CamKII Model Parameter Sweep R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters with the user-supplied ones (as sim_camkii) and simulates the CamKII model once for every row of
+//' param_sets on a pool of threads. The column names of param_sets are resolved once against the model's volumes, initial conditions and parameters.
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "seed" and first "stream" of the random number generator and the "output_species".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters). 
+//' @param param_sets A Dataframe (or matrix): one parameter set per row, with columns named like the volumes, initial conditions or parameters to vary (and optionally a per-row "seed").
+//' @param threads An integer: the number of threads (<= 0: all available cores).
+//' @param output A string: "summary" (time average and final value of every species per parameter set) or "trajectory" (stacked trajectories with a "set" column).
+//' @return the result of calling the model specific version of the function "sweep_simulator" 
+//' @examples
+//' sweep_camkii()
+//' @export
+// [[Rcpp::export]]
+RObject sweep_camkii(DataFrame user_input_df,
+                     List user_sim_params,
+                     List user_model_params,
+                     DataFrame param_sets,
+                     int threads = 1,
+                     std::string output = "summary") {
+
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = CamkiiModel::init();
+  NumericVector default_vols = default_model_params["vols"];
+  NumericVector default_init_conc = default_model_params["init_conc"];
+  NumericVector default_params = default_model_params["params"];
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATIONS
+  return sweep_simulator<CamkiiModel>(user_input_df,
+                                      user_sim_params,
+                                      default_vols,
+                                      default_init_conc,
+                                      default_params,
+                                      param_sets,
+                                      threads,
+                                      output);
+}
+
+
+
+//' CamKII Model Deterministic R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters with the user-supplied ones (as sim_camkii) and integrates the reaction rate equations of the CamKII model
+//' natively (deterministic limit of the stochastic model of sim_camkii; same output columns as detSim_camkii).
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "solver" ("rosenbrock" or "rk45") and its tolerances "rtol" and "atol".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters). 
+//' @return the result of calling the model specific version of the function "det_simulator" 
+//' @examples
+//' detSim_native_camkii()
+//' @export
+// [[Rcpp::export]]
+DataFrame detSim_native_camkii(DataFrame user_input_df,
+                               List user_sim_params,
+                               List user_model_params) {
+
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = CamkiiModel::init();
+  NumericVector default_vols = default_model_params["vols"];
+  NumericVector default_init_conc = default_model_params["init_conc"];
+  NumericVector default_params = default_model_params["params"];
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATION
+  return det_simulator<CamkiiModel>(user_input_df,
+                                    user_sim_params,
+                                    default_vols,
+                                    default_init_conc,
+                                    default_params);
+}
+
+
+
 //********************************/* MODEL DEFINITION */********************************
-// 3. USER INPUT for new models: define model parameters, number of species, 
-// number of reactions, propensity equations and update_system function 
+// 3. USER INPUT for new models: define the model specific functions of the traits: model parameters, their compilation into the indexed parameter array,
+// the calcium dependent factors, propensity equations and the species each propensity depends on
 
 // Default model parameters
-List init() {
-  // Model dimensions
-  nspecies = 5;
-  nreactions = 10;
-  
+List CamkiiModel::init() {
   // Default volume(s)
   NumericVector vols = NumericVector::create(
     _["vol"] = 5e-15
@@ -194,46 +260,97 @@ List init() {
   
 }
 
-// Propensity calculation:
-// Calculates the propensities of all CamKII model reactions and stores them in the vector amu.
-void calculate_amu() {
+// Indices of the compiled parameters in the context's parameter array k
+enum {
+  P_a, P_b, P_c,
+  P_k_IB_camT,  // k_IB * camT
+  P_k_BI, P_k_PT, P_k_TP, P_k_TA, P_k_AT, P_k_AA,
+  P_c_B, P_c_P, P_c_T, P_c_A,
+  P_camT,
+  P_Kd_h,       // Kd^h
+  P_Vm_phos, P_Kd_phos, P_h,
+  NPARAMS
+};
+
+// Parameter compilation:
+// Resolves the parameter names once per run and pre-computes the parameter-only terms (k_IB * camT, Kd^h).
+void CamkiiModel::compile_params(SimulationContext &ctx) {
+  
+  ctx.k.assign(NPARAMS, 0);
+  double *k = ctx.k.data();
+  k[P_a] = prop_param(ctx, "a");
+  k[P_b] = prop_param(ctx, "b");
+  k[P_c] = prop_param(ctx, "c");
+  k[P_k_IB_camT] = prop_param(ctx, "k_IB") * prop_param(ctx, "camT");
+  k[P_k_BI] = prop_param(ctx, "k_BI");
+  k[P_k_PT] = prop_param(ctx, "k_PT");
+  k[P_k_TP] = prop_param(ctx, "k_TP");
+  k[P_k_TA] = prop_param(ctx, "k_TA");
+  k[P_k_AT] = prop_param(ctx, "k_AT");
+  k[P_k_AA] = prop_param(ctx, "k_AA");
+  k[P_c_B] = prop_param(ctx, "c_B");
+  k[P_c_P] = prop_param(ctx, "c_P");
+  k[P_c_T] = prop_param(ctx, "c_T");
+  k[P_c_A] = prop_param(ctx, "c_A");
+  k[P_camT] = prop_param(ctx, "camT");
+  k[P_Kd_h] = pow((double)prop_param(ctx, "Kd"),(double)prop_param(ctx, "h"));
+  k[P_Vm_phos] = prop_param(ctx, "Vm_phos");
+  k[P_Kd_phos] = prop_param(ctx, "Kd_phos");
+  k[P_h] = prop_param(ctx, "h");
+}
+
+// Calcium dependent factors:
+// Tabulates the calcium dependent part of the propensities for every sample of the input signal (one pass over the whole trace before the simulation).
+enum {
+  CA_h,        // Ca^h
+  CA_binding,  // k_IB * camT * Ca^h / (Ca^h + Kd^h)
+  CA_free_cam, // camT - camT * Ca^h / (Ca^h + Kd^h)
+  NCAFACTORS
+};
+void CamkiiModel::calculate_ca_factors(SimulationContext &ctx) {
   
-  // Look up model parameters in array 'model_params' initially
-  double a = prop_params_map["a"];
-  double b = prop_params_map["b"];
-  double c = prop_params_map["c"];
-  double k_IB = prop_params_map["k_IB"];
-  double k_BI = prop_params_map["k_BI"];
-  double k_PT = prop_params_map["k_PT"];
-  double k_TP = prop_params_map["k_TP"];
-  double k_TA = prop_params_map["k_TA"];
-  double k_AT = prop_params_map["k_AT"];
-  double k_AA = prop_params_map["k_AA"];
-  double c_B = prop_params_map["c_B"];
-  double c_P = prop_params_map["c_P"];
-  double c_T = prop_params_map["c_T"];
-  double c_A = prop_params_map["c_A"];
-  double camT = prop_params_map["camT"];
-  double Kd = prop_params_map["Kd"];
-  double Vm_phos = prop_params_map["Vm_phos"];
-  double Kd_phos = prop_params_map["Kd_phos"];
-  double h = prop_params_map["h"];
+  const double *k = ctx.k.data();
+  const double *calcium = ctx.calcium.data();
+  unsigned int nsamples = ctx.calcium.size();
+  ctx.ca_table.assign(nsamples*NCAFACTORS, 0);
+  double *table = ctx.ca_table.data();
+  for (unsigned int t = 0; t < nsamples; t++) {
+    double calcium_h = pow((double)calcium[t],(double)k[P_h]);
+    table[t*NCAFACTORS+CA_h] = calcium_h;
+    table[t*NCAFACTORS+CA_binding] = (k[P_k_IB_camT] * calcium_h) / (calcium_h + k[P_Kd_h]);
+    table[t*NCAFACTORS+CA_free_cam] = k[P_camT] - ((k[P_camT] * calcium_h) / (calcium_h + k[P_Kd_h]));
+  }
+}
+
+// Propensity calculation:
+// Calculates the propensity of reaction j of the CamKII model for the particle numbers x
+// (called by the simulation engine for all reactions, or only for the reactions affected by a firing).
+template <typename T>
+inline double CamkiiModel::propensity(const SimulationContext &ctx, const T *x, unsigned int j) {
   
-  amu[0] = x[0] * ((k_IB * camT * pow((double)calcium[ntimepoint],(double)h)) / (pow((double)calcium[ntimepoint],(double)h) + pow((double)Kd,(double)h)));
-  amu[1] = amu[0] + k_BI * x[1];
+  // Compiled parameters and calcium dependent factors (of the current input sample) of the context
+  const double *k = ctx.k.data();
+  const double *ca = ctx.ca_table.data() + ctx.ntimepoint*NCAFACTORS;
+  double f = ctx.f;
   
   double totalC = x[0] + x[1] + x[2] + x[3] + x[4];
-  double activeSubunits = (x[1] + x[2] + x[3] + x[4]) / (totalC*f);
-  double prob =  a * activeSubunits + b*(pow((double)activeSubunits,(double)2)) + c*(pow((double)activeSubunits,(double)3));
-  amu[2] = amu[1] +  (totalC*f) * k_AA * prob * ((c_B * x[1]) / pow((double)(totalC*f),(double)2)) * (2*c_B*x[1] + c_P*x[2] + c_T*x[3]+ c_A*x[4]);
-  
-  amu[3] = amu[2] + k_PT * x[2];
-  amu[4] = amu[3] + k_TP * x[3] * pow((double)calcium[ntimepoint],(double)h);
-  amu[5] = amu[4] + k_TA * x[3];
-  amu[6] = amu[5] + k_AT * x[4] * (camT - ((camT * pow((double)calcium[ntimepoint],(double)h)) / (pow((double)calcium[ntimepoint],(double)h) + pow((double)Kd,(double)h))));
-  amu[7] = amu[6] + ((Vm_phos * x[2]) / (Kd_phos + (x[2] / (totalC*f))));
-  amu[8] = amu[7] + ((Vm_phos * x[3]) / (Kd_phos + (x[3] / (totalC*f))));
-  amu[9] = amu[8] + ((Vm_phos * x[4]) / (Kd_phos + (x[4] / (totalC*f))));
+  switch (j) {
+    case 0: return x[0] * ca[CA_binding];
+    case 1: return k[P_k_BI] * x[1];
+    case 2: {
+      double activeSubunits = (x[1] + x[2] + x[3] + x[4]) / (totalC*f);
+      double prob =  k[P_a] * activeSubunits + k[P_b]*(pow((double)activeSubunits,(double)2)) + k[P_c]*(pow((double)activeSubunits,(double)3));
+      return (totalC*f) * k[P_k_AA] * prob * ((k[P_c_B] * x[1]) / pow((double)(totalC*f),(double)2)) * (2*k[P_c_B]*x[1] + k[P_c_P]*x[2] + k[P_c_T]*x[3]+ k[P_c_A]*x[4]);
+    }
+    case 3: return k[P_k_PT] * x[2];
+    case 4: return k[P_k_TP] * x[3] * ca[CA_h];
+    case 5: return k[P_k_TA] * x[3];
+    case 6: return k[P_k_AT] * x[4] * ca[CA_free_cam];
+    case 7: return ((k[P_Vm_phos] * x[2]) / (k[P_Kd_phos] + (x[2] / (totalC*f))));
+    case 8: return ((k[P_Vm_phos] * x[3]) / (k[P_Kd_phos] + (x[3] / (totalC*f))));
+    case 9: return ((k[P_Vm_phos] * x[4]) / (k[P_Kd_phos] + (x[4] / (totalC*f))));
+  }
+  return 0;
   
   
   
@@ -258,23 +375,68 @@ void calculate_amu() {
   
 }
 
-// Stoichiometric matrix
-NumericMatrix get_stM() {
+// Propensity derivatives:
+// Partial derivative of the propensity of reaction j by the particle number x[i] of a species it depends on (see get_depM)
+// (analytic Jacobian of the deterministic simulation).
+inline double CamkiiModel::propensity_derivative(const SimulationContext &ctx, const double *x, unsigned int j, unsigned int i) {
   
-  // initialize stoich matrix (with zeroes)
-  NumericMatrix stM(nspecies, nreactions);
-  // create stoich matrix row vectors
-  NumericVector stM_row1 = {-1, 1, 0, 0, 0, 0, 0, 0, 0, 1};
-  NumericVector stM_row2 = {1, -1, -1, 0, 0, 0, 0, 1, 1, 0};
-  NumericVector stM_row3 = {0, 0, 1, -1, 1, 0, 0, -1, 0, 0};
-  NumericVector stM_row4 = {0, 0, 0, 1, -1, -1, 1, 0, -1, 0};
-  NumericVector stM_row5 = {0, 0, 0, 0, 0, 1, -1, 0, 0, -1};
-  // fill rows of stoich matrix
-  stM(0, _) = stM_row1;
-  stM(1, _) = stM_row2;
-  stM(2, _) = stM_row3;
-  stM(3, _) = stM_row4;
-  stM(4, _) = stM_row5;
+  const double *k = ctx.k.data();
+  const double *ca = ctx.ca_table.data() + ctx.ntimepoint*NCAFACTORS;
+  double f = ctx.f;
+  
+  double totalC = x[0] + x[1] + x[2] + x[3] + x[4];
+  switch (j) {
+    case 0: return ca[CA_binding];
+    case 1: return k[P_k_BI];
+    case 2: {
+      // k_AA * c_B * prob(activeSubunits) * G with G = x[1] * (2*c_B*x[1] + c_P*x[2] + c_T*x[3] + c_A*x[4]) / (totalC*f)
+      double c[5] = {0, k[P_c_B], k[P_c_P], k[P_c_T], k[P_c_A]};
+      double activeSubunits = (x[1] + x[2] + x[3] + x[4]) / (totalC*f);
+      double prob = k[P_a]*activeSubunits + k[P_b]*activeSubunits*activeSubunits + k[P_c]*activeSubunits*activeSubunits*activeSubunits;
+      double dprob = k[P_a] + 2*k[P_b]*activeSubunits + 3*k[P_c]*activeSubunits*activeSubunits;
+      double pairs = 2*c[1]*x[1] + c[2]*x[2] + c[3]*x[3] + c[4]*x[4];
+      double G = x[1]*pairs/(totalC*f);
+      double dactive = (x[0]/(totalC*totalC) - (i == 0)/totalC)/f;
+      double dpairs = i == 1 ? 2*c[1] : c[i];
+      double dG = ((i == 1)*pairs + x[1]*dpairs)/(totalC*f) - G/totalC;
+      return k[P_k_AA]*c[1]*(dprob*dactive*G + prob*dG);
+    }
+    case 3: return k[P_k_PT];
+    case 4: return k[P_k_TP] * ca[CA_h];
+    case 5: return k[P_k_TA];
+    case 6: return k[P_k_AT] * ca[CA_free_cam];
+    case 7:
+    case 8:
+    case 9: {
+      // Vm_phos * X / (Kd_phos + X/(totalC*f)) of X = x[j-5]
+      double X = x[j-5];
+      double denominator = k[P_Kd_phos] + X/(totalC*f);
+      return k[P_Vm_phos]*((i == j-5)*k[P_Kd_phos] + X*X/(totalC*totalC*f))/(denominator*denominator);
+    }
+  }
+  return 0;
+}
+
+// Stoichiometric matrix (declared with the model traits)
+constexpr int CamkiiModel::stoichiometry[CamkiiModel::nspecies][CamkiiModel::nreactions];
+
+// Propensity dependencies:
+// Species (rows, plus a last row for the input calcium signal) on which the propensity of each reaction (columns) depends.
+// Starts from the reactants of every reaction; all other species and calcium entering a propensity are added as modifiers.
+NumericMatrix CamkiiModel::get_depM() {
+  
+  NumericMatrix depM = reactant_pattern(stoichiometry_matrix<CamkiiModel>());
+  // phosphorylation (reaction 2) and dephosphorylation (reactions 7-9) depend on all subunit states (total and active subunits)
+  int all_states[4] = {2, 7, 8, 9};
+  for (int r = 0; r < 4; r++) {
+    for (int i = 0; i < 5; i++) {
+      depM(i, all_states[r]) = 1;
+    }
+  }
+  // calcium
+  depM(5, 0) = 1;
+  depM(5, 4) = 1;
+  depM(5, 6) = 1;
   
-  return stM;  
+  return depM;
 }
\ No newline at end of file
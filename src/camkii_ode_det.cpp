@@ -0,0 +1,93 @@
+#include <cmath>
+#include <algorithm>
+
+
+// Compiled CaMKII model of detSim_camkii (deSolve compiled code interface, see ode_det.hpp)
+// State: W_I, W_B, W_P, W_T, W_A
+// Parameters: a, b, c_, k_IB, k_BI, k_PT, k_TP, k_TA, k_AT, k_AA, c_B, c_P, c_T, c_A, camT, Kd, Vm_phos, Kd_phos, h
+
+static double camkii_parms[19];
+static double camkii_forcings[1];
+
+extern "C" void initmod_camkii(void (*odeparms)(int *, double *)) {
+  int n = 19;
+  odeparms(&n, camkii_parms);
+}
+
+extern "C" void initforc_camkii(void (*odeforcs)(int *, double *)) {
+  int n = 1;
+  odeforcs(&n, camkii_forcings);
+}
+
+// Right-hand side (ydot) and, if pd is not NULL, the analytic Jacobian of the CaMKII model
+static void camkii_model(const double *y, double *ydot, double *pd, int nrowpd) {
+  enum {W_I, W_B, W_P, W_T, W_A};
+  const double *p = camkii_parms;
+  double a = p[0], b = p[1], c_ = p[2], k_IB = p[3], k_BI = p[4], k_PT = p[5], k_TP = p[6], k_TA = p[7], k_AT = p[8], k_AA = p[9];
+  double c[5] = {0, p[10], p[11], p[12], p[13]};  // c_B, c_P, c_T, c_A (by species)
+  double camT = p[14], Kd = p[15], Vm_phos = p[16], Kd_phos = p[17], h = p[18];
+  double ca_h = pow(camkii_forcings[0], h);
+  double bound = ca_h/(ca_h + pow(Kd, h));  // fraction of calcium bound calmodulin
+  double binding = k_IB*camT*bound, free_cam = camT - camT*bound;
+  double totalC = y[W_I] + y[W_B] + y[W_P] + y[W_T] + y[W_A];
+  // autophosphorylation: k_AA*prob(activeSubunits)*c_B*W_B*(2*c_B*W_B + c_P*W_P + c_T*W_T + c_A*W_A)/totalC
+  double activeSubunits = (y[W_B] + y[W_P] + y[W_T] + y[W_A])/totalC;
+  double prob = a*activeSubunits + b*activeSubunits*activeSubunits + c_*activeSubunits*activeSubunits*activeSubunits;
+  double pairs = 2*c[W_B]*y[W_B] + c[W_P]*y[W_P] + c[W_T]*y[W_T] + c[W_A]*y[W_A];
+  double autophos = k_AA*prob*c[W_B]*y[W_B]*pairs/totalC;
+  // dephosphorylation: Vm_phos*X/(Kd_phos + X/totalC)
+  double dephos[5];
+  for (int i = W_P; i <= W_A; i++) {
+    dephos[i] = Vm_phos*y[i]/(Kd_phos + y[i]/totalC);
+  }
+  ydot[W_I] = -binding*y[W_I] + k_BI*y[W_B] + dephos[W_A];
+  ydot[W_B] = binding*y[W_I] - k_BI*y[W_B] + dephos[W_P] + dephos[W_T] - autophos;
+  ydot[W_P] = -(k_PT*y[W_P] - k_TP*y[W_T]*ca_h) - dephos[W_P] + autophos;
+  ydot[W_T] = (k_PT*y[W_P] - k_TP*y[W_T]*ca_h) - k_TA*y[W_T] + k_AT*y[W_A]*free_cam - dephos[W_T];
+  ydot[W_A] = k_TA*y[W_T] - k_AT*y[W_A]*free_cam - dephos[W_A];
+  if (pd == NULL) {
+    return;
+  }
+  for (int j = 0; j < 5; j++) {
+    std::fill(pd + j*nrowpd, pd + j*nrowpd + 5, 0.0);
+  }
+  #define J(i, j) pd[(i) + (j)*nrowpd]
+  // first order terms
+  J(W_I, W_I) -= binding;  J(W_B, W_I) += binding;
+  J(W_I, W_B) += k_BI;     J(W_B, W_B) -= k_BI;
+  J(W_P, W_P) -= k_PT;     J(W_T, W_P) += k_PT;
+  J(W_P, W_T) += k_TP*ca_h;  J(W_T, W_T) -= k_TP*ca_h;
+  J(W_T, W_T) -= k_TA;     J(W_A, W_T) += k_TA;
+  J(W_T, W_A) += k_AT*free_cam;  J(W_A, W_A) -= k_AT*free_cam;
+  double dprob = a + 2*b*activeSubunits + 3*c_*activeSubunits*activeSubunits;
+  for (int j = 0; j < 5; j++) {
+    // dephosphorylations W_A -> W_I, W_P -> W_B, W_T -> W_B (every species changes totalC)
+    double ddephos[5];
+    for (int i = W_P; i <= W_A; i++) {
+      double denominator = Kd_phos + y[i]/totalC;
+      ddephos[i] = Vm_phos*((i == j)*Kd_phos + y[i]*y[i]/(totalC*totalC))/(denominator*denominator);
+    }
+    J(W_I, j) += ddephos[W_A];  J(W_A, j) -= ddephos[W_A];
+    J(W_B, j) += ddephos[W_P];  J(W_P, j) -= ddephos[W_P];
+    J(W_B, j) += ddephos[W_T];  J(W_T, j) -= ddephos[W_T];
+    // autophosphorylation W_B -> W_P
+    double dactive = y[W_I]/(totalC*totalC) - (j == W_I)/totalC;
+    double dpairs = j == W_B ? 2*c[W_B] : c[j];
+    double dbp = ((j == W_B)*pairs + y[W_B]*dpairs)/totalC - y[W_B]*pairs/(totalC*totalC);  // d (W_B*pairs/totalC)
+    double dauto = k_AA*c[W_B]*(dprob*dactive*y[W_B]*pairs/totalC + prob*dbp);
+    J(W_B, j) -= dauto;  J(W_P, j) += dauto;
+  }
+  #undef J
+}
+
+extern "C" void derivs_camkii(int *neq, double *t, double *y, double *ydot, double *yout, int *ip) {
+  camkii_model(y, ydot, NULL, 0);
+  if (ip[0] > 0) {
+    yout[0] = camkii_forcings[0];
+  }
+}
+
+extern "C" void jac_camkii(int *neq, double *t, double *y, int *ml, int *mu, double *pd, int *nrowpd, double *yout, int *ip) {
+  double ydot[5];
+  camkii_model(y, ydot, pd, *nrowpd);
+}
@@ -0,0 +1,69 @@
+#ifndef DEPENDENCY_GRAPH_HPP
+#define DEPENDENCY_GRAPH_HPP
+
+#include <vector>
+#include <Rcpp.h>
+#include "sparse_stoichiometry.hpp"
+
+
+// Reaction dependency graph (Gibson & Bruck, "Efficient exact stochastic simulation of chemical systems with many species and many channels", 2000):
+// after reaction j has fired, only the propensities of the reactions reaction[k], k in [offset[j], offset[j+1]) (j itself included) can have changed.
+// Built once per simulation run from the stoichiometry (species changed by a firing) and the model's get_depM() (species each propensity depends on).
+struct DependencyGraph {
+  std::vector<unsigned int> offset;
+  std::vector<unsigned int> reaction;
+  std::vector<unsigned int> calcium_reactions; // reactions whose propensity depends on the input calcium signal
+  std::vector<unsigned int> species_offset;    // species the propensity of reaction j depends on: species[k], k in [species_offset[j], species_offset[j+1])
+  std::vector<unsigned int> species;           // (pattern of the Jacobian of the deterministic simulation)
+};
+
+
+// Propensity dependency matrix initialised with the reactants of every reaction (species with negative stoichiometric coefficients).
+// Rows: species, plus a last row for the input calcium signal; columns: reactions.
+// Models add modifiers (species or calcium entering a propensity without being consumed) to this pattern in their get_depM().
+inline Rcpp::NumericMatrix reactant_pattern(Rcpp::NumericMatrix stM) {
+  Rcpp::NumericMatrix depM(stM.nrow()+1, stM.ncol());
+  for (int j = 0; j < stM.ncol(); j++) {
+    for (int i = 0; i < stM.nrow(); i++) {
+      if (stM(i, j) < 0) {
+        depM(i, j) = 1;
+      }
+    }
+  }
+  return depM;
+}
+
+
+// Compile the dependency graph from the sparse stoichiometry and the propensity dependency matrix
+inline void compile_dependency_graph(const SparseStoichiometry &st, Rcpp::NumericMatrix depM, DependencyGraph &dg) {
+  int nspecies = depM.nrow()-1;
+  int nreactions = depM.ncol();
+  dg.offset.assign(nreactions+1, 0);
+  dg.reaction.clear();
+  dg.calcium_reactions.clear();
+  dg.species_offset.assign(nreactions+1, 0);
+  dg.species.clear();
+  for (int j = 0; j < nreactions; j++) {
+    for (int i = 0; i < nspecies; i++) {
+      if (depM(i, j) != 0) {
+        dg.species.push_back(i);
+      }
+    }
+    dg.species_offset[j+1] = dg.species.size();
+    for (int i = 0; i < nreactions; i++) {
+      bool affected = (i == j);
+      for (unsigned int k = st.offset[j]; !affected && k < st.offset[j+1]; k++) {
+        affected = depM(st.species[k], i) != 0;
+      }
+      if (affected) {
+        dg.reaction.push_back(i);
+      }
+    }
+    dg.offset[j+1] = dg.reaction.size();
+    if (depM(nspecies, j) != 0) {
+      dg.calcium_reactions.push_back(j);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include <cmath>
+
+
+// Compiled glycogen phosphorylase model of detSim_glycphos (deSolve compiled code interface, see ode_det.hpp)
+// State: Prot_inact, Prot_act
+// Parameters: VpM1, VpM2, alpha, gamma_, K11, Kp2, Ka1_conc, Ka2_conc, Ka5_conc, Ka6_conc, gluc_conc
+
+static double glycphos_parms[11];
+static double glycphos_forcings[1];
+
+extern "C" void initmod_glycphos(void (*odeparms)(int *, double *)) {
+  int n = 11;
+  odeparms(&n, glycphos_parms);
+}
+
+extern "C" void initforc_glycphos(void (*odeforcs)(int *, double *)) {
+  int n = 1;
+  odeforcs(&n, glycphos_forcings);
+}
+
+// Maximal rates and Michaelis constants (relative to the total protein) of the phosphorylation (V1, K1) and dephosphorylation (V2, K2)
+static void glycphos_rates(double &V1, double &K1, double &V2, double &K2) {
+  const double *p = glycphos_parms;
+  double ca4 = pow(glycphos_forcings[0], 4);
+  V1 = p[0]/60.0*(1.0 + p[3]*ca4/(pow(p[8], 4) + ca4));
+  K1 = p[4]/(1.0 + ca4/pow(p[9], 4));
+  V2 = p[1]/60.0*(1.0 + p[2]*p[10]/(p[6] + p[10]));
+  K2 = p[5]/(1 + p[10]/p[7]);
+}
+
+// Michaelis-Menten conversion V*(X/total)/(K + X/total)*total of the species X = y[0] or y[1]
+// and its derivatives by X (dx) and by the other species (dother)
+static double glycphos_conversion(double V, double K, double X, double total, double &dx, double &dother) {
+  double denominator = K*total + X;
+  dx = V*(K*total*total + X*X)/(denominator*denominator);
+  dother = V*X*X/(denominator*denominator);
+  return V*X*total/denominator;
+}
+
+extern "C" void derivs_glycphos(int *neq, double *t, double *y, double *ydot, double *yout, int *ip) {
+  double V1, K1, V2, K2, dx, dother;
+  glycphos_rates(V1, K1, V2, K2);
+  double total = y[0] + y[1];
+  double flux = glycphos_conversion(V1, K1, y[0], total, dx, dother) - glycphos_conversion(V2, K2, y[1], total, dx, dother);
+  ydot[0] = -flux;
+  ydot[1] = flux;
+  if (ip[0] > 0) {
+    yout[0] = glycphos_forcings[0];
+  }
+}
+
+extern "C" void jac_glycphos(int *neq, double *t, double *y, int *ml, int *mu, double *pd, int *nrowpd, double *yout, int *ip) {
+  double V1, K1, V2, K2, d1x, d1other, d2x, d2other;
+  glycphos_rates(V1, K1, V2, K2);
+  double total = y[0] + y[1];
+  glycphos_conversion(V1, K1, y[0], total, d1x, d1other);
+  glycphos_conversion(V2, K2, y[1], total, d2x, d2other);
+  // d flux / d Prot_inact and d flux / d Prot_act
+  double dinact = d1x - d2other, dact = d1other - d2x;
+  pd[0] = -dinact;
+  pd[1] = dinact;
+  pd[*nrowpd] = -dact;
+  pd[*nrowpd+1] = dact;
+}
@@ -0,0 +1,35 @@
+#ifndef HYBRID_HPP
+#define HYBRID_HPP
+
+#include <vector>
+#include "sparse_stoichiometry.hpp"
+
+
+// Settings of the hybrid SSA/ODE method
+struct HybridSettings {
+  double threshold;  // a reaction is fast if all species it changes have at least threshold particles ("hybrid_threshold")
+  double rtol;       // relative and ...
+  double atol;       // ... absolute (particles) error tolerance of the ODE integration ("rtol", "atol")
+};
+
+
+// Partition the reactions into fast ones, integrated as ODE (fast[j] = 1), and slow ones, simulated exactly (fast[j] = 0):
+// a reaction with positive propensity becomes fast if all its reactants and products have at least threshold particles,
+// and stays fast until one of them falls below threshold/2 (hysteresis against frequent repartitioning of species close to the threshold).
+// Returns true if the partition has changed.
+inline bool partition_reactions(const SparseStoichiometry &st, const double *y, const std::vector<double> &a, double threshold,
+                                std::vector<char> &fast) {
+  bool changed = false;
+  for (unsigned int j = 0; j < fast.size(); j++) {
+    double limit = fast[j] ? threshold/2 : threshold;
+    char is_fast = a[j] > 0;
+    for (unsigned int k = st.offset[j]; is_fast && k < st.offset[j+1]; k++) {
+      is_fast = y[st.species[k]] >= limit;
+    }
+    changed = changed || is_fast != fast[j];
+    fast[j] = is_fast;
+  }
+  return changed;
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef INDEXED_PRIORITY_QUEUE_HPP
+#define INDEXED_PRIORITY_QUEUE_HPP
+
+#include <vector>
+
+
+// Indexed priority queue of the Next Reaction Method: binary min-heap of the reactions ordered by their putative firing times.
+// pos[i] is the heap position of reaction i, so that the firing time of any reaction can be changed in O(log(no. of reactions)).
+class IndexedPriorityQueue {
+public:
+  // Build the heap from the firing times of all reactions
+  void build(const std::vector<double> &times) {
+    key = times;
+    unsigned int n = key.size();
+    heap.resize(n);
+    pos.resize(n);
+    for (unsigned int i = 0; i < n; i++) {
+      heap[i] = i;
+      pos[i] = i;
+    }
+    for (unsigned int i = n/2; i-- > 0;) {
+      sift_down(i);
+    }
+  }
+
+  // Reaction with the earliest firing time and that time
+  inline unsigned int top() const {
+    return heap[0];
+  }
+  inline double top_time() const {
+    return key[heap[0]];
+  }
+  inline double time(unsigned int i) const {
+    return key[i];
+  }
+
+  // Change the firing time of reaction i
+  inline void update(unsigned int i, double new_time) {
+    double old_time = key[i];
+    key[i] = new_time;
+    if (new_time < old_time) {
+      sift_up(pos[i]);
+    } else {
+      sift_down(pos[i]);
+    }
+  }
+
+private:
+  void sift_up(unsigned int n) {
+    unsigned int i = heap[n];
+    while (n > 0) {
+      unsigned int parent = (n-1)/2;
+      if (key[heap[parent]] <= key[i]) {
+        break;
+      }
+      heap[n] = heap[parent];
+      pos[heap[n]] = n;
+      n = parent;
+    }
+    heap[n] = i;
+    pos[i] = n;
+  }
+
+  void sift_down(unsigned int n) {
+    unsigned int size = heap.size();
+    unsigned int i = heap[n];
+    while (true) {
+      unsigned int child = 2*n+1;
+      if (child >= size) {
+        break;
+      }
+      if (child+1 < size && key[heap[child+1]] < key[heap[child]]) {
+        child++;
+      }
+      if (key[i] <= key[heap[child]]) {
+        break;
+      }
+      heap[n] = heap[child];
+      pos[heap[n]] = n;
+      n = child;
+    }
+    heap[n] = i;
+    pos[i] = n;
+  }
+
+  std::vector<double> key;         // firing time of every reaction
+  std::vector<unsigned int> heap;  // reactions in heap order
+  std::vector<unsigned int> pos;   // heap position of every reaction
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef LANGEVIN_HPP
+#define LANGEVIN_HPP
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include "sparse_stoichiometry.hpp"
+
+
+// Integration schemes of the Chemical Langevin Equation dX = sum_j v_j a_j(X) dt + sum_j v_j sqrt(a_j(X)) dW_j (user_sim_params "cle_scheme")
+enum CleScheme {
+  CLE_EULER,  // "euler": Euler-Maruyama (default)
+  CLE_HEUN    // "heun": predictor-corrector with trapezoidal drift (Kloeden & Platen 15.5), second order in the deterministic limit
+};
+
+// Treatment of negative particle numbers (user_sim_params "cle_boundary")
+enum CleBoundary {
+  CLE_CLAMP,   // "clamp": the extent of a reaction is limited to the available reactants (default)
+  CLE_REFLECT  // "reflect": an extent beyond the available reactants is reflected back
+};
+
+
+// Settings of the Chemical Langevin Equation integrator
+struct CleSettings {
+  CleScheme scheme;
+  CleBoundary boundary;
+  double dt;  // fixed step ("cle_dt"), 0: adaptive step from the leap condition of tau-leaping (bounded relative change of the propensities)
+};
+
+
+// Add the extent r (real valued number of firings, negative if the noise runs the reaction backwards) of reaction j to the particle numbers x.
+// The extent is clamped to or reflected into the range that keeps all reactants (r > 0) and products (r < 0) non-negative;
+// limiting the extents instead of the particle numbers keeps the conservation laws of the network.
+inline void apply_extent(CleBoundary boundary, const SparseStoichiometry &st, unsigned int j, double r, double *x) {
+  double upper = std::numeric_limits<double>::infinity();
+  double lower = -upper;
+  for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+    double v = (double)st.delta[k];
+    double available = std::max(x[st.species[k]], 0.0);
+    if (v < 0) {
+      upper = std::min(upper, available/-v);
+    } else {
+      lower = std::max(lower, -available/v);
+    }
+  }
+  if (boundary == CLE_REFLECT) {
+    if (r > upper) {
+      r = 2*upper - r;
+    }
+    if (r < lower) {
+      r = 2*lower - r;
+    }
+  }
+  r = std::min(std::max(r, lower), upper);
+  for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+    double &xi = x[st.species[k]];
+    xi = std::max(xi + st.delta[k]*r, 0.0);  // (rounding)
+  }
+}
+
+#endif
@@ -0,0 +1,1135 @@
+#ifndef MODEL_IMPORT_HPP
+#define MODEL_IMPORT_HPP
+
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <stdexcept>
+
+
+// Import of reaction networks from SBML Level 3 (and 2) core and COPASI (.cps) files into models defined at runtime (network_model(),
+// reaction_network.hpp): the species changed by reactions, the constant parameters, the stoichiometric matrix and a propensity
+// expression per reaction. The rate laws are converted from concentrations and rates in the units of the model to the particle numbers
+// and propensities [1/s] of the engine; the calcium species is mapped to the input signal ("Ca" [nmol/l]).
+// Reversible reactions are split into a forward and a backward reaction where the rate law is a difference (mass action, "a - b"), so
+// that the stochastic methods see nonnegative propensities. The reactions of the species must take place in a single compartment
+// (the volume of the model); rules, events and initial assignments are not supported.
+
+// Avogadro's constant of the engine (f = 6.0221415e14*vol particles per nmol/l)
+static const double IMPORT_AVOGADRO = 6.0221415e23;
+
+
+/* XML */
+
+// Element of an XML document (names without namespace prefixes)
+struct XmlElement {
+  std::string name;
+  std::vector<std::pair<std::string, std::string> > attributes;
+  std::vector<XmlElement> children;
+  std::string text;   // character data before the first child element
+  std::string tail;   // character data after the element (in its parent)
+
+  bool has_attribute(const std::string &n) const {
+    for (size_t a = 0; a < attributes.size(); a++) {
+      if (attributes[a].first == n) return true;
+    }
+    return false;
+  }
+  std::string attribute(const std::string &n, const std::string &fallback = "") const {
+    for (size_t a = 0; a < attributes.size(); a++) {
+      if (attributes[a].first == n) return attributes[a].second;
+    }
+    return fallback;
+  }
+  const XmlElement *child(const std::string &n) const {
+    for (size_t c = 0; c < children.size(); c++) {
+      if (children[c].name == n) return &children[c];
+    }
+    return NULL;
+  }
+  // elements named n in the child list (e.g. "listOfSpecies", "species"); empty if there is no list
+  std::vector<const XmlElement *> list(const std::string &list_name, const std::string &n) const {
+    std::vector<const XmlElement *> elements;
+    const XmlElement *l = child(list_name);
+    if (l) {
+      for (size_t c = 0; c < l->children.size(); c++) {
+        if (l->children[c].name == n) elements.push_back(&l->children[c]);
+      }
+    }
+    return elements;
+  }
+};
+
+// Non-validating parser of the XML subset of model files: elements, attributes, character data, CDATA sections and
+// character references; comments, processing instructions and the document type declaration are skipped
+class XmlParser {
+public:
+  explicit XmlParser(const std::string &document) : s(document), pos(0) {}
+
+  XmlElement parse() {
+    if (s.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+      pos = 3;
+    }
+    skip_misc();
+    if (pos >= s.size() || s[pos] != '<') {
+      error("no root element");
+    }
+    XmlElement root;
+    parse_element(root);
+    skip_misc();
+    if (pos < s.size()) {
+      error("content after the root element");
+    }
+    return root;
+  }
+
+private:
+  void error(const std::string &message) const {
+    int line = 1;
+    for (size_t i = 0; i < pos && i < s.size(); i++) {
+      if (s[i] == '\n') line++;
+    }
+    throw std::runtime_error("XML: " + message + " (line " + std::to_string(line) + ")");
+  }
+  bool starts(const char *prefix) const {
+    return s.compare(pos, strlen(prefix), prefix) == 0;
+  }
+  void skip_to(const char *end) {
+    size_t found = s.find(end, pos);
+    if (found == std::string::npos) {
+      error(std::string("missing \"") + end + "\"");
+    }
+    pos = found + strlen(end);
+  }
+  void skip_space() {
+    while (pos < s.size() && isspace((unsigned char)s[pos])) pos++;
+  }
+  // comments, processing instructions, document type declaration and white space outside the root element
+  void skip_misc() {
+    for (;;) {
+      skip_space();
+      if (starts("<?")) {
+        skip_to("?>");
+      } else if (starts("<!--")) {
+        skip_to("-->");
+      } else if (starts("<!DOCTYPE")) {
+        int depth = 0;
+        for (; pos < s.size(); pos++) {
+          if (s[pos] == '[') depth++;
+          else if (s[pos] == ']') depth--;
+          else if (s[pos] == '>' && depth == 0) break;
+        }
+        pos++;
+      } else {
+        return;
+      }
+    }
+  }
+  static std::string local_name(const std::string &qualified) {
+    size_t colon = qualified.find(':');
+    return colon == std::string::npos ? qualified : qualified.substr(colon + 1);
+  }
+  std::string parse_name() {
+    size_t begin = pos;
+    while (pos < s.size() && !isspace((unsigned char)s[pos]) && s[pos] != '>' && s[pos] != '/' && s[pos] != '=') pos++;
+    if (pos == begin) {
+      error("missing name");
+    }
+    return s.substr(begin, pos - begin);
+  }
+  // append the character data s[begin, end) with the references resolved
+  void append_text(std::string &out, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (s[i] != '&') {
+        out += s[i];
+        continue;
+      }
+      size_t semicolon = s.find(';', i);
+      if (semicolon == std::string::npos || semicolon >= end) {
+        pos = i;
+        error("unterminated reference");
+      }
+      std::string ref = s.substr(i + 1, semicolon - i - 1);
+      if (ref == "lt") out += '<';
+      else if (ref == "gt") out += '>';
+      else if (ref == "amp") out += '&';
+      else if (ref == "quot") out += '"';
+      else if (ref == "apos") out += '\'';
+      else if (ref.size() > 1 && ref[0] == '#') {
+        unsigned long c = ref[1] == 'x' ? strtoul(ref.c_str() + 2, NULL, 16) : strtoul(ref.c_str() + 1, NULL, 10);
+        // UTF-8 encoding of the code point
+        if (c < 0x80) {
+          out += (char)c;
+        } else if (c < 0x800) {
+          out += (char)(0xC0 | (c >> 6));
+          out += (char)(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+          out += (char)(0xE0 | (c >> 12));
+          out += (char)(0x80 | ((c >> 6) & 0x3F));
+          out += (char)(0x80 | (c & 0x3F));
+        } else {
+          out += (char)(0xF0 | (c >> 18));
+          out += (char)(0x80 | ((c >> 12) & 0x3F));
+          out += (char)(0x80 | ((c >> 6) & 0x3F));
+          out += (char)(0x80 | (c & 0x3F));
+        }
+      } else {
+        pos = i;
+        error("unknown entity \"&" + ref + ";\"");
+      }
+      i = semicolon;
+    }
+  }
+  void parse_element(XmlElement &element) {
+    pos++;  // '<'
+    std::string qualified = parse_name();
+    element.name = local_name(qualified);
+    for (;;) {
+      skip_space();
+      if (pos >= s.size()) {
+        error("unterminated start tag <" + qualified + ">");
+      }
+      if (starts("/>")) {
+        pos += 2;
+        return;
+      }
+      if (s[pos] == '>') {
+        pos++;
+        break;
+      }
+      std::string attribute = parse_name();
+      skip_space();
+      if (pos >= s.size() || s[pos] != '=') {
+        error("missing value of attribute \"" + attribute + "\"");
+      }
+      pos++;
+      skip_space();
+      char quote = pos < s.size() ? s[pos] : 0;
+      if (quote != '"' && quote != '\'') {
+        error("unquoted value of attribute \"" + attribute + "\"");
+      }
+      size_t end = s.find(quote, pos + 1);
+      if (end == std::string::npos) {
+        error("unterminated value of attribute \"" + attribute + "\"");
+      }
+      if (attribute != "xmlns" && attribute.compare(0, 6, "xmlns:") != 0) {
+        std::string value;
+        append_text(value, pos + 1, end);
+        element.attributes.push_back(std::make_pair(local_name(attribute), value));
+      }
+      pos = end + 1;
+    }
+    // content
+    for (;;) {
+      std::string &text = element.children.empty() ? element.text : element.children.back().tail;
+      size_t next = s.find('<', pos);
+      if (next == std::string::npos) {
+        error("missing end tag </" + qualified + ">");
+      }
+      append_text(text, pos, next);
+      pos = next;
+      if (starts("</")) {
+        pos += 2;
+        std::string end_name = parse_name();
+        if (end_name != qualified) {
+          error("end tag </" + end_name + "> does not match <" + qualified + ">");
+        }
+        skip_space();
+        if (pos >= s.size() || s[pos] != '>') {
+          error("unterminated end tag </" + end_name + ">");
+        }
+        pos++;
+        return;
+      } else if (starts("<!--")) {
+        skip_to("-->");
+      } else if (starts("<![CDATA[")) {
+        size_t begin = pos + 9;
+        skip_to("]]>");
+        text.append(s, begin, pos - 3 - begin);
+      } else if (starts("<?")) {
+        skip_to("?>");
+      } else {
+        element.children.push_back(XmlElement());
+        parse_element(element.children.back());
+      }
+    }
+  }
+
+  const std::string &s;
+  size_t pos;
+};
+
+
+
+/* IMPORTED NETWORK */
+
+// Reaction network under construction: species, parameters and reactions of an imported model, named by identifiers that are valid
+// and unique in the propensity expressions (invalid characters replaced by '_', the names of the expression language avoided)
+struct ImportedNetwork {
+  double vol;                                 // [l]
+  std::vector<std::string> species;
+  std::vector<double> init_conc;              // [nmol/l]
+  std::vector<std::string> params;
+  std::vector<double> param_values;
+  std::vector<std::string> reactions;
+  std::vector<std::string> propensities;
+  std::vector<std::map<int, int> > changes;   // stoichiometric coefficients of the species (per reaction)
+  std::vector<std::string> messages;          // notes on the conversion
+
+  ImportedNetwork() : vol(0) {}
+
+  std::string identifier(const std::string &name) {
+    std::string id;
+    for (size_t i = 0; i < name.size(); i++) {
+      char c = name[i];
+      id += (isalnum((unsigned char)c) || c == '_' || c == '.') ? c : '_';
+    }
+    if (id.empty() || isdigit((unsigned char)id[0]) || id[0] == '.') {
+      id = "_" + id;
+    }
+    std::string unique = id;
+    for (int n = 2; used.count(unique) || unique == "Ca" || unique == "f" || unique == "vol" ||
+                    unique == "exp" || unique == "log" || unique == "sqrt"; n++) {
+      unique = id + "_" + std::to_string(n);
+    }
+    used.insert(unique);
+    return unique;
+  }
+  int add_species(const std::string &name, double conc) {
+    species.push_back(identifier(name));
+    init_conc.push_back(conc);
+    return species.size() - 1;
+  }
+  std::string add_param(const std::string &name, double value) {
+    params.push_back(identifier(name));
+    param_values.push_back(value);
+    return params.back();
+  }
+  void add_reaction(const std::string &name, const std::map<int, int> &change, const std::string &propensity) {
+    reactions.push_back(name);
+    changes.push_back(change);
+    propensities.push_back(propensity);
+  }
+  // column-major stoichiometric matrix (species x reactions)
+  std::vector<int> stoichiometry() const {
+    std::vector<int> stM(species.size()*reactions.size(), 0);
+    for (size_t j = 0; j < reactions.size(); j++) {
+      for (std::map<int, int>::const_iterator it = changes[j].begin(); it != changes[j].end(); ++it) {
+        stM[j*species.size() + it->first] = it->second;
+      }
+    }
+    return stM;
+  }
+
+private:
+  std::set<std::string> used;
+};
+
+inline std::string format_number(double value) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.15g", value);
+  if (strtod(buffer, NULL) != value) {
+    snprintf(buffer, sizeof(buffer), "%.17g", value);
+  }
+  return buffer;
+}
+
+inline int integer_stoichiometry(const std::string &value, const std::string &reaction) {
+  double coefficient = value.empty() ? 1 : strtod(value.c_str(), NULL);
+  if (coefficient != floor(coefficient) || fabs(coefficient) > 1e9) {
+    throw std::runtime_error("Reaction \"" + reaction + "\": non-integer stoichiometry " + value);
+  }
+  return (int)coefficient;
+}
+
+// Symbol of a species in the rate laws: its concentration in model units (conc_scale per nmol/l) expressed by its particle number
+inline std::string concentration_symbol(const std::string &id, double conc_scale) {
+  return conc_scale == 1 ? "(" + id + "/f)" : "(" + id + "/f*" + format_number(conc_scale) + ")";
+}
+
+inline std::string calcium_symbol(double conc_scale) {
+  return conc_scale == 1 ? "Ca" : "(Ca*" + format_number(conc_scale) + ")";
+}
+
+
+
+/* INFIX RATE LAWS (COPASI) */
+
+struct InfixToken {
+  enum Kind { NUMBER, NAME, OPERATOR } kind;
+  std::string text;
+};
+
+inline std::vector<InfixToken> tokenize_infix(const std::string &text, const std::string &context) {
+  std::vector<InfixToken> tokens;
+  size_t pos = 0;
+  while (pos < text.size()) {
+    char c = text[pos];
+    InfixToken token;
+    if (isspace((unsigned char)c)) {
+      pos++;
+      continue;
+    } else if (isdigit((unsigned char)c) || (c == '.' && pos + 1 < text.size() && isdigit((unsigned char)text[pos+1]))) {
+      char *end;
+      strtod(text.c_str() + pos, &end);
+      token.kind = InfixToken::NUMBER;
+      token.text = text.substr(pos, end - (text.c_str() + pos));
+      pos += token.text.size();
+    } else if (isalpha((unsigned char)c) || c == '_') {
+      size_t begin = pos;
+      while (pos < text.size() && (isalnum((unsigned char)text[pos]) || text[pos] == '_' || text[pos] == '.')) pos++;
+      token.kind = InfixToken::NAME;
+      token.text = text.substr(begin, pos - begin);
+    } else if (c == '"') {
+      // quoted name
+      token.kind = InfixToken::NAME;
+      for (pos++; pos < text.size() && text[pos] != '"'; pos++) {
+        if (text[pos] == '\\' && pos + 1 < text.size()) pos++;
+        token.text += text[pos];
+      }
+      if (pos >= text.size()) {
+        throw std::runtime_error(context + ": unterminated quoted name in \"" + text + "\"");
+      }
+      pos++;
+    } else if (strchr("+-*/^(),", c)) {
+      token.kind = InfixToken::OPERATOR;
+      token.text = std::string(1, c);
+      pos++;
+    } else {
+      throw std::runtime_error(context + ": unsupported \"" + text.substr(pos, 1) + "\" in \"" + text + "\"");
+    }
+    tokens.push_back(token);
+  }
+  return tokens;
+}
+
+// Split a rate law "a - b" (one binary minus at the top level, not followed by a top-level plus) into a and b
+inline bool split_difference(const std::vector<InfixToken> &tokens, std::vector<InfixToken> &forward, std::vector<InfixToken> &backward) {
+  int depth = 0;
+  size_t minus = 0;
+  int nminus = 0;
+  for (size_t t = 0; t < tokens.size(); t++) {
+    const std::string &op = tokens[t].text;
+    if (tokens[t].kind != InfixToken::OPERATOR) continue;
+    if (op == "(") depth++;
+    else if (op == ")") depth--;
+    else if (depth == 0 && (op == "-" || op == "+") && t > 0 &&
+             (tokens[t-1].kind != InfixToken::OPERATOR || tokens[t-1].text == ")")) {
+      if (op == "-") {
+        minus = t;
+        nminus++;
+      } else if (nminus > 0) {
+        return false;
+      }
+    }
+  }
+  if (nminus != 1) {
+    return false;
+  }
+  forward.assign(tokens.begin(), tokens.begin() + minus);
+  backward.assign(tokens.begin() + minus + 1, tokens.end());
+  return true;
+}
+
+// Rate law text with the names replaced by their symbols (function parameters bound to the model entities)
+inline std::string substitute_infix(const std::vector<InfixToken> &tokens, const std::map<std::string, std::string> &symbols,
+                                    const std::string &context) {
+  std::string out;
+  for (size_t t = 0; t < tokens.size(); t++) {
+    const InfixToken &token = tokens[t];
+    if (token.kind != InfixToken::NAME) {
+      out += token.text;
+      continue;
+    }
+    if (t + 1 < tokens.size() && tokens[t+1].text == "(") {
+      if (token.text == "exp" || token.text == "log" || token.text == "sqrt") {
+        out += token.text;
+      } else if (token.text == "ln") {
+        out += "log";
+      } else {
+        throw std::runtime_error(context + ": unsupported function \"" + token.text + "\"");
+      }
+      continue;
+    }
+    std::map<std::string, std::string>::const_iterator it = symbols.find(token.text);
+    if (it != symbols.end()) {
+      out += it->second;
+    } else if (token.text == "pi" || token.text == "PI") {
+      out += format_number(3.14159265358979323846);
+    } else if (token.text == "exponentiale") {
+      out += format_number(2.71828182845904523536);
+    } else {
+      throw std::runtime_error(context + ": unknown name \"" + token.text + "\"");
+    }
+  }
+  return out;
+}
+
+
+
+/* UNITS */
+
+// Scale of a unit with an SI prefix (e.g. "nmol": 1e-9 of "mol")
+inline bool prefixed_unit(const std::string &unit, const std::string &base, double &scale) {
+  if (unit.size() < base.size() || unit.compare(unit.size() - base.size(), base.size(), base) != 0) {
+    return false;
+  }
+  std::string prefix = unit.substr(0, unit.size() - base.size());
+  static const char *prefixes[] = {"", "m", "\xC2\xB5", "\xCE\xBC", "u", "n", "p", "f", "d", "c", "k"};
+  static const double scales[] = {1, 1e-3, 1e-6, 1e-6, 1e-6, 1e-9, 1e-12, 1e-15, 1e-1, 1e-2, 1e3};
+  for (int p = 0; p < 11; p++) {
+    if (prefix == prefixes[p]) {
+      scale = scales[p];
+      return true;
+    }
+  }
+  return false;
+}
+
+// SBML unit (a predefined kind or a unit definition of the model) in mol, l or s
+inline double sbml_unit_scale(const std::string &unit, const std::map<std::string, const XmlElement *> &definitions) {
+  if (unit.empty() || unit == "mole" || unit == "litre" || unit == "liter" || unit == "second" || unit == "dimensionless") {
+    return 1;
+  } else if (unit == "item") {
+    return 1/IMPORT_AVOGADRO;
+  }
+  std::map<std::string, const XmlElement *>::const_iterator it = definitions.find(unit);
+  if (it == definitions.end() && (unit == "substance" || unit == "volume" || unit == "time")) {
+    return 1;  // Level 2 built-in units (mole, litre, second) unless redefined
+  } else if (it == definitions.end()) {
+    throw std::runtime_error("Unsupported unit \"" + unit + "\"");
+  }
+  double scale = 1;
+  std::vector<const XmlElement *> units = it->second->list("listOfUnits", "unit");
+  for (size_t u = 0; u < units.size(); u++) {
+    std::string kind = units[u]->attribute("kind");
+    double exponent = atof(units[u]->attribute("exponent", "1").c_str());
+    double factor = atof(units[u]->attribute("multiplier", "1").c_str()) * pow(10.0, atof(units[u]->attribute("scale", "0").c_str()));
+    if (kind == "item") {
+      factor /= IMPORT_AVOGADRO;
+    } else if (kind == "metre" || kind == "meter") {
+      factor *= 10;  // dm (metre^3 = 1000 l)
+    } else if (kind != "mole" && kind != "litre" && kind != "liter" && kind != "second" && kind != "dimensionless") {
+      throw std::runtime_error("Unsupported unit kind \"" + kind + "\" of unit \"" + unit + "\"");
+    }
+    scale *= pow(factor, exponent);
+  }
+  return scale;
+}
+
+
+
+/* COPASI */
+
+inline ImportedNetwork import_copasi(const XmlElement &root, const std::string &calcium) {
+  ImportedNetwork network;
+  const XmlElement *model = root.child("Model");
+  if (!model) {
+    throw std::runtime_error("COPASI file without model");
+  }
+  // Units of the model: quantity [mol], volume [l], time [s]
+  std::string quantity_unit = model->attribute("quantityUnit", "mol");
+  std::string volume_unit = model->attribute("volumeUnit", "l");
+  std::string time_unit = model->attribute("timeUnit", "s");
+  double avogadro = atof(model->attribute("avogadroConstant", "6.02214179e23").c_str());
+  double quantity_scale, volume_scale, time_scale;
+  if (quantity_unit == "#") {
+    quantity_scale = 1/avogadro;
+  } else if (!prefixed_unit(quantity_unit, "mol", quantity_scale) && !prefixed_unit(quantity_unit, "Mol", quantity_scale)) {
+    throw std::runtime_error("Unsupported quantity unit \"" + quantity_unit + "\"");
+  }
+  if (volume_unit == "m\xC2\xB3" || volume_unit == "m3") {
+    volume_scale = 1000;
+  } else if (!prefixed_unit(volume_unit, "l", volume_scale)) {
+    throw std::runtime_error("Unsupported volume unit \"" + volume_unit + "\"");
+  }
+  if (time_unit == "min") {
+    time_scale = 60;
+  } else if (time_unit == "h") {
+    time_scale = 3600;
+  } else if (time_unit == "d") {
+    time_scale = 86400;
+  } else if (!prefixed_unit(time_unit, "s", time_scale)) {
+    throw std::runtime_error("Unsupported time unit \"" + time_unit + "\"");
+  }
+  // concentration in model units per nmol/l
+  double conc_scale = 1e-9 * volume_scale / quantity_scale;
+
+  // Initial values: particle numbers of the metabolites, sizes of the compartments and values of the global quantities,
+  // in the order of the state template
+  std::map<std::string, double> initial;
+  const XmlElement *state_template = model->child("StateTemplate");
+  const XmlElement *state = model->child("InitialState");
+  if (!state_template || !state) {
+    throw std::runtime_error("COPASI model without initial state");
+  }
+  std::istringstream values(state->text);
+  for (size_t v = 0; v < state_template->children.size(); v++) {
+    double value;
+    if (!(values >> value)) {
+      throw std::runtime_error("Incomplete initial state of the COPASI model");
+    }
+    initial[state_template->children[v].attribute("objectReference")] = value;
+  }
+
+  // Compartments, metabolites and global quantities
+  std::map<std::string, const XmlElement *> compartments, metabolites, functions;
+  std::vector<const XmlElement *> compartment_list = model->list("ListOfCompartments", "Compartment");
+  for (size_t c = 0; c < compartment_list.size(); c++) {
+    compartments[compartment_list[c]->attribute("key")] = compartment_list[c];
+  }
+  std::vector<const XmlElement *> function_list = root.list("ListOfFunctions", "Function");
+  for (size_t f = 0; f < function_list.size(); f++) {
+    functions[function_list[f]->attribute("key")] = function_list[f];
+  }
+  std::map<std::string, std::string> symbols;   // key -> symbol in the rate laws
+  std::map<std::string, int> species_index;     // key -> species of the network
+  std::string compartment;                      // of the species
+  bool has_calcium = false;
+  std::vector<const XmlElement *> metabolite_list = model->list("ListOfMetabolites", "Metabolite");
+  for (size_t m = 0; m < metabolite_list.size(); m++) {
+    const XmlElement *metabolite = metabolite_list[m];
+    std::string key = metabolite->attribute("key");
+    std::string name = metabolite->attribute("name");
+    std::string type = metabolite->attribute("simulationType");
+    metabolites[key] = metabolite;
+    double size = initial[metabolite->attribute("compartment")];
+    // concentration [nmol/l] of the initial particle number
+    double conc = initial[key] / avogadro / (size * volume_scale) * 1e9;
+    if (name == calcium) {
+      symbols[key] = calcium_symbol(conc_scale);
+      has_calcium = true;
+      if (type != "fixed") {
+        network.messages.push_back("The " + type + " species \"" + name + "\" is replaced by the input calcium signal.");
+      }
+    } else if (type == "reactions") {
+      if (!compartment.empty() && metabolite->attribute("compartment") != compartment) {
+        throw std::runtime_error("The species of the model are in several compartments (only single compartment models are supported).");
+      }
+      compartment = metabolite->attribute("compartment");
+      int i = network.add_species(name, conc);
+      species_index[key] = i;
+      symbols[key] = concentration_symbol(network.species[i], conc_scale);
+    } else if (type == "fixed") {
+      symbols[key] = network.add_param(name, conc * conc_scale);
+    } else {
+      throw std::runtime_error("Species \"" + name + "\": simulation type \"" + type + "\" is not supported.");
+    }
+  }
+  if (network.species.empty()) {
+    throw std::runtime_error("The model has no species changed by reactions.");
+  }
+  if (!has_calcium) {
+    network.messages.push_back("The model has no species \"" + calcium + "\": it does not depend on the input calcium signal.");
+  }
+  network.vol = initial[compartment] * volume_scale;
+  for (size_t c = 0; c < compartment_list.size(); c++) {
+    std::string key = compartment_list[c]->attribute("key");
+    if (key == compartment) {
+      symbols[key] = volume_scale == 1 ? "vol" : "(vol/" + format_number(volume_scale) + ")";
+    }
+  }
+  std::vector<const XmlElement *> value_list = model->list("ListOfModelValues", "ModelValue");
+  for (size_t v = 0; v < value_list.size(); v++) {
+    std::string name = value_list[v]->attribute("name");
+    if (value_list[v]->attribute("simulationType") != "fixed") {
+      throw std::runtime_error("Global quantity \"" + name + "\": simulation type \"" +
+                               value_list[v]->attribute("simulationType") + "\" is not supported.");
+    }
+    symbols[value_list[v]->attribute("key")] = network.add_param(name, initial[value_list[v]->attribute("key")]);
+  }
+
+  // Reactions: the kinetic functions with their parameters bound to the model entities
+  std::vector<const XmlElement *> reaction_list = model->list("ListOfReactions", "Reaction");
+  for (size_t r = 0; r < reaction_list.size(); r++) {
+    const XmlElement *reaction = reaction_list[r];
+    std::string name = reaction->attribute("name");
+    std::string context = "Reaction \"" + name + "\"";
+    std::map<int, int> change;
+    std::vector<const XmlElement *> substrates = reaction->list("ListOfSubstrates", "Substrate");
+    std::vector<const XmlElement *> products = reaction->list("ListOfProducts", "Product");
+    for (size_t s = 0; s < substrates.size(); s++) {
+      std::map<std::string, int>::const_iterator it = species_index.find(substrates[s]->attribute("metabolite"));
+      if (it != species_index.end()) {
+        change[it->second] -= integer_stoichiometry(substrates[s]->attribute("stoichiometry"), name);
+      }
+    }
+    for (size_t p = 0; p < products.size(); p++) {
+      std::map<std::string, int>::const_iterator it = species_index.find(products[p]->attribute("metabolite"));
+      if (it != species_index.end()) {
+        change[it->second] += integer_stoichiometry(products[p]->attribute("stoichiometry"), name);
+      }
+    }
+    // local parameters (added when used)
+    std::map<std::string, const XmlElement *> constants;
+    std::vector<const XmlElement *> constant_list = reaction->list("ListOfConstants", "Constant");
+    for (size_t c = 0; c < constant_list.size(); c++) {
+      constants[constant_list[c]->attribute("key")] = constant_list[c];
+    }
+    const XmlElement *law = reaction->child("KineticLaw");
+    std::map<std::string, const XmlElement *>::const_iterator function_it = law ? functions.find(law->attribute("function")) : functions.end();
+    if (function_it == functions.end()) {
+      throw std::runtime_error(context + " has no kinetic function.");
+    }
+    const XmlElement *function = function_it->second;
+    // symbols of the call parameters (function parameter key -> symbols of its sources)
+    std::map<std::string, std::vector<std::string> > arguments;
+    std::vector<const XmlElement *> calls = law->list("ListOfCallParameters", "CallParameter");
+    for (size_t c = 0; c < calls.size(); c++) {
+      std::vector<std::string> &sources = arguments[calls[c]->attribute("functionParameter")];
+      for (size_t s = 0; s < calls[c]->children.size(); s++) {
+        std::string reference = calls[c]->children[s].attribute("reference");
+        if (!symbols.count(reference)) {
+          std::map<std::string, const XmlElement *>::const_iterator constant = constants.find(reference);
+          if (constant != constants.end()) {
+            symbols[reference] = network.add_param(name + "_" + constant->second->attribute("name"),
+                                                   atof(constant->second->attribute("value").c_str()));
+          } else if (compartments.count(reference)) {
+            symbols[reference] = network.add_param(compartments[reference]->attribute("name"), initial[reference]);
+          } else {
+            throw std::runtime_error(context + ": unknown reference \"" + reference + "\"");
+          }
+        }
+        sources.push_back(symbols[reference]);
+      }
+    }
+    std::vector<const XmlElement *> descriptions = function->list("ListOfParameterDescriptions", "ParameterDescription");
+    bool reversible = reaction->attribute("reversible") == "true";
+    std::vector<std::string> rates;
+    if (function->attribute("type") == "MassAction") {
+      // k1*PRODUCT<substrate_i> (- k2*PRODUCT<product_j>)
+      std::vector<std::string> constants_used, terms;
+      std::vector<std::vector<std::string> > reactants;
+      for (size_t d = 0; d < descriptions.size(); d++) {
+        const std::vector<std::string> &sources = arguments[descriptions[d]->attribute("key")];
+        if (descriptions[d]->attribute("role") == "constant") {
+          if (sources.size() != 1) {
+            throw std::runtime_error(context + ": missing rate constant");
+          }
+          constants_used.push_back(sources[0]);
+        } else {
+          reactants.push_back(sources);
+        }
+      }
+      if (constants_used.size() != reactants.size() || constants_used.empty()) {
+        throw std::runtime_error(context + ": unexpected parameters of the mass action function");
+      }
+      for (size_t t = 0; t < constants_used.size(); t++) {
+        std::string rate = constants_used[t];
+        for (size_t s = 0; s < reactants[t].size(); s++) {
+          rate += "*" + reactants[t][s];
+        }
+        rates.push_back(rate);
+      }
+      if (!reversible) {
+        rates.resize(1);
+      }
+    } else {
+      std::map<std::string, std::string> bound;
+      for (size_t d = 0; d < descriptions.size(); d++) {
+        const std::vector<std::string> &sources = arguments[descriptions[d]->attribute("key")];
+        std::string role = descriptions[d]->attribute("role");
+        if (role == "time") {
+          throw std::runtime_error(context + ": time dependent rate laws are not supported.");
+        } else if (sources.size() != 1) {
+          throw std::runtime_error(context + ": parameter \"" + descriptions[d]->attribute("name") + "\" is not bound to one model entity.");
+        }
+        bound[descriptions[d]->attribute("name")] = sources[0];
+      }
+      const XmlElement *expression = function->child("Expression");
+      std::vector<InfixToken> tokens = tokenize_infix(expression ? expression->text : "", context), forward, backward;
+      if (reversible && split_difference(tokens, forward, backward)) {
+        rates.push_back(substitute_infix(forward, bound, context));
+        rates.push_back(substitute_infix(backward, bound, context));
+      } else {
+        if (reversible) {
+          network.messages.push_back(context + " is reversible with a rate law that is not a difference: its propensity can become negative "
+                                     "(not valid for the stochastic methods).");
+        }
+        rates.push_back(substitute_infix(tokens, bound, context));
+      }
+    }
+    // propensity: rate [model concentration/time] in particles per second
+    std::string scale = conc_scale*time_scale == 1 ? "f*" : "f/" + format_number(conc_scale*time_scale) + "*";
+    network.add_reaction(name, change, scale + "(" + rates[0] + ")");
+    if (rates.size() > 1) {
+      std::map<int, int> reverse;
+      for (std::map<int, int>::const_iterator it = change.begin(); it != change.end(); ++it) {
+        reverse[it->first] = -it->second;
+      }
+      network.add_reaction(name + " (reverse)", reverse, scale + "(" + rates[1] + ")");
+    }
+  }
+  return network;
+}
+
+
+
+/* SBML */
+
+// Infix text of MathML content (symbols: identifiers -> symbols in the rate laws; lambdas: function definitions)
+class MathmlConverter {
+public:
+  MathmlConverter(const std::map<std::string, std::string> &symbols, const std::map<std::string, const XmlElement *> &lambdas,
+                  const std::string &context)
+    : symbols(symbols), lambdas(lambdas), context(context) {}
+
+  std::string convert(const XmlElement &e) const {
+    if (e.name == "ci") {
+      std::string id = trim(e.text);
+      std::map<std::string, std::string>::const_iterator it = symbols.find(id);
+      if (it == symbols.end()) {
+        throw std::runtime_error(context + ": unknown identifier \"" + id + "\"");
+      }
+      return it->second;
+    } else if (e.name == "cn") {
+      std::string type = e.attribute("type", "real");
+      double value;
+      if (type == "e-notation" || type == "rational") {
+        if (e.children.empty()) {
+          throw std::runtime_error(context + ": incomplete number");
+        }
+        double a = atof(e.text.c_str()), b = atof(e.children[0].tail.c_str());
+        value = type == "rational" ? a / b : a * pow(10.0, b);
+      } else {
+        value = atof(trim(e.text).c_str());
+      }
+      return value < 0 ? "(" + format_number(value) + ")" : format_number(value);
+    } else if (e.name == "pi") {
+      return format_number(3.14159265358979323846);
+    } else if (e.name == "exponentiale") {
+      return format_number(2.71828182845904523536);
+    } else if (e.name == "csymbol") {
+      std::string url = e.attribute("definitionURL");
+      if (url.find("avogadro") != std::string::npos) {
+        return format_number(IMPORT_AVOGADRO);
+      }
+      throw std::runtime_error(context + ": unsupported symbol \"" + url + "\"");
+    } else if (e.name == "apply") {
+      return apply(e);
+    } else if (e.name == "semantics" && !e.children.empty()) {
+      return convert(e.children[0]);
+    }
+    throw std::runtime_error(context + ": unsupported MathML element <" + e.name + ">");
+  }
+
+  // forward and backward rate of a rate law "a - b" or "c*(a - b)"
+  bool split_difference(const XmlElement &e, std::string &forward, std::string &backward) const {
+    std::vector<const XmlElement *> args = arguments(e);
+    if (e.name != "apply" || e.children.empty()) {
+      return false;
+    }
+    const std::string &op = e.children[0].name;
+    if (op == "minus" && args.size() == 2) {
+      forward = convert(*args[0]);
+      backward = convert(*args[1]);
+      return true;
+    } else if (op == "times") {
+      int difference = -1;
+      for (size_t a = 0; a < args.size(); a++) {
+        if (args[a]->name == "apply" && !args[a]->children.empty() && args[a]->children[0].name == "minus" && arguments(*args[a]).size() == 2) {
+          if (difference >= 0) return false;
+          difference = a;
+        }
+      }
+      if (difference < 0) {
+        return false;
+      }
+      std::string factor;
+      for (size_t a = 0; a < args.size(); a++) {
+        if ((int)a != difference) factor += convert(*args[a]) + "*";
+      }
+      std::vector<const XmlElement *> terms = arguments(*args[difference]);
+      forward = factor + "(" + convert(*terms[0]) + ")";
+      backward = factor + "(" + convert(*terms[1]) + ")";
+      return true;
+    }
+    return false;
+  }
+
+  // content of a math element (without annotations)
+  static const XmlElement *content(const XmlElement *math) {
+    return math && !math->children.empty() ? &math->children[0] : NULL;
+  }
+
+private:
+  static std::string trim(const std::string &s) {
+    size_t begin = s.find_first_not_of(" \t\r\n"), end = s.find_last_not_of(" \t\r\n");
+    return begin == std::string::npos ? "" : s.substr(begin, end - begin + 1);
+  }
+  // operands of an apply (qualifiers as bvar, degree, logbase excluded)
+  static std::vector<const XmlElement *> arguments(const XmlElement &e) {
+    std::vector<const XmlElement *> args;
+    for (size_t c = 1; c < e.children.size(); c++) {
+      const std::string &n = e.children[c].name;
+      if (n != "degree" && n != "logbase" && n != "bvar") args.push_back(&e.children[c]);
+    }
+    return args;
+  }
+  const XmlElement *qualifier(const XmlElement &e, const char *n) const {
+    const XmlElement *q = e.child(n);
+    return q && !q->children.empty() ? &q->children[0] : NULL;
+  }
+  std::string join(const std::vector<const XmlElement *> &args, const char *op, const char *empty) const {
+    if (args.empty()) {
+      return empty;
+    }
+    std::string out = "(";
+    for (size_t a = 0; a < args.size(); a++) {
+      out += (a ? op : "") + convert(*args[a]);
+    }
+    return out + ")";
+  }
+  std::string apply(const XmlElement &e) const {
+    if (e.children.empty()) {
+      throw std::runtime_error(context + ": empty <apply>");
+    }
+    const XmlElement &head = e.children[0];
+    std::vector<const XmlElement *> args = arguments(e);
+    const std::string &op = head.name;
+    if (op == "plus") {
+      return join(args, "+", "0");
+    } else if (op == "times") {
+      return join(args, "*", "1");
+    } else if (op == "minus" && args.size() == 1) {
+      return "(-" + convert(*args[0]) + ")";
+    } else if ((op == "minus" || op == "divide" || op == "power") && args.size() == 2) {
+      const char *symbol = op == "minus" ? "-" : op == "divide" ? "/" : "^";
+      return "(" + convert(*args[0]) + symbol + convert(*args[1]) + ")";
+    } else if ((op == "exp" || op == "ln") && args.size() == 1) {
+      return std::string(op == "exp" ? "exp" : "log") + "(" + convert(*args[0]) + ")";
+    } else if (op == "log" && args.size() == 1) {
+      const XmlElement *base = qualifier(e, "logbase");
+      return "(log(" + convert(*args[0]) + ")/log(" + (base ? convert(*base) : std::string("10")) + "))";
+    } else if (op == "root" && args.size() == 1) {
+      const XmlElement *degree = qualifier(e, "degree");
+      return degree ? "(" + convert(*args[0]) + "^(1/" + convert(*degree) + "))" : "sqrt(" + convert(*args[0]) + ")";
+    } else if (op == "ci") {
+      // call of a function definition: its body with the bound variables replaced by the arguments
+      std::string id = trim(head.text);
+      std::map<std::string, const XmlElement *>::const_iterator it = lambdas.find(id);
+      if (it == lambdas.end()) {
+        throw std::runtime_error(context + ": unknown function \"" + id + "\"");
+      }
+      const XmlElement *lambda = it->second;
+      std::map<std::string, std::string> bound;
+      const XmlElement *body = NULL;
+      size_t n = 0;
+      for (size_t c = 0; c < lambda->children.size(); c++) {
+        const XmlElement &child = lambda->children[c];
+        if (child.name == "bvar") {
+          if (n >= args.size() || child.children.empty()) {
+            throw std::runtime_error(context + ": wrong number of arguments of function \"" + id + "\"");
+          }
+          bound[trim(child.children[0].text)] = "(" + convert(*args[n++]) + ")";
+        } else {
+          body = &child;
+        }
+      }
+      if (!body || n != args.size()) {
+        throw std::runtime_error(context + ": wrong number of arguments of function \"" + id + "\"");
+      }
+      return "(" + MathmlConverter(bound, lambdas, context).convert(*body) + ")";
+    }
+    throw std::runtime_error(context + ": unsupported MathML operator <" + op + ">");
+  }
+
+  const std::map<std::string, std::string> &symbols;
+  const std::map<std::string, const XmlElement *> &lambdas;
+  std::string context;
+};
+
+inline ImportedNetwork import_sbml(const XmlElement &root, const std::string &calcium) {
+  ImportedNetwork network;
+  int level = atoi(root.attribute("level", "0").c_str());
+  if (level < 2 || level > 3) {
+    throw std::runtime_error("Unsupported SBML level " + root.attribute("level") + " (Level 3 and 2 are supported).");
+  }
+  const XmlElement *model = root.child("model");
+  if (!model) {
+    throw std::runtime_error("SBML file without model");
+  }
+  if (!model->list("listOfRules", "assignmentRule").empty() || !model->list("listOfRules", "rateRule").empty() ||
+      !model->list("listOfRules", "algebraicRule").empty() || !model->list("listOfEvents", "event").empty() ||
+      !model->list("listOfInitialAssignments", "initialAssignment").empty()) {
+    throw std::runtime_error("Rules, events and initial assignments are not supported.");
+  }
+  // Units of the model (Level 3 model attributes; the Level 2 defaults otherwise): substance [mol], volume [l], time [s]
+  std::map<std::string, const XmlElement *> definitions;
+  std::vector<const XmlElement *> definition_list = model->list("listOfUnitDefinitions", "unitDefinition");
+  for (size_t d = 0; d < definition_list.size(); d++) {
+    definitions[definition_list[d]->attribute("id")] = definition_list[d];
+  }
+  double substance_scale = sbml_unit_scale(model->attribute("substanceUnits", level == 2 ? "substance" : ""), definitions);
+  double volume_scale = sbml_unit_scale(model->attribute("volumeUnits", level == 2 ? "volume" : ""), definitions);
+  double time_scale = sbml_unit_scale(model->attribute("timeUnits", level == 2 ? "time" : ""), definitions);
+  double extent_scale = model->has_attribute("extentUnits") ? sbml_unit_scale(model->attribute("extentUnits"), definitions) : substance_scale;
+  // concentration in model units per nmol/l and amount in model units per nmol/l and l
+  double conc_scale = 1e-9 * volume_scale / substance_scale;
+  double amount_scale = 1e-9 / substance_scale;
+
+  std::map<std::string, std::string> symbols;
+  std::map<std::string, const XmlElement *> lambdas;
+  std::vector<const XmlElement *> function_list = model->list("listOfFunctionDefinitions", "functionDefinition");
+  for (size_t f = 0; f < function_list.size(); f++) {
+    const XmlElement *math = function_list[f]->child("math");
+    const XmlElement *lambda = MathmlConverter::content(math);
+    if (!lambda || lambda->name != "lambda") {
+      throw std::runtime_error("Function definition \"" + function_list[f]->attribute("id") + "\" without lambda");
+    }
+    lambdas[function_list[f]->attribute("id")] = lambda;
+  }
+  // Compartments and species
+  std::map<std::string, double> sizes;
+  std::vector<const XmlElement *> compartment_list = model->list("listOfCompartments", "compartment");
+  for (size_t c = 0; c < compartment_list.size(); c++) {
+    if (!compartment_list[c]->has_attribute("size")) {
+      throw std::runtime_error("Compartment \"" + compartment_list[c]->attribute("id") + "\" without size");
+    }
+    sizes[compartment_list[c]->attribute("id")] = atof(compartment_list[c]->attribute("size").c_str());
+  }
+  std::map<std::string, int> species_index;
+  std::string compartment;
+  bool has_calcium = false;
+  std::vector<const XmlElement *> species_list = model->list("listOfSpecies", "species");
+  for (size_t s = 0; s < species_list.size(); s++) {
+    const XmlElement *species = species_list[s];
+    std::string id = species->attribute("id");
+    std::string name = species->attribute("name", id);
+    std::string where = species->attribute("compartment");
+    if (!sizes.count(where)) {
+      throw std::runtime_error("Species \"" + id + "\" in unknown compartment \"" + where + "\"");
+    }
+    double size = sizes[where];
+    bool amount = species->attribute("hasOnlySubstanceUnits") == "true";
+    bool fixed = species->attribute("boundaryCondition") == "true" || species->attribute("constant") == "true";
+    // initial concentration [nmol/l]
+    double conc;
+    if (species->has_attribute("initialConcentration")) {
+      conc = atof(species->attribute("initialConcentration").c_str()) / conc_scale;
+    } else if (species->has_attribute("initialAmount")) {
+      conc = atof(species->attribute("initialAmount").c_str()) / (size * volume_scale) / amount_scale;
+    } else if (id == calcium || name == calcium) {
+      conc = 0;
+    } else {
+      throw std::runtime_error("Species \"" + id + "\" without initial value");
+    }
+    if (id == calcium || name == calcium) {
+      symbols[id] = amount ? "(Ca*" + format_number(amount_scale * size * volume_scale) + ")" : calcium_symbol(conc_scale);
+      has_calcium = true;
+      if (!fixed) {
+        network.messages.push_back("The species \"" + id + "\" is replaced by the input calcium signal.");
+      }
+    } else if (!fixed) {
+      if (!compartment.empty() && where != compartment) {
+        throw std::runtime_error("The species of the model are in several compartments (only single compartment models are supported).");
+      }
+      compartment = where;
+      int i = network.add_species(id, conc);
+      species_index[id] = i;
+      symbols[id] = amount ? "(" + network.species[i] + "/f*vol*" + format_number(amount_scale) + ")" : concentration_symbol(network.species[i], conc_scale);
+    } else {
+      symbols[id] = network.add_param(id, amount ? conc * amount_scale * size * volume_scale : conc * conc_scale);
+    }
+  }
+  if (network.species.empty()) {
+    throw std::runtime_error("The model has no species changed by reactions.");
+  }
+  if (!has_calcium) {
+    network.messages.push_back("The model has no species \"" + calcium + "\": it does not depend on the input calcium signal.");
+  }
+  network.vol = sizes[compartment] * volume_scale;
+  for (size_t c = 0; c < compartment_list.size(); c++) {
+    std::string id = compartment_list[c]->attribute("id");
+    symbols[id] = id == compartment ? (volume_scale == 1 ? "vol" : "(vol/" + format_number(volume_scale) + ")") : network.add_param(id, sizes[id]);
+  }
+  std::vector<const XmlElement *> parameter_list = model->list("listOfParameters", "parameter");
+  for (size_t p = 0; p < parameter_list.size(); p++) {
+    std::string id = parameter_list[p]->attribute("id");
+    if (!parameter_list[p]->has_attribute("value")) {
+      throw std::runtime_error("Parameter \"" + id + "\" without value");
+    }
+    symbols[id] = network.add_param(id, atof(parameter_list[p]->attribute("value").c_str()));
+  }
+
+  // Reactions: kinetic laws [extent/time] in particles per second (f/vol particles per nmol)
+  double rate_scale = 1e9 * extent_scale / time_scale;
+  std::string scale = rate_scale == 1 ? "f/vol*" : "f/vol*" + format_number(rate_scale) + "*";
+  std::vector<const XmlElement *> reaction_list = model->list("listOfReactions", "reaction");
+  for (size_t r = 0; r < reaction_list.size(); r++) {
+    const XmlElement *reaction = reaction_list[r];
+    std::string id = reaction->attribute("id");
+    std::string context = "Reaction \"" + id + "\"";
+    std::map<int, int> change;
+    std::vector<const XmlElement *> reactants = reaction->list("listOfReactants", "speciesReference");
+    std::vector<const XmlElement *> products = reaction->list("listOfProducts", "speciesReference");
+    for (size_t s = 0; s < reactants.size(); s++) {
+      std::map<std::string, int>::const_iterator it = species_index.find(reactants[s]->attribute("species"));
+      if (it != species_index.end()) {
+        change[it->second] -= integer_stoichiometry(reactants[s]->attribute("stoichiometry"), id);
+      }
+    }
+    for (size_t p = 0; p < products.size(); p++) {
+      std::map<std::string, int>::const_iterator it = species_index.find(products[p]->attribute("species"));
+      if (it != species_index.end()) {
+        change[it->second] += integer_stoichiometry(products[p]->attribute("stoichiometry"), id);
+      }
+    }
+    const XmlElement *law = reaction->child("kineticLaw");
+    const XmlElement *math = law ? MathmlConverter::content(law->child("math")) : NULL;
+    if (!math) {
+      throw std::runtime_error(context + " has no kinetic law.");
+    }
+    // local parameters shadow the global identifiers
+    std::map<std::string, std::string> local = symbols;
+    std::vector<const XmlElement *> locals = law->list(level == 3 ? "listOfLocalParameters" : "listOfParameters", level == 3 ? "localParameter" : "parameter");
+    for (size_t p = 0; p < locals.size(); p++) {
+      local[locals[p]->attribute("id")] = network.add_param(id + "_" + locals[p]->attribute("id"), atof(locals[p]->attribute("value").c_str()));
+    }
+    MathmlConverter converter(local, lambdas, context);
+    std::string forward, backward;
+    if (reaction->attribute("reversible", level == 2 ? "true" : "false") == "true" && converter.split_difference(*math, forward, backward)) {
+      network.add_reaction(id, change, scale + "(" + forward + ")");
+      std::map<int, int> reverse;
+      for (std::map<int, int>::const_iterator it = change.begin(); it != change.end(); ++it) {
+        reverse[it->first] = -it->second;
+      }
+      network.add_reaction(id + " (reverse)", reverse, scale + "(" + backward + ")");
+    } else {
+      if (reaction->attribute("reversible", level == 2 ? "true" : "false") == "true") {
+        network.messages.push_back(context + " is reversible with a rate law that is not a difference: its propensity can become negative "
+                                   "(not valid for the stochastic methods).");
+      }
+      network.add_reaction(id, change, scale + "(" + converter.convert(*math) + ")");
+    }
+  }
+  return network;
+}
+
+// Import the reaction network of an SBML or COPASI file (by its root element)
+inline ImportedNetwork import_network(const std::string &file, const std::string &calcium) {
+  std::ifstream in(file.c_str(), std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Cannot open the model file " + file);
+  }
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  std::string document = buffer.str();
+  XmlElement root = XmlParser(document).parse();
+  if (root.name == "sbml") {
+    return import_sbml(root, calcium);
+  } else if (root.name == "COPASI") {
+    return import_copasi(root, calcium);
+  }
+  throw std::runtime_error("Unknown model file format <" + root.name + "> (SBML or COPASI files are supported).");
+}
+
+#endif
@@ -0,0 +1,343 @@
+#include <string>
+#include <Rcpp.h>
+using namespace Rcpp;
+
+
+//********************************/* MODEL TRAITS */********************************
+
+// include the simulation engine (instantiated for the model traits by the wrapper functions)
+#include "simulator.hpp"
+#include "reaction_network.hpp"
+#include "model_import.hpp"
+// Traits of the models defined at runtime: the reaction network of a run is compiled from the model definition (see network_model)
+// and set in the context; the model functions evaluate its bytecode (see reaction_network.hpp)
+struct NetworkModel {
+  static std::string name() { return "network"; }
+  static constexpr int nspecies = DYNAMIC_SIZE;
+  static constexpr int nreactions = DYNAMIC_SIZE;
+
+  static void compile_params(SimulationContext &ctx) {
+    const std::vector<std::string> &names = ctx.network->param_names();
+    std::vector<double> values(names.size());
+    for (unsigned int p = 0; p < names.size(); p++) {
+      values[p] = prop_param(ctx, names[p].c_str());
+    }
+    ctx.network->compile_params(values, ctx.f, ctx.vol, ctx.k);
+  }
+  static void calculate_ca_factors(SimulationContext &ctx) {
+    ctx.network->calculate_ca_factors(ctx.calcium.data(), ctx.calcium.size(), ctx.k, ctx.ca_table);
+  }
+  template <typename T>
+  static double propensity(const SimulationContext &ctx, const T *x, unsigned int j) {
+    const ReactionNetwork &network = *ctx.network;
+    return network.propensity(x, j, ctx.k.data(), ctx.ca_table.data() + (size_t)ctx.ntimepoint*network.ca_factor_count());
+  }
+  static double propensity_derivative(const SimulationContext &ctx, const double *x, unsigned int j, unsigned int i) {
+    const ReactionNetwork &network = *ctx.network;
+    return network.propensity_derivative(x, j, i, ctx.k.data(), ctx.ca_table.data() + (size_t)ctx.ntimepoint*network.ca_factor_count());
+  }
+};
+
+// Stoichiometric matrix and propensity dependencies of the reaction network of the context
+template <>
+NumericMatrix model_stoichiometry<NetworkModel>(const SimulationContext &ctx) {
+  const ReactionNetwork &network = *ctx.network;
+  NumericMatrix stM(network.species_count(), network.reaction_count());
+  for (int i = 0; i < network.species_count(); i++) {
+    for (int j = 0; j < network.reaction_count(); j++) {
+      stM(i, j) = network.stoichiometric_coefficient(i, j);
+    }
+  }
+  return stM;
+}
+
+template <>
+NumericMatrix model_dependencies<NetworkModel>(const SimulationContext &ctx) {
+  const ReactionNetwork &network = *ctx.network;
+  NumericMatrix depM(network.species_count()+1, network.reaction_count());
+  for (int i = 0; i <= network.species_count(); i++) {
+    for (int j = 0; j < network.reaction_count(); j++) {
+      depM(i, j) = network.depends_on(i, j);
+    }
+  }
+  return depM;
+}
+
+// Compile the reaction network of a model definition (see network_model) and copy its default volumes, initial conditions and parameters
+// (the copies are updated with the user-supplied values, the model definition remains unchanged)
+static std::shared_ptr<const ReactionNetwork> compile_network(List model,
+                                                              NumericVector &default_vols,
+                                                              NumericVector &default_init_conc,
+                                                              NumericVector &default_params) {
+  const char *elements[5] = {"vols", "init_conc", "params", "stoichiometry", "propensities"};
+  for (int e = 0; e < 5; e++) {
+    if (!model.containsElementNamed(elements[e])) {
+      stop(std::string("The model definition has no element \"") + elements[e] + "\" (see network_model()).");
+    }
+  }
+  default_vols = clone(as<NumericVector>(model["vols"]));
+  default_init_conc = clone(as<NumericVector>(model["init_conc"]));
+  default_params = clone(as<NumericVector>(model["params"]));
+  NumericMatrix stM = model["stoichiometry"];
+  CharacterVector propensity_strings = model["propensities"];
+  CharacterVector species_names = default_init_conc.names();
+  CharacterVector param_names = default_params.names();
+  if (stM.nrow() != default_init_conc.length() || stM.ncol() != propensity_strings.length()) {
+    stop("The stoichiometric matrix must have one row per species (initial condition) and one column per reaction (propensity).");
+  }
+  std::vector<std::string> species(default_init_conc.length());
+  for (int i = 0; i < default_init_conc.length(); i++) {
+    species[i] = as<std::string>(species_names[i]);
+  }
+  std::vector<std::string> params(default_params.length());
+  for (int p = 0; p < default_params.length(); p++) {
+    params[p] = as<std::string>(param_names[p]);
+  }
+  std::vector<int> stoichiometry((size_t)stM.nrow()*stM.ncol());
+  for (int j = 0; j < stM.ncol(); j++) {
+    for (int i = 0; i < stM.nrow(); i++) {
+      double coefficient = stM(i, j);
+      if (coefficient != floor(coefficient) || fabs(coefficient) > 1e9) {
+        stop("The stoichiometric coefficients must be integers.");
+      }
+      stoichiometry[(size_t)j*stM.nrow() + i] = (int)coefficient;
+    }
+  }
+  std::vector<std::string> propensities(propensity_strings.length());
+  for (int j = 0; j < propensity_strings.length(); j++) {
+    propensities[j] = as<std::string>(propensity_strings[j]);
+  }
+  try {
+    return std::make_shared<ReactionNetwork>(species, params, stoichiometry, propensities);
+  } catch (const std::runtime_error &error) {
+    stop(error.what());
+  }
+  return std::shared_ptr<const ReactionNetwork>();
+}
+
+
+
+//********************************/* R EXPORT OPTIONS */********************************
+
+//' Reaction Network Model Definition
+//'
+//' Define a model at runtime, without writing and compiling a C++ model file: its species, parameters, stoichiometric matrix and the
+//' propensity of every reaction. The definition is checked and compiled here, and compiled again by every simulation with it
+//' (sim_network(), sim_ensemble_network(), sweep_network(), detSim_native_network()); the compilation takes microseconds.
+//' The propensity expressions [1/s] are written in terms of the species (particle numbers), the parameters, the calcium concentration "Ca" [nmol/l],
+//' the particles per concentration unit "f" (6.0221415e14*vol) and the volume "vol" [l], with the operators + - * / ^, parentheses and the functions
+//' exp, log and sqrt (e.g. "k_on*Ca^h/(Km^h + Ca^h)*Prot_inact" or "k2/f*A*B" for a second order reaction).
+//' The parts of an expression that depend only on the parameters are evaluated once per simulation, the ones that depend on the
+//' parameters and calcium once per sample of the input signal; the rest is compiled into a register bytecode evaluated in the simulation loop.
+//' @param init_conc A named numeric vector: the species and their default initial concentrations [nmol/l].
+//' @param params A named numeric vector: the default values of the propensity equation parameters.
+//' @param stoichiometry A numeric matrix: the integer stoichiometric coefficients (one row per species in the order of init_conc, one column per reaction).
+//' @param propensities A character vector: the propensity expression of every reaction.
+//' @param vol A number: the default volume [l].
+//' @return The model definition: a list of the default volumes ("vols"), initial conditions ("init_conc") and parameters ("params"),
+//'         the "stoichiometry" and the "propensities" (the parameter names of user_model_params of the simulation functions as for the compiled models).
+//' @examples
+//' model <- network_model(init_conc = c(Prot_inact = 5, Prot_act = 0),
+//'                        params = c(k_on = 0.025, k_off = 0.005, Km = 1, h = 4),
+//'                        stoichiometry = matrix(c(-1, 1, 1, -1), nrow = 2),
+//'                        propensities = c("k_on*Ca^h/(Km^h + Ca^h)*Prot_inact", "k_off*Prot_act"),
+//'                        vol = 5e-14)
+//' @export
+// [[Rcpp::export]]
+List network_model(NumericVector init_conc,
+                   NumericVector params,
+                   NumericMatrix stoichiometry,
+                   CharacterVector propensities,
+                   double vol = 1e-15) {
+  List model = List::create(
+    _["vols"] = NumericVector::create(_["vol"] = vol),
+    _["init_conc"] = init_conc,
+    _["params"] = params,
+    _["stoichiometry"] = stoichiometry,
+    _["propensities"] = propensities
+  );
+  NumericVector default_vols, default_init_conc, default_params;
+  compile_network(model, default_vols, default_init_conc, default_params);
+  return model;
+}
+
+//' Import a Reaction Network Model from SBML or COPASI.
+//'
+//' Read the reaction network of an SBML (Level 3 or 2 core) or COPASI (.cps) file as a model definition for the simulation functions of
+//' network_model(): the species changed by reactions (initial concentrations in nmol/l), the global and the used local parameters (in the units
+//' of the model; local parameters named <reaction>_<parameter>, constant species as parameters holding their concentration), the stoichiometric
+//' matrix and the propensities converted from the kinetic laws. The calcium species is mapped to the input signal of the simulations ("Ca" in nmol/l),
+//' whatever its role in the file. Reversible reactions with a rate law "a - b" (e.g. mass action) become a forward and a backward reaction.
+//' The species must be in a single compartment (its size is the volume of the model); rules, events, initial assignments and time dependent
+//' rate laws are not supported. Notes on the conversion are printed.
+//' @param file A string: the path of the SBML or COPASI file.
+//' @param calcium A string: the name (or SBML id) of the species that is replaced by the input calcium signal.
+//' @return The model definition (see network_model()); the propensities are named by the reactions.
+//' @examples
+//' \dontrun{
+//' model <- import_network_model("material/dupont_camkii.cps")
+//' }
+//' @export
+// [[Rcpp::export]]
+List import_network_model(std::string file, std::string calcium = "Ca") {
+  ImportedNetwork imported;
+  try {
+    imported = import_network(file, calcium);
+  } catch (const std::runtime_error &error) {
+    stop(error.what());
+  }
+  for (unsigned int m = 0; m < imported.messages.size(); m++) {
+    Rcout << imported.messages[m] << std::endl;
+  }
+  NumericVector init_conc(imported.init_conc.begin(), imported.init_conc.end());
+  init_conc.names() = CharacterVector(imported.species.begin(), imported.species.end());
+  NumericVector params(imported.param_values.begin(), imported.param_values.end());
+  params.names() = CharacterVector(imported.params.begin(), imported.params.end());
+  std::vector<int> stoichiometry = imported.stoichiometry();
+  NumericMatrix stM(imported.species.size(), imported.reactions.size(), stoichiometry.begin());
+  CharacterVector propensities(imported.propensities.begin(), imported.propensities.end());
+  propensities.names() = CharacterVector(imported.reactions.begin(), imported.reactions.end());
+  return network_model(init_conc, params, stM, propensities, imported.vol);
+}
+
+//' Reaction Network Model R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters of a model defined at runtime (see network_model()) with the user-supplied ones
+//' (as the wrapper functions of the compiled models, e.g. sim_pkc()) and simulates it with the stochastic simulation methods of simulator().
+//' @param model A List: the model definition (see network_model()).
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep") and the settings of simulator().
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters).
+//' @return the result of calling the function "simulator" for the model
+//' @examples
+//' sim_network()
+//' @export
+// [[Rcpp::export]]
+DataFrame sim_network(List model,
+                      DataFrame user_input_df,
+                      List user_sim_params,
+                      List user_model_params) {
+
+  // Compile the model and update its default parameters with the user-supplied values
+  NumericVector default_vols, default_init_conc, default_params;
+  std::shared_ptr<const ReactionNetwork> network = compile_network(model, default_vols, default_init_conc, default_params);
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATION
+  return simulator<NetworkModel>(user_input_df,
+                                 user_sim_params,
+                                 default_vols,
+                                 default_init_conc,
+                                 default_params,
+                                 network);
+}
+
+//' Reaction Network Model Ensemble R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters of a model defined at runtime (see network_model()) with the user-supplied ones and simulates
+//' n_replicates independent realisations of it on a pool of threads (as sim_ensemble_pkc()).
+//' @param model A List: the model definition (see network_model()).
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "seed" and first "stream" of the random number generator and the "output_species".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters).
+//' @param n_replicates An integer: the number of replicates.
+//' @param threads An integer: the number of threads (<= 0: all available cores).
+//' @param output_format A string: "long" (data frame of the stacked replicates with a "replicate" column) or "array" (3-D array: output times x columns x replicates).
+//' @return the result of calling the function "ensemble_simulator" for the model
+//' @examples
+//' sim_ensemble_network()
+//' @export
+// [[Rcpp::export]]
+RObject sim_ensemble_network(List model,
+                             DataFrame user_input_df,
+                             List user_sim_params,
+                             List user_model_params,
+                             int n_replicates,
+                             int threads = 1,
+                             std::string output_format = "long") {
+
+  // Compile the model and update its default parameters with the user-supplied values
+  NumericVector default_vols, default_init_conc, default_params;
+  std::shared_ptr<const ReactionNetwork> network = compile_network(model, default_vols, default_init_conc, default_params);
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATIONS
+  return ensemble_simulator<NetworkModel>(user_input_df,
+                                          user_sim_params,
+                                          default_vols,
+                                          default_init_conc,
+                                          default_params,
+                                          n_replicates,
+                                          threads,
+                                          output_format,
+                                          network);
+}
+
+//' Reaction Network Model Parameter Sweep R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters of a model defined at runtime (see network_model()) with the user-supplied ones and simulates it
+//' once for every row of param_sets on a pool of threads (as sweep_pkc()).
+//' @param model A List: the model definition (see network_model()).
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "seed" and first "stream" of the random number generator and the "output_species".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters).
+//' @param param_sets A Dataframe (or matrix): one parameter set per row, with columns named like the volumes, initial conditions or parameters to vary (and optionally a per-row "seed").
+//' @param threads An integer: the number of threads (<= 0: all available cores).
+//' @param output A string: "summary" (time average and final value of every species per parameter set) or "trajectory" (stacked trajectories with a "set" column).
+//' @return the result of calling the function "sweep_simulator" for the model
+//' @examples
+//' sweep_network()
+//' @export
+// [[Rcpp::export]]
+RObject sweep_network(List model,
+                      DataFrame user_input_df,
+                      List user_sim_params,
+                      List user_model_params,
+                      DataFrame param_sets,
+                      int threads = 1,
+                      std::string output = "summary") {
+
+  // Compile the model and update its default parameters with the user-supplied values
+  NumericVector default_vols, default_init_conc, default_params;
+  std::shared_ptr<const ReactionNetwork> network = compile_network(model, default_vols, default_init_conc, default_params);
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATIONS
+  return sweep_simulator<NetworkModel>(user_input_df,
+                                       user_sim_params,
+                                       default_vols,
+                                       default_init_conc,
+                                       default_params,
+                                       param_sets,
+                                       threads,
+                                       output,
+                                       network);
+}
+
+//' Reaction Network Model Deterministic R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters of a model defined at runtime (see network_model()) with the user-supplied ones and integrates
+//' its reaction rate equations natively (as detSim_native_pkc(); the Jacobian is derived symbolically from the propensity expressions).
+//' @param model A List: the model definition (see network_model()).
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "solver" ("rosenbrock" or "rk45") and its tolerances "rtol" and "atol".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters).
+//' @return the result of calling the function "det_simulator" for the model
+//' @examples
+//' detSim_native_network()
+//' @export
+// [[Rcpp::export]]
+DataFrame detSim_native_network(List model,
+                                DataFrame user_input_df,
+                                List user_sim_params,
+                                List user_model_params) {
+
+  // Compile the model and update its default parameters with the user-supplied values
+  NumericVector default_vols, default_init_conc, default_params;
+  std::shared_ptr<const ReactionNetwork> network = compile_network(model, default_vols, default_init_conc, default_params);
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATION
+  return det_simulator<NetworkModel>(user_input_df,
+                                     user_sim_params,
+                                     default_vols,
+                                     default_init_conc,
+                                     default_params,
+                                     network);
+}
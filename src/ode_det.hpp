@@ -0,0 +1,73 @@
+#ifndef ODE_DET_HPP
+#define ODE_DET_HPP
+
+#include <vector>
+#include <algorithm>
+
+
+// Compiled models of the deterministic simulations (R/*_ode_det.R) for deSolve's compiled code interface
+// (lsoda(..., dllname = "CalciumModelsLibrary", initfunc = "initmod_<model>", func = "derivs_<model>", jacfunc = "jac_<model>",
+//  initforc = "initforc_<model>", forcings = <time, Ca>)).
+// Every model defines, with C linkage:
+//   void initmod_<model>(void (*odeparms)(int *, double *))    copies the ODE parameters (in the order of the R default parameters)
+//   void initforc_<model>(void (*odeforcs)(int *, double *))   connects the calcium forcing
+//   void derivs_<model>(int *neq, double *t, double *y, double *ydot, double *yout, int *ip)
+//   void jac_<model>(int *neq, double *t, double *y, int *ml, int *mu, double *pd, int *nrowpd, double *yout, int *ip)
+// The state vector holds the species of the R default initial conditions (without calcium), the only output variable (yout[0])
+// is the calcium forcing. The routines are registered in ode_det_registration.cpp.
+
+
+// Reversible first order transition from -> to of a network of conformational states:
+// flux = kf*g*y[from] - kb*y[to] with g = 1, the calcium concentration (calcium) or the species factor (y[factor] if factor >= 0)
+struct Transition {
+  int from;
+  int to;
+  double kf;
+  double kb;
+  bool calcium;
+  int factor;
+};
+
+inline Transition transition(int from, int to, double kf, double kb, bool calcium = false, int factor = -1) {
+  Transition tr = {from, to, kf, kb, calcium, factor};
+  return tr;
+}
+
+// Right-hand side of a transition network
+inline void transitions_rhs(const std::vector<Transition> &network, int neq, double ca, const double *y, double *ydot) {
+  std::fill(ydot, ydot+neq, 0.0);
+  for (unsigned int r = 0; r < network.size(); r++) {
+    const Transition &tr = network[r];
+    double g = tr.calcium ? ca : 1.0;
+    if (tr.factor >= 0) {
+      g *= y[tr.factor];
+    }
+    double flux = tr.kf*g*y[tr.from] - tr.kb*y[tr.to];
+    ydot[tr.from] -= flux;
+    ydot[tr.to] += flux;
+  }
+}
+
+// Analytic Jacobian of a transition network (pd: column-major with leading dimension nrowpd, pd[i + j*nrowpd] = d ydot_i / d y_j)
+inline void transitions_jacobian(const std::vector<Transition> &network, int neq, double ca, const double *y, double *pd, int nrowpd) {
+  for (int j = 0; j < neq; j++) {
+    std::fill(pd + j*nrowpd, pd + j*nrowpd + neq, 0.0);
+  }
+  for (unsigned int r = 0; r < network.size(); r++) {
+    const Transition &tr = network[r];
+    double g = tr.calcium ? ca : 1.0;
+    double forward = tr.kf*g;
+    if (tr.factor >= 0) {
+      double dfactor = forward*y[tr.from];
+      pd[tr.from + tr.factor*nrowpd] -= dfactor;
+      pd[tr.to + tr.factor*nrowpd] += dfactor;
+      forward *= y[tr.factor];
+    }
+    pd[tr.from + tr.from*nrowpd] -= forward;
+    pd[tr.to + tr.from*nrowpd] += forward;
+    pd[tr.from + tr.to*nrowpd] += tr.kb;
+    pd[tr.to + tr.to*nrowpd] -= tr.kb;
+  }
+}
+
+#endif
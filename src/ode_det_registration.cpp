@@ -0,0 +1,43 @@
+#include <Rcpp.h>
+#include <R_ext/Rdynload.h>
+
+
+// Registration of the compiled deterministic models (see ode_det.hpp), so that deSolve finds them by name
+// (lsoda(..., dllname = "CalciumModelsLibrary")) although the package disables the dynamic symbol lookup
+
+#define ODE_DET_MODEL(model) \
+  extern "C" void initmod_##model(void (*)(int *, double *)); \
+  extern "C" void initforc_##model(void (*)(int *, double *)); \
+  extern "C" void derivs_##model(int *, double *, double *, double *, double *, int *); \
+  extern "C" void jac_##model(int *, double *, double *, int *, int *, double *, int *, double *, int *);
+ODE_DET_MODEL(ano)
+ODE_DET_MODEL(calcineurin)
+ODE_DET_MODEL(calmodulin)
+ODE_DET_MODEL(camkii)
+ODE_DET_MODEL(glycphos)
+ODE_DET_MODEL(pkc)
+#undef ODE_DET_MODEL
+
+#define ODE_DET_ENTRIES(model) \
+  {"initmod_" #model, (DL_FUNC) &initmod_##model, 1, NULL}, \
+  {"initforc_" #model, (DL_FUNC) &initforc_##model, 1, NULL}, \
+  {"derivs_" #model, (DL_FUNC) &derivs_##model, 6, NULL}, \
+  {"jac_" #model, (DL_FUNC) &jac_##model, 9, NULL},
+static const R_CMethodDef CEntries[] = {
+  ODE_DET_ENTRIES(ano)
+  ODE_DET_ENTRIES(calcineurin)
+  ODE_DET_ENTRIES(calmodulin)
+  ODE_DET_ENTRIES(camkii)
+  ODE_DET_ENTRIES(glycphos)
+  ODE_DET_ENTRIES(pkc)
+  {NULL, NULL, 0, NULL}
+};
+#undef ODE_DET_ENTRIES
+
+// Called by R_init_CalciumModelsLibrary (RcppExports.cpp) after the registration of the .Call routines:
+// R_registerRoutines only replaces the tables it is given (the .Call table stays), but re-enables the dynamic lookup
+// [[Rcpp::init]]
+void register_ode_det_models(DllInfo *dll) {
+  R_registerRoutines(dll, CEntries, NULL, NULL, NULL);
+  R_useDynamicSymbols(dll, FALSE);
+}
@@ -0,0 +1,325 @@
+#ifndef ODE_SOLVER_HPP
+#define ODE_SOLVER_HPP
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "sparse_lu.hpp"
+
+
+// Integrators of the deterministic simulation (user_sim_params "solver")
+enum OdeSolver {
+  ODE_ROSENBROCK,  // "rosenbrock": L-stable Rosenbrock method ROS2 for stiff systems (default)
+  ODE_RK45         // "rk45": explicit Runge-Kutta method of Dormand and Prince, order 5(4), for non-stiff systems
+};
+
+// Settings of the deterministic simulation
+struct OdeSettings {
+  OdeSolver solver;
+  double rtol;  // relative and ...
+  double atol;  // ... absolute error tolerance [nmol/l] ("rtol", "atol")
+};
+
+
+// LU decomposition with partial pivoting of the dense n x n matrix A (row-major, overwritten by L and U; row i was swapped with pivot[i]).
+// Returns false for a singular matrix. The factors can be reused for several right-hand sides (lu_solve).
+inline bool lu_factor(int n, std::vector<double> &A, std::vector<int> &pivot) {
+  pivot.resize(n);
+  for (int c = 0; c < n; c++) {
+    int p = c;
+    for (int r = c+1; r < n; r++) {
+      if (fabs(A[r*n+c]) > fabs(A[p*n+c])) {
+        p = r;
+      }
+    }
+    pivot[c] = p;
+    if (A[p*n+c] == 0) {
+      return false;
+    }
+    if (p != c) {
+      for (int k = 0; k < n; k++) {
+        std::swap(A[c*n+k], A[p*n+k]);
+      }
+    }
+    for (int r = c+1; r < n; r++) {
+      double factor = A[r*n+c] /= A[c*n+c];
+      if (factor == 0) {
+        continue;
+      }
+      for (int k = c+1; k < n; k++) {
+        A[r*n+k] -= factor*A[c*n+k];
+      }
+    }
+  }
+  return true;
+}
+
+// Solve A z = b with the factors of lu_factor (z returned in b)
+inline void lu_solve(int n, const std::vector<double> &A, const std::vector<int> &pivot, double *b) {
+  for (int c = 0; c < n; c++) {
+    std::swap(b[c], b[pivot[c]]);
+    for (int r = c+1; r < n; r++) {
+      b[r] -= A[r*n+c]*b[c];
+    }
+  }
+  for (int r = n-1; r >= 0; r--) {
+    double sum = b[r];
+    for (int k = r+1; k < n; k++) {
+      sum -= A[r*n+k]*b[k];
+    }
+    b[r] = sum/A[r*n+r];
+  }
+}
+
+
+// Buffers of the Rosenbrock steps (sized on first use) and the Jacobian, kept between steps while jacobian_valid.
+// The factors of the iteration matrix are reused while the Jacobian and the step size (lu_h) do not change: dense (LU with partial pivoting)
+// by default, sparse if the caller has set up the pattern of the Jacobian in lu (sparse_lu_pattern for the active components).
+// f0 holds f(y) of the last step; callers that already know f(y) of the next step (e.g. from a dense output) store it in f0 and set f0_valid.
+struct RosenbrockWorkspace {
+  std::vector<double> f0, f1, k1, k2, y1, J, W;
+  std::vector<int> pivot;
+  SparseLU lu;
+  bool jacobian_valid;
+  bool lu_valid;
+  double lu_h;
+  bool f0_valid;
+  RosenbrockWorkspace() : jacobian_valid(false), lu_valid(false), lu_h(0), f0_valid(false) {}
+};
+
+// Jacobian of the active components by forward differences (m x m, row-major; y1 and f1 are scratch vectors of size n)
+template <typename Rhs>
+struct FiniteDifferenceJacobian {
+  Rhs &rhs;
+  int n;
+  const std::vector<unsigned int> &active;
+  std::vector<double> &y1;
+  std::vector<double> &f1;
+
+  void operator()(const double *y, const double *f0, double *J) {
+    int m = active.size();
+    y1.assign(y, y+n);
+    for (int c = 0; c < m; c++) {
+      double yc = y[active[c]];
+      double delta = 1e-7*std::max(fabs(yc), 1.0);
+      y1[active[c]] = yc + delta;
+      rhs(y1.data(), f1.data());
+      y1[active[c]] = yc;
+      for (int r = 0; r < m; r++) {
+        J[r*m+c] = (f1[active[r]] - f0[active[r]])/delta;
+      }
+    }
+  }
+};
+
+// One step of the L-stable, second order Rosenbrock method ROS2 (Verwer et al., SIAM J. Sci. Comput. 20, 1999) for the autonomous system dy/dt = rhs(y)
+// of size n, with gamma = 1 + 1/sqrt(2):
+//   (I - gamma h J) k1 = f(y),  (I - gamma h J) k2 = f(y + h k1) - 2 k1,  y_new = y + 3/2 h k1 + 1/2 h k2
+// Only the components active[0], ..., active[m-1] change (f_i = 0 for all others), the linear systems are solved for them only.
+// ROS2 keeps its order for any approximation J of the Jacobian (W-method): J is evaluated only if the workspace has none
+// (jacobian_valid is false; callers reset it when the system changes, e.g. after a rejected step).
+// Jacobian: void operator()(const double *y, const double *f0, double *J), writing the m x m Jacobian of the active components (row-major)
+// at y (f0 = f(y)).
+// Returns the weighted RMS norm of the difference to the embedded first order solution y + h k1 (tolerances rtol, atol;
+// a step is acceptable if <= 1), or infinity if the iteration matrix is singular.
+// Rhs: void operator()(const double *y, double *dydt), writing all n derivatives.
+template <typename Rhs, typename Jacobian>
+inline double rosenbrock2_step(Rhs &rhs, Jacobian &jacobian, int n, const std::vector<unsigned int> &active, const double *y, double h,
+                               double rtol, double atol, double *y_new, RosenbrockWorkspace &w) {
+  const double gamma = 1.7071067811865475;
+  int m = active.size();
+  bool sparse = w.lu.n == m && m > 0;
+  w.f0.resize(n);
+  w.f1.resize(n);
+  w.k1.resize(m);
+  w.k2.resize(m);
+  if (!w.f0_valid) {
+    rhs(y, w.f0.data());
+  }
+  w.f0_valid = false;
+  if (!w.jacobian_valid || w.J.size() != (size_t)m*m) {
+    w.J.assign((size_t)m*m, 0.0);
+    jacobian(y, w.f0.data(), w.J.data());
+    w.jacobian_valid = true;
+    w.lu_valid = false;
+  }
+  // iteration matrix W = I - gamma h J
+  if (!w.lu_valid || w.lu_h != h) {
+    std::vector<double> &W = sparse ? w.lu.A : w.W;
+    W.resize((size_t)m*m);
+    for (int r = 0; r < m; r++) {
+      for (int c = 0; c < m; c++) {
+        W[r*m+c] = (r == c) - gamma*h*w.J[r*m+c];
+      }
+    }
+    w.lu_valid = sparse ? sparse_lu_factor(w.lu) : lu_factor(m, w.W, w.pivot);
+    w.lu_h = h;
+    if (!w.lu_valid) {
+      return std::numeric_limits<double>::infinity();
+    }
+  }
+  // stages
+  w.y1.assign(y, y+n);
+  for (int r = 0; r < m; r++) {
+    w.k1[r] = w.f0[active[r]];
+  }
+  if (sparse) {
+    sparse_lu_solve(w.lu, w.k1.data());
+  } else {
+    lu_solve(m, w.W, w.pivot, w.k1.data());
+  }
+  for (int r = 0; r < m; r++) {
+    w.y1[active[r]] = y[active[r]] + h*w.k1[r];
+  }
+  rhs(w.y1.data(), w.f1.data());
+  for (int r = 0; r < m; r++) {
+    w.k2[r] = w.f1[active[r]] - 2*w.k1[r];
+  }
+  if (sparse) {
+    sparse_lu_solve(w.lu, w.k2.data());
+  } else {
+    lu_solve(m, w.W, w.pivot, w.k2.data());
+  }
+  // solution and error estimate
+  std::copy(y, y+n, y_new);
+  double error = 0;
+  for (int r = 0; r < m; r++) {
+    unsigned int i = active[r];
+    y_new[i] = y[i] + 1.5*h*w.k1[r] + 0.5*h*w.k2[r];
+    double scale = atol + rtol*std::max(fabs(y[i]), fabs(y_new[i]));
+    double e = 0.5*h*(w.k1[r] + w.k2[r])/scale;
+    error += e*e;
+  }
+  return m > 0 ? sqrt(error/m) : 0;
+}
+
+// ROS2 step with the Jacobian by finite differences
+template <typename Rhs>
+inline double rosenbrock2_step(Rhs &rhs, int n, const std::vector<unsigned int> &active, const double *y, double h,
+                               double rtol, double atol, double *y_new, RosenbrockWorkspace &w) {
+  w.f1.resize(n);
+  FiniteDifferenceJacobian<Rhs> jacobian = {rhs, n, active, w.y1, w.f1};
+  return rosenbrock2_step(rhs, jacobian, n, active, y, h, rtol, atol, y_new, w);
+}
+
+// Dense output of a step from y (derivative f0) to y_new (derivative f1) of size h: cubic Hermite interpolation at y + theta*h (0 <= theta <= 1)
+// of the active components (the others are copied from y)
+inline void hermite_interpolation(int n, const std::vector<unsigned int> &active, const double *y, const double *f0,
+                                  const double *y_new, const double *f1, double h, double theta, double *out) {
+  double h00 = (1 + 2*theta)*(1 - theta)*(1 - theta), h10 = theta*(1 - theta)*(1 - theta);
+  double h01 = theta*theta*(3 - 2*theta), h11 = theta*theta*(theta - 1);
+  std::copy(y, y+n, out);
+  for (unsigned int r = 0; r < active.size(); r++) {
+    unsigned int i = active[r];
+    out[i] = h00*y[i] + h10*h*f0[i] + h01*y_new[i] + h11*h*f1[i];
+  }
+}
+
+
+// Stages of the Dormand-Prince steps; k1 holds f(y) of the current state while fsal_valid (first same as last: the last stage of an accepted
+// step is the first one of the next, callers reset fsal_valid when the state or the system changes otherwise)
+struct DormandPrinceWorkspace {
+  std::vector<double> k1, k2, k3, k4, k5, k6, k7, y1;
+  bool fsal_valid;
+  DormandPrinceWorkspace() : fsal_valid(false) {}
+
+  // The step to y_new is accepted: f(y_new) becomes the first stage of the next step
+  void accept() {
+    k1.swap(k7);
+  }
+};
+
+// One step of the explicit Runge-Kutta method of Dormand and Prince (RK5(4)7M, J. Comput. Appl. Math. 6, 1980) for dy/dt = rhs(y) of size n.
+// Only the components active[0], ..., active[m-1] change. Returns the weighted RMS norm of the difference to the embedded fourth order solution
+// (tolerances rtol, atol; a step is acceptable if <= 1). Rhs as for rosenbrock2_step.
+template <typename Rhs>
+inline double dormand_prince_step(Rhs &rhs, int n, const std::vector<unsigned int> &active, const double *y, double h,
+                                  double rtol, double atol, double *y_new, DormandPrinceWorkspace &w) {
+  static const double a21 = 1.0/5;
+  static const double a31 = 3.0/40, a32 = 9.0/40;
+  static const double a41 = 44.0/45, a42 = -56.0/15, a43 = 32.0/9;
+  static const double a51 = 19372.0/6561, a52 = -25360.0/2187, a53 = 64448.0/6561, a54 = -212.0/729;
+  static const double a61 = 9017.0/3168, a62 = -355.0/33, a63 = 46732.0/5247, a64 = 49.0/176, a65 = -5103.0/18656;
+  static const double a71 = 35.0/384, a73 = 500.0/1113, a74 = 125.0/192, a75 = -2187.0/6784, a76 = 11.0/84;
+  static const double e1 = 71.0/57600, e3 = -71.0/16695, e4 = 71.0/1920, e5 = -17253.0/339200, e6 = 22.0/525, e7 = -1.0/40;
+  int m = active.size();
+  if (w.k1.size() != (size_t)n) {
+    w.k1.resize(n);
+    w.k2.resize(n);
+    w.k3.resize(n);
+    w.k4.resize(n);
+    w.k5.resize(n);
+    w.k6.resize(n);
+    w.k7.resize(n);
+    w.fsal_valid = false;
+  }
+  if (!w.fsal_valid) {
+    rhs(y, w.k1.data());
+    w.fsal_valid = true;
+  }
+  w.y1.assign(y, y+n);
+  double *y1 = w.y1.data();
+  const double *k1 = w.k1.data(), *k2 = w.k2.data(), *k3 = w.k3.data(), *k4 = w.k4.data(), *k5 = w.k5.data(), *k6 = w.k6.data();
+  for (int r = 0; r < m; r++) {
+    unsigned int i = active[r];
+    y1[i] = y[i] + h*a21*k1[i];
+  }
+  rhs(y1, w.k2.data());
+  for (int r = 0; r < m; r++) {
+    unsigned int i = active[r];
+    y1[i] = y[i] + h*(a31*k1[i] + a32*k2[i]);
+  }
+  rhs(y1, w.k3.data());
+  for (int r = 0; r < m; r++) {
+    unsigned int i = active[r];
+    y1[i] = y[i] + h*(a41*k1[i] + a42*k2[i] + a43*k3[i]);
+  }
+  rhs(y1, w.k4.data());
+  for (int r = 0; r < m; r++) {
+    unsigned int i = active[r];
+    y1[i] = y[i] + h*(a51*k1[i] + a52*k2[i] + a53*k3[i] + a54*k4[i]);
+  }
+  rhs(y1, w.k5.data());
+  for (int r = 0; r < m; r++) {
+    unsigned int i = active[r];
+    y1[i] = y[i] + h*(a61*k1[i] + a62*k2[i] + a63*k3[i] + a64*k4[i] + a65*k5[i]);
+  }
+  rhs(y1, w.k6.data());
+  std::copy(y, y+n, y_new);
+  for (int r = 0; r < m; r++) {
+    unsigned int i = active[r];
+    y_new[i] = y[i] + h*(a71*k1[i] + a73*k3[i] + a74*k4[i] + a75*k5[i] + a76*k6[i]);
+  }
+  rhs(y_new, w.k7.data());
+  // error estimate
+  const double *k7 = w.k7.data();
+  double error = 0;
+  for (int r = 0; r < m; r++) {
+    unsigned int i = active[r];
+    double scale = atol + rtol*std::max(fabs(y[i]), fabs(y_new[i]));
+    double e = h*(e1*k1[i] + e3*k3[i] + e4*k4[i] + e5*k5[i] + e6*k6[i] + e7*k7[i])/scale;
+    error += e*e;
+  }
+  return m > 0 ? sqrt(error/m) : 0;
+}
+
+// Dense output of the last Dormand-Prince step from y to y_new of size h (before accept()): the fourth order continuous extension
+// of Hairer, Norsett & Wanner (Solving Ordinary Differential Equations I, 1993, routine DOPRI5) at y + theta*h (0 <= theta <= 1)
+inline void dormand_prince_dense(const DormandPrinceWorkspace &w, int n, const std::vector<unsigned int> &active,
+                                 const double *y, const double *y_new, double h, double theta, double *out) {
+  static const double d1 = -12715105075.0/11282082432, d3 = 87487479700.0/32700410799, d4 = -10690763975.0/1880347072,
+                      d5 = 701980252875.0/199316789632, d6 = -1453857185.0/822651844, d7 = 69997945.0/29380423;
+  double theta1 = 1 - theta;
+  std::copy(y, y+n, out);
+  for (unsigned int r = 0; r < active.size(); r++) {
+    unsigned int i = active[r];
+    double diff = y_new[i] - y[i];
+    double b = h*w.k1[i] - diff;
+    double c = diff - h*w.k7[i] - b;
+    double d = h*(d1*w.k1[i] + d3*w.k3[i] + d4*w.k4[i] + d5*w.k5[i] + d6*w.k6[i] + d7*w.k7[i]);
+    out[i] = y[i] + theta*(diff + theta1*(b + theta*(c + theta1*d)));
+  }
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef OUTPUT_SINK_HPP
+#define OUTPUT_SINK_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <stdint.h>
+
+
+// Value types of the species output columns (user_sim_params "output_type")
+enum OutputType {
+  OUTPUT_DOUBLE,   // "double": concentrations [nmol/l] (default)
+  OUTPUT_FLOAT,    // "float": concentrations [nmol/l] in single precision
+  OUTPUT_INTEGER,  // "integer": particle numbers (concentration = particle number/f)
+  OUTPUT_COUNT     // particle numbers as 64 bit integers (output type "integer" of compressed output files)
+};
+
+// Rows of the output: column-major buffers with leading dimension ld, time and calcium (and the species of output type double,
+// from column 2) in values, the species of the other output types in species
+struct OutputChunk {
+  const double *values;
+  const void *species;
+  OutputType type;
+  int nrow;
+  int ld;
+  int nspecies;
+
+  // Value of row r of species column c as double
+  double species_value(int r, int c) const {
+    switch (type) {
+      case OUTPUT_FLOAT:
+        return static_cast<const float *>(species)[r + (size_t)c*ld];
+      case OUTPUT_INTEGER:
+        return static_cast<const int *>(species)[r + (size_t)c*ld];
+      case OUTPUT_COUNT:
+        return (double)static_cast<const int64_t *>(species)[r + (size_t)c*ld];
+      default:
+        return values[r + (size_t)(c+2)*ld];
+    }
+  }
+};
+
+
+// Streaming output of a simulation run (user_sim_params "output_file", "output_callback"):
+// the output rows are buffered in a chunk of a fixed number of rows, which is handed to the sink whenever it is full,
+// so that the memory of a run does not grow with the number of output times.
+class OutputSink {
+public:
+  virtual ~OutputSink() {}
+  virtual void write(const OutputChunk &chunk) = 0;
+  // called after the last chunk of a complete run
+  virtual void close() {}
+};
+
+
+// Output file (closed by the destructor, also if the simulation is interrupted by an error)
+class OutputFile {
+public:
+  explicit OutputFile(const std::string &path) : file(std::fopen(path.c_str(), "wb")), path(path) {
+    if (file == NULL) {
+      throw std::runtime_error("Cannot open output file " + path);
+    }
+  }
+  ~OutputFile() {
+    if (file != NULL) {
+      std::fclose(file);
+    }
+  }
+  void write(const void *data, size_t size) {
+    if (size > 0 && std::fwrite(data, 1, size, file) != size) {
+      throw std::runtime_error("Cannot write to output file " + path);
+    }
+  }
+private:
+  OutputFile(const OutputFile &);
+  OutputFile &operator=(const OutputFile &);
+  FILE *file;
+  std::string path;
+};
+
+
+// CSV file: a header line with the column names, then one line per output time
+// (values with 15, single precision values with 9 significant digits)
+class CsvSink : public OutputSink {
+public:
+  CsvSink(const std::string &path, const std::vector<std::string> &names) : file(path) {
+    std::string header;
+    for (unsigned int c = 0; c < names.size(); c++) {
+      header += (c > 0 ? "," : "") + names[c];
+    }
+    header += "\n";
+    file.write(header.data(), header.size());
+  }
+  void write(const OutputChunk &chunk) {
+    std::string text;
+    const char *format = chunk.type == OUTPUT_FLOAT ? ",%.9g" : ",%.15g";
+    for (int r = 0; r < chunk.nrow; r++) {
+      append(text, "%.15g", chunk.values[r]);
+      append(text, ",%.15g", chunk.values[r + chunk.ld]);
+      for (int c = 0; c < chunk.nspecies; c++) {
+        append(text, format, chunk.species_value(r, c));
+      }
+      text += "\n";
+    }
+    file.write(text.data(), text.size());
+  }
+private:
+  // one formatted value (at most 24 characters for %.15g, the buffer leaves room to spare)
+  static void append(std::string &text, const char *format, double x) {
+    char value[64];
+    int n = std::snprintf(value, sizeof(value), format, x);
+    if (n < 0) {
+      throw std::runtime_error("Cannot format an output value");
+    }
+    text.append(value, std::min(n, (int)sizeof(value) - 1));
+  }
+  OutputFile file;
+};
+
+
+// Binary file: the 8 bytes "CMLTRAJ1", the number of columns and the output type of the species (32 bit integers, 0: double, 1: float,
+// 2: integer), the column names (each terminated by '\0'), then one row per output time: time and calcium (doubles) and the species
+// (doubles, floats or 32 bit integers; native byte order, no padding)
+class BinarySink : public OutputSink {
+public:
+  BinarySink(const std::string &path, const std::vector<std::string> &names, OutputType type) : file(path) {
+    file.write("CMLTRAJ1", 8);
+    int header[2] = {(int)names.size(), (int)type};
+    file.write(header, sizeof(header));
+    for (unsigned int c = 0; c < names.size(); c++) {
+      file.write(names[c].c_str(), names[c].size()+1);
+    }
+  }
+  void write(const OutputChunk &chunk) {
+    size_t value_size = chunk.type == OUTPUT_DOUBLE ? sizeof(double) : 4;
+    size_t row_size = 2*sizeof(double) + chunk.nspecies*value_size;
+    rows.resize(chunk.nrow*row_size);
+    for (int r = 0; r < chunk.nrow; r++) {
+      char *row = &rows[r*row_size];
+      std::memcpy(row, &chunk.values[r], sizeof(double));
+      std::memcpy(row + sizeof(double), &chunk.values[r + chunk.ld], sizeof(double));
+      row += 2*sizeof(double);
+      for (int c = 0; c < chunk.nspecies; c++, row += value_size) {
+        const char *value = chunk.type == OUTPUT_DOUBLE ? (const char *)&chunk.values[r + (size_t)(c+2)*chunk.ld]
+                          : (const char *)chunk.species + (r + (size_t)c*chunk.ld)*value_size;
+        std::memcpy(row, value, value_size);
+      }
+    }
+    file.write(rows.data(), rows.size());
+  }
+private:
+  OutputFile file;
+  std::vector<char> rows;
+};
+
+#endif
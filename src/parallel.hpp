@@ -0,0 +1,77 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <stdexcept>
+
+
+// Number of worker threads to use for a requested thread count (<= 0: all available cores), never more than there are tasks
+inline int worker_count(int threads, int ntasks) {
+  if (threads <= 0) {
+    threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) {
+      threads = 1;
+    }
+  }
+  if (threads > ntasks) {
+    threads = ntasks;
+  }
+  return threads < 1 ? 1 : threads;
+}
+
+
+// Run task(i) for i = 0, ..., ntasks-1 on a pool of worker threads (tasks are handed out one at a time).
+// The tasks must not call the R API. If a task throws, the remaining tasks are skipped
+// and the first error is rethrown on the calling thread after all workers have finished.
+template <typename Task>
+void parallel_for(int ntasks, int threads, Task &task) {
+  int nworkers = worker_count(threads, ntasks);
+  std::atomic<int> next(0);
+  std::atomic<bool> failed(false);
+  std::string error_message;
+  std::mutex error_mutex;
+
+  struct Worker {
+    static void run(Task *task, int ntasks, std::atomic<int> *next, std::atomic<bool> *failed,
+                    std::string *error_message, std::mutex *error_mutex) {
+      int i;
+      while (!failed->load() && (i = next->fetch_add(1)) < ntasks) {
+        try {
+          (*task)(i);
+        } catch (std::exception &e) {
+          std::lock_guard<std::mutex> lock(*error_mutex);
+          if (!failed->exchange(true)) {
+            *error_message = e.what();
+          }
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(*error_mutex);
+          if (!failed->exchange(true)) {
+            *error_message = "unknown error in worker thread";
+          }
+        }
+      }
+    }
+  };
+
+  if (nworkers == 1) {
+    Worker::run(&task, ntasks, &next, &failed, &error_message, &error_mutex);
+  } else {
+    std::vector<std::thread> pool;
+    for (int w = 0; w < nworkers; w++) {
+      pool.push_back(std::thread(Worker::run, &task, ntasks, &next, &failed, &error_message, &error_mutex));
+    }
+    for (int w = 0; w < nworkers; w++) {
+      pool[w].join();
+    }
+  }
+  if (failed.load()) {
+    throw std::runtime_error(error_message);
+  }
+}
+
+#endif
@@ -5,13 +5,37 @@ using namespace Rcpp;
 
 //********************************/* R EXPORT OPTIONS */********************************
 
-// 1. USER INPUT for new models: Change value of the macro variable MODEL_NAME to the name of the new model.
-#define MODEL_NAME pkc
-// include the simulation function with macros (#define statements) that make it model specific (based on MODEL_NAME)
-#include "simulator.cpp"
-// Global variables
-static std::map <std::string, double> prop_params_map;
-// 2. USER INPUT for new models: Change the name of the wrapper function to sim_<MODEL_NAME> and the names of the internally called functions to init_<MODEL_NAME> and simulator_<MODEL_NAME>.
+// include the simulation engine (instantiated for the model traits by the wrapper functions)
+#include "simulator.hpp"
+// 1. USER INPUT for new models: Declare the traits of the new model (see simulator.hpp): its name, the numbers of species and reactions,
+// the stoichiometric matrix and the model specific functions (defined in the MODEL DEFINITION section below).
+struct PkcModel {
+  static std::string name() { return "pkc"; }
+  static constexpr int nspecies = 11;
+  static constexpr int nreactions = 20;
+  // Stoichiometric matrix (rows: species, columns: reactions)
+  static constexpr int stoichiometry[nspecies][nreactions] = {
+    {-1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, -1, 1, 0, 0, -1, 1, 0, 0},
+    {0, 0, 0, 0, -1, 1, -1, 1, 0, 0, 0, 0, 1, -1, -1, 1, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, -1, 1, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, 1, 0, 0, 0, 0, 0, 0, 1, -1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0},
+    {1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, -1, 1}
+  };
+  static List init();
+  static void compile_params(SimulationContext &ctx);
+  static void calculate_ca_factors(SimulationContext &ctx);
+  template <typename T>
+  static double propensity(const SimulationContext &ctx, const T *x, unsigned int j);
+  static double propensity_derivative(const SimulationContext &ctx, const double *x, unsigned int j, unsigned int i);
+  static NumericMatrix get_depM();
+};
+// 2. USER INPUT for new models: Change the name of the wrapper function to sim_<model name> and the model traits in the internally called functions PkcModel::init and simulator<PkcModel>.
 //' PKC Model R Wrapper Function (exported to R)
 //'
 //' This function compares user-supplied parameters to defaults parameter values, overwrites the defaults if neccessary, and calls the internal C++ simulation function for the pkc model.
@@ -69,96 +93,144 @@ DataFrame sim_pkc(DataFrame user_input_df,
                   List user_sim_params,
                   List user_model_params) {
 
-  // READ INPUT
-  // Provide default model parameters list
-  List default_model_params = init_pkc();
-  // Extract default vectors from list
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = PkcModel::init();
   NumericVector default_vols = default_model_params["vols"];
   NumericVector default_init_conc = default_model_params["init_conc"];
   NumericVector default_params = default_model_params["params"];
-  // Extract vectors from user supplied list 
-  // If they exist: definition with the default vector gets overwritten
-  NumericVector user_vols = default_vols;
-  if (user_model_params.containsElementNamed("vols")) {
-      user_vols = user_model_params["vols"];
-  } else {
-    Rcout << "Default volume(s) have been used." << std::endl;
-  } 
-  NumericVector user_init_conc = default_init_conc;
-  if (user_model_params.containsElementNamed("init_conc")) {
-    user_init_conc = user_model_params["init_conc"];
-  } else {
-    Rcout << "Default initial condition(s) have been used." << std::endl;
-  }
-  NumericVector user_params = default_params;
-  if (user_model_params.containsElementNamed("params")) {
-    user_params = user_model_params["params"];
-  } else {
-    Rcout << "Default reaction parameter(s) have been used." << std::endl;
-  }
-  // UPDATE DEFAULTS 
-  // Replace entries in default_model_params with user-supplied values if necessary
-  // 1.) Volumes update:
-  CharacterVector user_vols_names = user_vols.names();
-  for (int i = 0; i < user_vols_names.length(); i++) {
-    std::string current_vol_name = as<std::string>(user_vols_names[i]);
-    if (default_vols.containsElementNamed((current_vol_name).c_str())) {
-      // update default values
-      default_vols[current_vol_name] = user_vols[current_vol_name];    
-    } else {
-      Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
-    }
-  }
-  // 2.) Initial conditions update:
-  CharacterVector user_init_conc_names = user_init_conc.names();
-  for (int i = 0; i < user_init_conc_names.length(); i++) {
-    std::string current_init_conc_name = as<std::string>(user_init_conc_names[i]);
-    if (default_init_conc.containsElementNamed((current_init_conc_name).c_str())) {
-      // update default values
-      default_init_conc[current_init_conc_name] = user_init_conc[current_init_conc_name];    
-    } else {
-      Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
-    }
-  }
-  // 3.) Propensity equation parameters update:
-  CharacterVector user_params_names = user_params.names();
-  for (int i = 0; i < user_params_names.length(); i++) {
-    std::string current_param_name = as<std::string>(user_params_names[i]);
-    if (default_params.containsElementNamed((current_param_name).c_str())) {
-      // update default values
-      default_params[current_param_name] = user_params[current_param_name];    
-    } else {
-      Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
-    }
-  }
-  // Put propensity reaction parameters in a map (for function calculate_amu)
-  // (take parameters from vector "default_params" which contains the updated values)
-  CharacterVector default_params_names = default_params.names();
-  for (int n = 0; n < default_params.length(); n++) {
-    std::string current_param_name = as<std::string>(default_params_names[n]);
-    prop_params_map[current_param_name] = default_params[current_param_name];  
-  }
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
   // RUN SIMULATION
-  // Return result of the included, model-specific copy of the function "simulator" 
-  return simulator_pkc(user_input_df,
-                       user_sim_params,
-                       default_vols,
-                       default_init_conc);
+  // Return result of the function "simulator" of the engine, instantiated for the model traits
+  return simulator<PkcModel>(user_input_df,
+                             user_sim_params,
+                             default_vols,
+                             default_init_conc,
+                             default_params);
    
 }
 
 
 
+//' PKC Model Ensemble R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters with the user-supplied ones (as sim_pkc) and simulates n_replicates independent
+//' stochastic replicates of the PKC model on a pool of threads, each replicate with its own stream of the native random number generator.
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "seed" and first "stream" of the random number generator and the "output_species".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters). 
+//' @param n_replicates An integer: the number of replicates.
+//' @param threads An integer: the number of threads (<= 0: all available cores).
+//' @param output_format A string: "long" (data frame of the stacked replicates with a "replicate" column) or "array" (3-D array: output times x columns x replicates).
+//' @return the result of calling the model specific version of the function "ensemble_simulator" 
+//' @examples
+//' sim_ensemble_pkc()
+//' @export
+// [[Rcpp::export]]
+RObject sim_ensemble_pkc(DataFrame user_input_df,
+                         List user_sim_params,
+                         List user_model_params,
+                         int n_replicates,
+                         int threads = 1,
+                         std::string output_format = "long") {
+
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = PkcModel::init();
+  NumericVector default_vols = default_model_params["vols"];
+  NumericVector default_init_conc = default_model_params["init_conc"];
+  NumericVector default_params = default_model_params["params"];
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATIONS
+  return ensemble_simulator<PkcModel>(user_input_df,
+                                      user_sim_params,
+                                      default_vols,
+                                      default_init_conc,
+                                      default_params,
+                                      n_replicates,
+                                      threads,
+                                      output_format);
+}
+
+
+
+//' PKC Model Parameter Sweep R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters with the user-supplied ones (as sim_pkc) and simulates the PKC model once for every row of
+//' param_sets on a pool of threads. The column names of param_sets are resolved once against the model's volumes, initial conditions and parameters.
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "seed" and first "stream" of the random number generator and the "output_species".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters). 
+//' @param param_sets A Dataframe (or matrix): one parameter set per row, with columns named like the volumes, initial conditions or parameters to vary (and optionally a per-row "seed").
+//' @param threads An integer: the number of threads (<= 0: all available cores).
+//' @param output A string: "summary" (time average and final value of every species per parameter set) or "trajectory" (stacked trajectories with a "set" column).
+//' @return the result of calling the model specific version of the function "sweep_simulator" 
+//' @examples
+//' sweep_pkc()
+//' @export
+// [[Rcpp::export]]
+RObject sweep_pkc(DataFrame user_input_df,
+                  List user_sim_params,
+                  List user_model_params,
+                  DataFrame param_sets,
+                  int threads = 1,
+                  std::string output = "summary") {
+
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = PkcModel::init();
+  NumericVector default_vols = default_model_params["vols"];
+  NumericVector default_init_conc = default_model_params["init_conc"];
+  NumericVector default_params = default_model_params["params"];
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATIONS
+  return sweep_simulator<PkcModel>(user_input_df,
+                                   user_sim_params,
+                                   default_vols,
+                                   default_init_conc,
+                                   default_params,
+                                   param_sets,
+                                   threads,
+                                   output);
+}
+
+
+
+//' PKC Model Deterministic R Wrapper Function (exported to R)
+//'
+//' This function updates the default parameters with the user-supplied ones (as sim_pkc) and integrates the reaction rate equations of the PKC model
+//' natively (deterministic limit of the stochastic model of sim_pkc; same output columns as detSim_pkc).
+//' @param user_input_df A Dataframe: the input Calcium time series (with at least two columns: "time" in s and "Ca" in nmol/l).
+//' @param user_sim_params A List: contains values for the simulation end ("endTime") and its timesteps ("timestep"), and optionally the "solver" ("rosenbrock" or "rk45") and its tolerances "rtol" and "atol".
+//' @param user_model_params A List: the model specific parameters. Can contain up to three different vectors named "vols" (model volumes), "init_conc" (initial conditions) and "params" (propensity equation parameters). 
+//' @return the result of calling the model specific version of the function "det_simulator" 
+//' @examples
+//' detSim_native_pkc()
+//' @export
+// [[Rcpp::export]]
+DataFrame detSim_native_pkc(DataFrame user_input_df,
+                            List user_sim_params,
+                            List user_model_params) {
+
+  // Provide default model parameters list and update it with the user-supplied values
+  List default_model_params = PkcModel::init();
+  NumericVector default_vols = default_model_params["vols"];
+  NumericVector default_init_conc = default_model_params["init_conc"];
+  NumericVector default_params = default_model_params["params"];
+  update_default_params(default_vols, default_init_conc, default_params, user_model_params);
+  // RUN SIMULATION
+  return det_simulator<PkcModel>(user_input_df,
+                                 user_sim_params,
+                                 default_vols,
+                                 default_init_conc,
+                                 default_params);
+}
+
+
+
 //********************************/* MODEL DEFINITION */********************************
-// 3. USER INPUT for new models: define model parameters, number of species, 
-// number of reactions, propensity equations and update_system function 
+// 3. USER INPUT for new models: define the model specific functions of the traits: model parameters, their compilation into the indexed parameter array,
+// the calcium dependent factors, propensity equations and the species each propensity depends on
 
 // Default model parameters
-List init() {
-  // Model dimensions
-  nspecies = 11;
-  nreactions = 20;
-  
+List PkcModel::init() {
   // Default volume(s)
   NumericVector vols = NumericVector::create(
     _["vol"] = 1e-15
@@ -214,86 +286,117 @@ List init() {
   
 }
 
+// Parameter compilation:
+// Resolves the parameter names once per run. k[j] holds the rate constant of reaction j
+// (AA and DAG are given as concentrations and folded into the rate constants of the reactions they take part in).
+void PkcModel::compile_params(SimulationContext &ctx) {
+  
+  double AA = prop_param(ctx, "AA");
+  double DAG = prop_param(ctx, "DAG");
+  
+  ctx.k.assign(20, 0);
+  double *k = ctx.k.data();
+  k[0] = prop_param(ctx, "k1");
+  k[1] = prop_param(ctx, "k2");
+  k[2] = prop_param(ctx, "k3") * AA;
+  k[3] = prop_param(ctx, "k4");
+  k[4] = prop_param(ctx, "k5");
+  k[5] = prop_param(ctx, "k6");
+  k[6] = prop_param(ctx, "k7") * AA;
+  k[7] = prop_param(ctx, "k8");
+  k[8] = prop_param(ctx, "k9");
+  k[9] = prop_param(ctx, "k10");
+  k[10] = prop_param(ctx, "k11");
+  k[11] = prop_param(ctx, "k12");
+  k[12] = prop_param(ctx, "k13");
+  k[13] = prop_param(ctx, "k14");
+  k[14] = prop_param(ctx, "k15") * DAG;
+  k[15] = prop_param(ctx, "k16");
+  k[16] = prop_param(ctx, "k17") * DAG;
+  k[17] = prop_param(ctx, "k18");
+  k[18] = prop_param(ctx, "k19") * AA;
+  k[19] = prop_param(ctx, "k20");
+}
+
+// Calcium dependent factors:
+// Tabulates the calcium dependent part of the propensities for every sample of the input signal (one pass over the whole trace before the simulation).
+enum {
+  CA_k13,  // Ca * k13 (Ca given as conc., hence, no scaling)
+  NCAFACTORS
+};
+void PkcModel::calculate_ca_factors(SimulationContext &ctx) {
+  
+  const double *k = ctx.k.data();
+  const double *calcium = ctx.calcium.data();
+  unsigned int nsamples = ctx.calcium.size();
+  ctx.ca_table.assign(nsamples*NCAFACTORS, 0);
+  double *table = ctx.ca_table.data();
+  for (unsigned int t = 0; t < nsamples; t++) {
+    table[t*NCAFACTORS+CA_k13] = calcium[t] * k[12];
+  }
+}
+
 // Propensity calculation:
-// Calculates the propensities of all PKC model reactions and stores them in the vector amu.
-void calculate_amu() {
+// Calculates the propensity of reaction j of the PKC model for the particle numbers x
+// (called by the simulation engine for all reactions, or only for the reactions affected by a firing).
+template <typename T>
+inline double PkcModel::propensity(const SimulationContext &ctx, const T *x, unsigned int j) {
   
-  // Look up model parameters in array 'double = model_params' initially
-  double k1 = prop_params_map["k1"];
-  double k2 = prop_params_map["k2"];
-  double k3 = prop_params_map["k3"];
-  double k4 = prop_params_map["k4"];
-  double k5 = prop_params_map["k5"];
-  double k6 = prop_params_map["k6"];
-  double k7 = prop_params_map["k7"];
-  double k8 = prop_params_map["k8"];
-  double k9 = prop_params_map["k9"];
-  double k10 = prop_params_map["k10"];
-  double k11 = prop_params_map["k11"];
-  double k12 = prop_params_map["k12"];
-  double k13 = prop_params_map["k13"];
-  double k14 = prop_params_map["k14"];
-  double k15 = prop_params_map["k15"];
-  double k16 = prop_params_map["k16"];
-  double k17 = prop_params_map["k17"];
-  double k18 = prop_params_map["k18"];
-  double k19 = prop_params_map["k19"];
-  double k20 = prop_params_map["k20"];
-  double AA = prop_params_map["AA"];
-  double DAG = prop_params_map["DAG"];
+  // Compiled parameters and calcium dependent factors (of the current input sample) of the context
+  const double *k = ctx.k.data();
+  const double *ca = ctx.ca_table.data() + ctx.ntimepoint*NCAFACTORS;
   
-  amu[0] = k1 * x[0];
-  amu[1] = amu[0] + k2 * x[5];
-  amu[2] = amu[1] + k3 * AA * (double)x[0]; /* AA given as conc., hence, no scaling */
-  amu[3] = amu[2] + k4 * x[6];
-  amu[4] = amu[3] + k5 * x[1];
-  amu[5] = amu[4] + k6 * x[7];
-  amu[6] = amu[5] + k7 * AA * (double)x[1];  /* AA given as conc., hence, no scaling */
-  amu[7] = amu[6] + k8 * x[8];
-  amu[8] = amu[7] + k9 * x[2];
-  amu[9] = amu[8] + k10 * x[9];
-  amu[10] = amu[9] + k11 * x[3];
-  amu[11] = amu[10] + k12 * x[4];
-  amu[12] = amu[11] + calcium[ntimepoint] * k13 * (double)x[0]; /* Ca given as conc., hence, no scaling */
-  amu[13] = amu[12] + k14 * x[1];
-  amu[14] = amu[13] + k15 * DAG * (double)x[1]; /* DAG given as conc., hence, no scaling */
-  amu[15] = amu[14] + k16 * x[2];
-  amu[16] = amu[15] + k17 * DAG * (double)x[0]; /* DAG given as conc., hence, no scaling */
-  amu[17] = amu[16] + k18 * x[10];
-  amu[18] = amu[17] + k19 * AA * (double)x[10];  /* AA given as conc., hence, no scaling */
-  amu[19] = amu[18] + k20 * x[3];
+  switch (j) {
+    case 0: return k[0] * x[0];
+    case 1: return k[1] * x[5];
+    case 2: return k[2] * (double)x[0]; /* k3 * AA (AA given as conc., hence, no scaling) */
+    case 3: return k[3] * x[6];
+    case 4: return k[4] * x[1];
+    case 5: return k[5] * x[7];
+    case 6: return k[6] * (double)x[1]; /* k7 * AA (AA given as conc., hence, no scaling) */
+    case 7: return k[7] * x[8];
+    case 8: return k[8] * x[2];
+    case 9: return k[9] * x[9];
+    case 10: return k[10] * x[3];
+    case 11: return k[11] * x[4];
+    case 12: return ca[CA_k13] * (double)x[0]; /* Ca given as conc., hence, no scaling */
+    case 13: return k[13] * x[1];
+    case 14: return k[14] * (double)x[1]; /* k15 * DAG (DAG given as conc., hence, no scaling) */
+    case 15: return k[15] * x[2];
+    case 16: return k[16] * (double)x[0]; /* k17 * DAG (DAG given as conc., hence, no scaling) */
+    case 17: return k[17] * x[10];
+    case 18: return k[18] * (double)x[10]; /* k19 * AA (AA given as conc., hence, no scaling) */
+    case 19: return k[19] * x[3];
+  }
+  return 0;
+}
+
+
+// Propensity derivatives:
+// Partial derivative of the propensity of reaction j by the particle number x[i] of a species it depends on (see get_depM)
+// (analytic Jacobian of the deterministic simulation).
+inline double PkcModel::propensity_derivative(const SimulationContext &ctx, const double *x, unsigned int j, unsigned int i) {
+  
+  const double *k = ctx.k.data();
+  const double *ca = ctx.ca_table.data() + ctx.ntimepoint*NCAFACTORS;
+  
+  // all reactions are first order in their reactant
+  if (j == 12) {
+    return ca[CA_k13];
+  }
+  return k[j];
 }
 
+// Stoichiometric matrix (declared with the model traits)
+constexpr int PkcModel::stoichiometry[PkcModel::nspecies][PkcModel::nreactions];
 
-// Stoichiometric matrix
-NumericMatrix get_stM() {
+// Propensity dependencies:
+// Species (rows, plus a last row for the input calcium signal) on which the propensity of each reaction (columns) depends.
+// Starts from the reactants of every reaction; all other species and calcium entering a propensity are added as modifiers.
+NumericMatrix PkcModel::get_depM() {
   
-  // initialize stoich matrix (with zeroes)
-  NumericMatrix stM(nspecies, nreactions);
-  // create stoich matrix row vectors
-  NumericVector stM_row1 = {-1, 1, -1, 1, 0, 0, 0, 0, 0, 0, 0, 0, -1, 1, 0, 0, -1, 1, 0, 0};
-  NumericVector stM_row2 = {0, 0, 0, 0, -1, 1, -1, 1, 0, 0, 0, 0, 1, -1, -1, 1, 0, 0, 0, 0};
-  NumericVector stM_row3 = {0, 0, 0, 0, 0, 0, 0, 0, -1, 1, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0};
-  NumericVector stM_row4 = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, 1, 0, 0, 0, 0, 0, 0, 1, -1};
-  NumericVector stM_row5 = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row6 = {1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row7 = {0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row8 = {0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row9 = {0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row10 = {0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  NumericVector stM_row11 = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, -1, 1};
-  // fill rows of stoich matrix
-  stM(0, _) = stM_row1;
-  stM(1, _) = stM_row2;
-  stM(2, _) = stM_row3;
-  stM(3, _) = stM_row4;
-  stM(4, _) = stM_row5;
-  stM(5, _) = stM_row6;
-  stM(6, _) = stM_row7;
-  stM(7, _) = stM_row8;
-  stM(8, _) = stM_row9;
-  stM(9, _) = stM_row10;
-  stM(10, _) = stM_row11;
+  NumericMatrix depM = reactant_pattern(stoichiometry_matrix<PkcModel>());
+  depM(11, 12) = 1; // calcium
   
-  return stM;  
+  return depM;
 }
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include <vector>
+#include <algorithm>
+#include "ode_det.hpp"
+
+
+// Compiled PKC model of detSim_pkc (deSolve compiled code interface, see ode_det.hpp)
+// State: PKC_inact, CaPKC, DAGCaPKC, AADAGPKC_inact, AADAGPKC_act, PKCbasal, AAPKC, CaPKCmemb, AACaPKC, DAGPKCmemb, DAGPKC
+// Parameters: k1, ..., k20, AA, DAG
+
+static double pkc_parms[22];
+static double pkc_forcings[1];
+static std::vector<Transition> pkc_network;
+
+extern "C" void initmod_pkc(void (*odeparms)(int *, double *)) {
+  int n = 22;
+  odeparms(&n, pkc_parms);
+  double k[21];  // k[1], ..., k[20]
+  std::copy(pkc_parms, pkc_parms+20, k+1);
+  double AA = pkc_parms[20], DAG = pkc_parms[21];
+  enum {PKC_inact, CaPKC, DAGCaPKC, AADAGPKC_inact, AADAGPKC_act, PKCbasal, AAPKC, CaPKCmemb, AACaPKC, DAGPKCmemb, DAGPKC};
+  pkc_network.clear();
+  pkc_network.push_back(transition(PKC_inact, PKCbasal, k[1], k[2]));
+  pkc_network.push_back(transition(PKC_inact, CaPKC, k[13], k[14], true));
+  pkc_network.push_back(transition(PKC_inact, DAGPKC, k[17]*DAG, k[18]));
+  pkc_network.push_back(transition(PKC_inact, AAPKC, k[3]*AA, k[4]));
+  pkc_network.push_back(transition(CaPKC, DAGCaPKC, k[15]*DAG, k[16]));
+  pkc_network.push_back(transition(CaPKC, CaPKCmemb, k[5], k[6]));
+  pkc_network.push_back(transition(CaPKC, AACaPKC, k[7]*AA, k[8]));
+  pkc_network.push_back(transition(DAGCaPKC, DAGPKCmemb, k[9], k[10]));
+  pkc_network.push_back(transition(AADAGPKC_inact, AADAGPKC_act, k[11], k[12]));
+  pkc_network.push_back(transition(DAGPKC, AADAGPKC_inact, k[19]*AA, k[20]));
+}
+
+extern "C" void initforc_pkc(void (*odeforcs)(int *, double *)) {
+  int n = 1;
+  odeforcs(&n, pkc_forcings);
+}
+
+extern "C" void derivs_pkc(int *neq, double *t, double *y, double *ydot, double *yout, int *ip) {
+  transitions_rhs(pkc_network, *neq, pkc_forcings[0], y, ydot);
+  if (ip[0] > 0) {
+    yout[0] = pkc_forcings[0];
+  }
+}
+
+extern "C" void jac_pkc(int *neq, double *t, double *y, int *ml, int *mu, double *pd, int *nrowpd, double *yout, int *ip) {
+  transitions_jacobian(pkc_network, *neq, pkc_forcings[0], y, pd, *nrowpd);
+}
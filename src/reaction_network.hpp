@@ -0,0 +1,711 @@
+#ifndef REACTION_NETWORK_HPP
+#define REACTION_NETWORK_HPP
+
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <memory>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <stdexcept>
+#include <stdint.h>
+
+
+// Reaction network of a model defined at runtime (network_model()): species, parameters, stoichiometric matrix and one propensity
+// expression per reaction. The expressions are written in terms of the species (particle numbers), the parameters, the calcium
+// concentration "Ca" [nmol/l], the particles per concentration unit "f" and the volume "vol", with + - * / ^, parentheses and the
+// functions exp, log and sqrt.
+// Every expression is split like the propensities of the compiled models: subexpressions of parameters and constants only are
+// evaluated once per run into the parameter array k (compile_params), subexpressions of calcium and parameters once per input sample
+// into the calcium table (calculate_ca_factors), and only the rest, which depends on the species, is compiled into a register bytecode
+// evaluated by a small interpreter in the simulation loop.
+
+
+/* EXPRESSIONS */
+
+enum ExprOp {
+  EXPR_NUMBER, EXPR_SPECIES, EXPR_PARAM, EXPR_CALCIUM, EXPR_F, EXPR_VOL,  // leaves
+  EXPR_NEG, EXPR_EXP, EXPR_LOG, EXPR_SQRT,                                 // unary
+  EXPR_ADD, EXPR_SUB, EXPR_MUL, EXPR_DIV, EXPR_POW                         // binary
+};
+
+struct Expr;
+typedef std::shared_ptr<const Expr> ExprPtr;
+
+struct Expr {
+  ExprOp op;
+  int index;      // species or parameter
+  double value;   // number
+  ExprPtr a;
+  ExprPtr b;
+};
+
+inline ExprPtr make_expr(ExprOp op, int index, double value, ExprPtr a, ExprPtr b) {
+  Expr *e = new Expr;
+  e->op = op;
+  e->index = index;
+  e->value = value;
+  e->a = a;
+  e->b = b;
+  return ExprPtr(e);
+}
+
+inline ExprPtr make_number(double value) {
+  return make_expr(EXPR_NUMBER, 0, value, ExprPtr(), ExprPtr());
+}
+
+inline ExprPtr make_leaf(ExprOp op, int index) {
+  return make_expr(op, index, 0, ExprPtr(), ExprPtr());
+}
+
+inline bool is_number(const ExprPtr &e, double value) {
+  return e->op == EXPR_NUMBER && e->value == value;
+}
+
+// Unary and binary nodes, with constant folding and the identities of 0 and 1
+// (keeps the derivatives of the propensities small)
+inline ExprPtr make_unary(ExprOp op, const ExprPtr &a) {
+  if (a->op == EXPR_NUMBER) {
+    switch (op) {
+      case EXPR_NEG: return make_number(-a->value);
+      case EXPR_EXP: return make_number(exp(a->value));
+      case EXPR_LOG: return make_number(log(a->value));
+      default: return make_number(sqrt(a->value));
+    }
+  }
+  if (op == EXPR_NEG && a->op == EXPR_NEG) {
+    return a->a;
+  }
+  return make_expr(op, 0, 0, a, ExprPtr());
+}
+
+inline ExprPtr make_binary(ExprOp op, const ExprPtr &a, const ExprPtr &b) {
+  if (a->op == EXPR_NUMBER && b->op == EXPR_NUMBER) {
+    switch (op) {
+      case EXPR_ADD: return make_number(a->value + b->value);
+      case EXPR_SUB: return make_number(a->value - b->value);
+      case EXPR_MUL: return make_number(a->value * b->value);
+      case EXPR_DIV: return make_number(a->value / b->value);
+      default: return make_number(pow(a->value, b->value));
+    }
+  }
+  switch (op) {
+    case EXPR_ADD:
+      if (is_number(a, 0)) return b;
+      if (is_number(b, 0)) return a;
+      break;
+    case EXPR_SUB:
+      if (is_number(b, 0)) return a;
+      if (is_number(a, 0)) return make_unary(EXPR_NEG, b);
+      break;
+    case EXPR_MUL:
+      if (is_number(a, 0) || is_number(b, 0)) return make_number(0);
+      if (is_number(a, 1)) return b;
+      if (is_number(b, 1)) return a;
+      break;
+    case EXPR_DIV:
+      if (is_number(a, 0)) return make_number(0);
+      if (is_number(b, 1)) return a;
+      break;
+    default:
+      if (is_number(b, 0)) return make_number(1);
+      if (is_number(b, 1)) return a;
+  }
+  return make_expr(op, 0, 0, a, b);
+}
+
+// Partial derivative of e by species i
+inline ExprPtr derivative(const ExprPtr &e, int i) {
+  switch (e->op) {
+    case EXPR_SPECIES:
+      return make_number(e->index == i ? 1 : 0);
+    case EXPR_NUMBER:
+    case EXPR_PARAM:
+    case EXPR_CALCIUM:
+    case EXPR_F:
+    case EXPR_VOL:
+      return make_number(0);
+    default:
+      break;
+  }
+  ExprPtr da = derivative(e->a, i);
+  switch (e->op) {
+    case EXPR_NEG: return make_unary(EXPR_NEG, da);
+    case EXPR_EXP: return make_binary(EXPR_MUL, e, da);
+    case EXPR_LOG: return make_binary(EXPR_DIV, da, e->a);
+    case EXPR_SQRT: return make_binary(EXPR_DIV, da, make_binary(EXPR_MUL, make_number(2), e));
+    default: break;
+  }
+  ExprPtr db = derivative(e->b, i);
+  switch (e->op) {
+    case EXPR_ADD:
+      return make_binary(EXPR_ADD, da, db);
+    case EXPR_SUB:
+      return make_binary(EXPR_SUB, da, db);
+    case EXPR_MUL:
+      return make_binary(EXPR_ADD, make_binary(EXPR_MUL, da, e->b), make_binary(EXPR_MUL, e->a, db));
+    case EXPR_DIV:
+      if (is_number(db, 0)) {
+        return make_binary(EXPR_DIV, da, e->b);
+      }
+      return make_binary(EXPR_DIV, make_binary(EXPR_SUB, make_binary(EXPR_MUL, da, e->b), make_binary(EXPR_MUL, e->a, db)),
+                         make_binary(EXPR_MUL, e->b, e->b));
+    default:
+      // a^b: b a^(b-1) a' for a constant exponent, a^b (b' log(a) + b a'/a) otherwise
+      if (is_number(db, 0)) {
+        return make_binary(EXPR_MUL, make_binary(EXPR_MUL, e->b, make_binary(EXPR_POW, e->a, make_binary(EXPR_SUB, e->b, make_number(1)))), da);
+      }
+      return make_binary(EXPR_MUL, e, make_binary(EXPR_ADD, make_binary(EXPR_MUL, db, make_unary(EXPR_LOG, e->a)),
+                                                  make_binary(EXPR_DIV, make_binary(EXPR_MUL, e->b, da), e->a)));
+  }
+}
+
+// Species (flags) and calcium an expression depends on
+inline void expression_dependencies(const ExprPtr &e, std::vector<char> &species, bool &calcium) {
+  if (e->op == EXPR_SPECIES) {
+    species[e->index] = 1;
+  } else if (e->op == EXPR_CALCIUM) {
+    calcium = true;
+  }
+  if (e->a) {
+    expression_dependencies(e->a, species, calcium);
+  }
+  if (e->b) {
+    expression_dependencies(e->b, species, calcium);
+  }
+}
+
+// Parser of the propensity expressions (recursive descent; ^ binds strongest and is right associative, unary minus binds weaker than ^)
+class ExpressionParser {
+public:
+  ExpressionParser(const std::string &text, const std::map<std::string, int> &species, const std::map<std::string, int> &params)
+    : text(text), pos(0), species(species), params(params) {}
+
+  ExprPtr parse() {
+    ExprPtr e = parse_sum();
+    skip_space();
+    if (pos < text.size()) {
+      error("unexpected \"" + text.substr(pos, 1) + "\"");
+    }
+    return e;
+  }
+
+private:
+  void error(const std::string &message) const {
+    throw std::runtime_error(message + " at position " + std::to_string(pos+1) + " of \"" + text + "\"");
+  }
+  void skip_space() {
+    while (pos < text.size() && isspace((unsigned char)text[pos])) {
+      pos++;
+    }
+  }
+  bool accept(char c) {
+    skip_space();
+    if (pos < text.size() && text[pos] == c) {
+      pos++;
+      return true;
+    }
+    return false;
+  }
+  ExprPtr parse_sum() {
+    ExprPtr e = parse_product();
+    while (true) {
+      if (accept('+')) {
+        e = make_binary(EXPR_ADD, e, parse_product());
+      } else if (accept('-')) {
+        e = make_binary(EXPR_SUB, e, parse_product());
+      } else {
+        return e;
+      }
+    }
+  }
+  ExprPtr parse_product() {
+    ExprPtr e = parse_unary();
+    while (true) {
+      if (accept('*')) {
+        e = make_binary(EXPR_MUL, e, parse_unary());
+      } else if (accept('/')) {
+        e = make_binary(EXPR_DIV, e, parse_unary());
+      } else {
+        return e;
+      }
+    }
+  }
+  ExprPtr parse_unary() {
+    if (accept('-')) {
+      return make_unary(EXPR_NEG, parse_unary());
+    }
+    if (accept('+')) {
+      return parse_unary();
+    }
+    ExprPtr e = parse_primary();
+    if (accept('^')) {
+      return make_binary(EXPR_POW, e, parse_unary());
+    }
+    return e;
+  }
+  ExprPtr parse_primary() {
+    skip_space();
+    if (pos >= text.size()) {
+      error("unexpected end");
+    }
+    if (accept('(')) {
+      ExprPtr e = parse_sum();
+      if (!accept(')')) {
+        error("missing \")\"");
+      }
+      return e;
+    }
+    const char *start = text.c_str() + pos;
+    if (isdigit((unsigned char)*start) || (*start == '.' && isdigit((unsigned char)start[1]))) {
+      char *end;
+      double value = strtod(start, &end);
+      pos += end - start;
+      return make_number(value);
+    }
+    size_t begin = pos;
+    while (pos < text.size() && (isalnum((unsigned char)text[pos]) || text[pos] == '_' || text[pos] == '.')) {
+      pos++;
+    }
+    if (pos == begin) {
+      error("unexpected \"" + text.substr(pos, 1) + "\"");
+    }
+    std::string name = text.substr(begin, pos - begin);
+    skip_space();
+    if (pos < text.size() && text[pos] == '(') {
+      ExprOp op = name == "exp" ? EXPR_EXP : name == "log" ? EXPR_LOG : name == "sqrt" ? EXPR_SQRT : EXPR_NUMBER;
+      if (op == EXPR_NUMBER) {
+        error("unknown function \"" + name + "\"");
+      }
+      pos++;
+      ExprPtr e = parse_sum();
+      if (!accept(')')) {
+        error("missing \")\"");
+      }
+      return make_unary(op, e);
+    }
+    std::map<std::string, int>::const_iterator it = species.find(name);
+    if (it != species.end()) {
+      return make_leaf(EXPR_SPECIES, it->second);
+    }
+    it = params.find(name);
+    if (it != params.end()) {
+      return make_leaf(EXPR_PARAM, it->second);
+    }
+    if (name == "Ca") {
+      return make_leaf(EXPR_CALCIUM, 0);
+    } else if (name == "f") {
+      return make_leaf(EXPR_F, 0);
+    } else if (name == "vol") {
+      return make_leaf(EXPR_VOL, 0);
+    }
+    pos = begin;
+    error("unknown name \"" + name + "\"");
+    return ExprPtr();
+  }
+
+  const std::string &text;
+  size_t pos;
+  const std::map<std::string, int> &species;
+  const std::map<std::string, int> &params;
+};
+
+
+
+/* BYTECODE */
+
+// Instructions of the interpreter: registers r, species x, parameter array k, calcium factors ca of the current input sample.
+// The binary operations combine a register with a second operand in one of four modes (register, species, parameter array or
+// calcium factor), so that terms like k*A*B take one load and two multiplications.
+enum NetworkOpcode {
+  OP_LOAD_X, OP_LOAD_K, OP_LOAD_CA,           // r[dst] = x[b], k[b], ca[b]
+  OP_NEG, OP_EXP, OP_LOG, OP_SQRT,            // r[dst] = f(r[a])
+  OP_ADD_R, OP_ADD_X, OP_ADD_K, OP_ADD_CA,    // r[dst] = r[a] + r[b], x[b], k[b], ca[b]
+  OP_SUB_R, OP_SUB_X, OP_SUB_K, OP_SUB_CA,
+  OP_MUL_R, OP_MUL_X, OP_MUL_K, OP_MUL_CA,
+  OP_DIV_R, OP_DIV_X, OP_DIV_K, OP_DIV_CA,
+  OP_POW_R, OP_POW_X, OP_POW_K, OP_POW_CA,
+  OP_RETURN                                   // result r[a]
+};
+
+struct Instruction {
+  uint8_t op;
+  uint8_t dst;
+  uint16_t a;
+  uint16_t b;
+};
+
+static const int NETWORK_REGISTERS = 32;
+
+
+/* COMPILED NETWORK */
+
+class ReactionNetwork {
+public:
+  // species and params: names; stoichiometry: species x reactions (column-major); propensities: one expression per reaction
+  ReactionNetwork(const std::vector<std::string> &species, const std::vector<std::string> &params,
+                  const std::vector<int> &stoichiometry, const std::vector<std::string> &propensities)
+    : species(species), params(params), stoichiometry(stoichiometry) {
+    nspecies = species.size();
+    nreactions = propensities.size();
+    if (stoichiometry.size() != (size_t)nspecies*nreactions) {
+      throw std::runtime_error("The stoichiometric matrix must have one row per species and one column per reaction");
+    }
+    std::map<std::string, int> species_index, param_index;
+    for (int i = 0; i < nspecies; i++) {
+      check_name(species[i], species_index, param_index);
+      species_index[species[i]] = i;
+    }
+    for (unsigned int p = 0; p < params.size(); p++) {
+      check_name(params[p], species_index, param_index);
+      param_index[params[p]] = p;
+    }
+    if (nspecies > 65535 || params.size() > 65000) {
+      throw std::runtime_error("Too many species or parameters");
+    }
+    // parameter array: the parameters, f, vol, then constants and hoisted parameter expressions (see compile_params)
+    nk = params.size() + 2;
+    nca = 0;
+    dependencies.assign((size_t)(nspecies+1)*nreactions, 0);
+    derivative_offset.push_back(0);
+    for (int j = 0; j < nreactions; j++) {
+      ExprPtr e;
+      try {
+        e = ExpressionParser(propensities[j], species_index, param_index).parse();
+      } catch (const std::runtime_error &error) {
+        throw std::runtime_error("Propensity of reaction " + std::to_string(j+1) + ": " + error.what());
+      }
+      propensity_code.push_back(compile(e));
+      // species (and calcium) the propensity depends on, with the derivatives by these species (analytic Jacobian)
+      std::vector<char> used(nspecies, 0);
+      bool calcium = false;
+      expression_dependencies(e, used, calcium);
+      for (int i = 0; i < nspecies; i++) {
+        if (used[i]) {
+          dependencies[(size_t)j*(nspecies+1) + i] = 1;
+          derivative_species.push_back(i);
+          derivative_code.push_back(compile(derivative(e, i)));
+        }
+      }
+      dependencies[(size_t)j*(nspecies+1) + nspecies] = calcium;
+      derivative_offset.push_back(derivative_species.size());
+    }
+  }
+
+  int species_count() const {
+    return nspecies;
+  }
+  int reaction_count() const {
+    return nreactions;
+  }
+  const std::vector<std::string> &param_names() const {
+    return params;
+  }
+  // Stoichiometric coefficient of species i in reaction j
+  int stoichiometric_coefficient(int i, int j) const {
+    return stoichiometry[(size_t)j*nspecies + i];
+  }
+  // Dependence of the propensity of reaction j on species i (i = species_count(): on calcium)
+  bool depends_on(int i, int j) const {
+    return dependencies[(size_t)j*(nspecies+1) + i] != 0;
+  }
+  // Number of calcium dependent factors per input sample
+  int ca_factor_count() const {
+    return nca;
+  }
+
+  // Parameter array k of a run from the parameter values (in the order of param_names()), f and vol
+  void compile_params(const std::vector<double> &values, double f, double vol, std::vector<double> &k) const {
+    k.assign(nk, 0);
+    for (unsigned int p = 0; p < values.size(); p++) {
+      k[p] = values[p];
+    }
+    k[params.size()] = f;
+    k[params.size()+1] = vol;
+    for (unsigned int s = 0; s < constants.size(); s++) {
+      k[constants[s].first] = constants[s].second;
+    }
+    for (unsigned int s = 0; s < param_code.size(); s++) {
+      k[param_code[s].first] = evaluate<double>(param_code[s].second, NULL, k.data(), NULL);
+    }
+  }
+
+  // Calcium dependent factors of every input sample (nca per sample)
+  void calculate_ca_factors(const double *calcium, size_t nsamples, const std::vector<double> &k, std::vector<double> &table) const {
+    table.assign(nsamples*nca, 0);
+    for (size_t t = 0; t < nsamples; t++) {
+      for (int s = 0; s < nca; s++) {
+        table[t*nca + s] = evaluate<double>(ca_code[s], NULL, k.data(), &calcium[t]);
+      }
+    }
+  }
+
+  // Propensity of reaction j and its partial derivative by species i (ca: the calcium factors of the current input sample)
+  template <typename T>
+  double propensity(const T *x, unsigned int j, const double *k, const double *ca) const {
+    return evaluate(propensity_code[j], x, k, ca);
+  }
+  double propensity_derivative(const double *x, unsigned int j, unsigned int i, const double *k, const double *ca) const {
+    for (unsigned int d = derivative_offset[j]; d < derivative_offset[j+1]; d++) {
+      if (derivative_species[d] == i) {
+        return evaluate(derivative_code[d], x, k, ca);
+      }
+    }
+    return 0;
+  }
+
+  // Interpreter: runs the program starting at code[start]
+  template <typename T>
+  double evaluate(unsigned int start, const T *x, const double *k, const double *ca) const {
+    double r[NETWORK_REGISTERS];
+    for (const Instruction *p = &code[start]; ; p++) {
+      switch (p->op) {
+        case OP_LOAD_X: r[p->dst] = (double)x[p->b]; break;
+        case OP_LOAD_K: r[p->dst] = k[p->b]; break;
+        case OP_LOAD_CA: r[p->dst] = ca[p->b]; break;
+        case OP_NEG: r[p->dst] = -r[p->a]; break;
+        case OP_EXP: r[p->dst] = exp(r[p->a]); break;
+        case OP_LOG: r[p->dst] = log(r[p->a]); break;
+        case OP_SQRT: r[p->dst] = sqrt(r[p->a]); break;
+        case OP_ADD_R: r[p->dst] = r[p->a] + r[p->b]; break;
+        case OP_ADD_X: r[p->dst] = r[p->a] + (double)x[p->b]; break;
+        case OP_ADD_K: r[p->dst] = r[p->a] + k[p->b]; break;
+        case OP_ADD_CA: r[p->dst] = r[p->a] + ca[p->b]; break;
+        case OP_SUB_R: r[p->dst] = r[p->a] - r[p->b]; break;
+        case OP_SUB_X: r[p->dst] = r[p->a] - (double)x[p->b]; break;
+        case OP_SUB_K: r[p->dst] = r[p->a] - k[p->b]; break;
+        case OP_SUB_CA: r[p->dst] = r[p->a] - ca[p->b]; break;
+        case OP_MUL_R: r[p->dst] = r[p->a] * r[p->b]; break;
+        case OP_MUL_X: r[p->dst] = r[p->a] * (double)x[p->b]; break;
+        case OP_MUL_K: r[p->dst] = r[p->a] * k[p->b]; break;
+        case OP_MUL_CA: r[p->dst] = r[p->a] * ca[p->b]; break;
+        case OP_DIV_R: r[p->dst] = r[p->a] / r[p->b]; break;
+        case OP_DIV_X: r[p->dst] = r[p->a] / (double)x[p->b]; break;
+        case OP_DIV_K: r[p->dst] = r[p->a] / k[p->b]; break;
+        case OP_DIV_CA: r[p->dst] = r[p->a] / ca[p->b]; break;
+        case OP_POW_R: r[p->dst] = pow(r[p->a], r[p->b]); break;
+        case OP_POW_X: r[p->dst] = pow(r[p->a], (double)x[p->b]); break;
+        case OP_POW_K: r[p->dst] = pow(r[p->a], k[p->b]); break;
+        case OP_POW_CA: r[p->dst] = pow(r[p->a], ca[p->b]); break;
+        default: return r[p->a];
+      }
+    }
+  }
+
+  // Number of instructions (all programs)
+  size_t code_size() const {
+    return code.size();
+  }
+
+private:
+  // Operand modes of the binary operations (offsets to OP_ADD_R, ...)
+  enum { MODE_R, MODE_X, MODE_K, MODE_CA, MODE_NONE };
+  // Value classes of subexpressions: bit 1: depends on the species, bit 2: on calcium
+  enum { DEPENDS_SPECIES = 1, DEPENDS_CALCIUM = 2 };
+
+  static void check_name(const std::string &name, const std::map<std::string, int> &species, const std::map<std::string, int> &params) {
+    if (name.empty() || name == "Ca" || name == "f" || name == "vol" || name == "exp" || name == "log" || name == "sqrt") {
+      throw std::runtime_error("Invalid species or parameter name \"" + name + "\"");
+    }
+    if (species.count(name) || params.count(name)) {
+      throw std::runtime_error("Duplicate species or parameter name \"" + name + "\"");
+    }
+  }
+
+  static int value_class(const ExprPtr &e) {
+    switch (e->op) {
+      case EXPR_SPECIES: return DEPENDS_SPECIES;
+      case EXPR_CALCIUM: return DEPENDS_CALCIUM;
+      default: break;
+    }
+    return (e->a ? value_class(e->a) : 0) | (e->b ? value_class(e->b) : 0);
+  }
+
+  // Key of an expression (for sharing the slots of equal hoisted subexpressions)
+  static std::string key(const ExprPtr &e) {
+    char buffer[40];
+    switch (e->op) {
+      case EXPR_NUMBER:
+        std::snprintf(buffer, sizeof(buffer), "#%.17g", e->value);
+        return buffer;
+      case EXPR_SPECIES:
+      case EXPR_PARAM:
+        std::snprintf(buffer, sizeof(buffer), "%c%d", e->op == EXPR_SPECIES ? 'x' : 'p', e->index);
+        return buffer;
+      case EXPR_CALCIUM: return "Ca";
+      case EXPR_F: return "f";
+      case EXPR_VOL: return "vol";
+      default: break;
+    }
+    std::snprintf(buffer, sizeof(buffer), "(%d ", (int)e->op);
+    return buffer + key(e->a) + (e->b ? " " + key(e->b) : std::string()) + ")";
+  }
+
+  // Operand of a propensity program: a species, or a slot of the parameter array or the calcium table (hoisted subexpression);
+  // in the programs of the hoisted subexpressions (setup) the leaves, with calcium as the only entry of the calcium factors
+  void operand(const ExprPtr &e, bool setup, int &mode, int &index) {
+    mode = MODE_NONE;
+    switch (e->op) {
+      case EXPR_SPECIES: mode = MODE_X; index = e->index; return;
+      case EXPR_PARAM: mode = MODE_K; index = e->index; return;
+      case EXPR_F: mode = MODE_K; index = params.size(); return;
+      case EXPR_VOL: mode = MODE_K; index = params.size()+1; return;
+      case EXPR_NUMBER: mode = MODE_K; index = constant_slot(e->value); return;
+      case EXPR_CALCIUM:
+        if (setup) {
+          mode = MODE_CA;
+          index = 0;
+          return;
+        }
+        break;
+      default:
+        if (setup) {
+          return;
+        }
+    }
+    int vc = value_class(e);
+    if (vc == 0) {
+      mode = MODE_K;
+      index = hoisted_slot(e, param_slots, param_code, nk);
+    } else if (vc == DEPENDS_CALCIUM) {
+      mode = MODE_CA;
+      index = hoisted_slot(e, ca_slots, ca_code, nca);
+    }
+  }
+
+  int constant_slot(double value) {
+    for (unsigned int s = 0; s < constants.size(); s++) {
+      if (constants[s].second == value) {
+        return constants[s].first;
+      }
+    }
+    constants.push_back(std::make_pair(nk, value));
+    return nk++;
+  }
+
+  template <typename Code>
+  int hoisted_slot(const ExprPtr &e, std::map<std::string, int> &slots, std::vector<Code> &programs, int &count) {
+    std::string k = key(e);
+    std::map<std::string, int>::const_iterator it = slots.find(k);
+    if (it != slots.end()) {
+      return it->second;
+    }
+    unsigned int start = emit_program(e, true);
+    int slot = count++;
+    store_program(programs, slot, start);
+    slots[k] = slot;
+    return slot;
+  }
+  static void store_program(std::vector<std::pair<int, unsigned int> > &programs, int slot, unsigned int start) {
+    programs.push_back(std::make_pair(slot, start));
+  }
+  static void store_program(std::vector<unsigned int> &programs, int slot, unsigned int start) {
+    programs.push_back(start);
+  }
+
+  // Register needs of an expression (operands need no register of their own)
+  int registers(const ExprPtr &e, bool setup) {
+    int mode, index;
+    operand(e, setup, mode, index);
+    if (mode != MODE_NONE) {
+      return 1;
+    }
+    if (!e->b) {
+      return registers(e->a, setup);
+    }
+    int na = registers(e->a, setup);
+    int nb = registers(e->b, setup);
+    operand(e->b, setup, mode, index);
+    if (mode != MODE_NONE) {
+      return na;
+    }
+    return na == nb ? na+1 : std::max(na, nb);
+  }
+
+  void emit(int op, int dst, int a, int b) {
+    if (dst >= NETWORK_REGISTERS) {
+      throw std::runtime_error("Propensity expression too deeply nested");
+    }
+    Instruction instruction = {(uint8_t)op, (uint8_t)dst, (uint16_t)a, (uint16_t)b};
+    pending.push_back(instruction);
+  }
+
+  // Code of e with its value in register dst (registers above dst are free)
+  void emit_expression(const ExprPtr &e, bool setup, int dst) {
+    int mode, index;
+    operand(e, setup, mode, index);
+    if (mode != MODE_NONE) {
+      emit(mode == MODE_X ? OP_LOAD_X : mode == MODE_K ? OP_LOAD_K : OP_LOAD_CA, dst, 0, index);
+      return;
+    }
+    if (!e->b) {
+      emit_expression(e->a, setup, dst);
+      emit(e->op == EXPR_NEG ? OP_NEG : e->op == EXPR_EXP ? OP_EXP : e->op == EXPR_LOG ? OP_LOG : OP_SQRT, dst, dst, 0);
+      return;
+    }
+    int base = e->op == EXPR_ADD ? OP_ADD_R : e->op == EXPR_SUB ? OP_SUB_R : e->op == EXPR_MUL ? OP_MUL_R : e->op == EXPR_DIV ? OP_DIV_R : OP_POW_R;
+    ExprPtr a = e->a;
+    ExprPtr b = e->b;
+    // commutative operations: the operand (or the subexpression needing fewer registers) second
+    if (e->op == EXPR_ADD || e->op == EXPR_MUL) {
+      int mode_a, mode_b;
+      operand(a, setup, mode_a, index);
+      operand(b, setup, mode_b, index);
+      if ((mode_a != MODE_NONE && mode_b == MODE_NONE) || (mode_b == MODE_NONE && registers(b, setup) > registers(a, setup))) {
+        std::swap(a, b);
+      }
+    }
+    emit_expression(a, setup, dst);
+    operand(b, setup, mode, index);
+    if (mode != MODE_NONE) {
+      emit(base + mode, dst, dst, index);
+    } else {
+      emit_expression(b, setup, dst+1);
+      emit(base + MODE_R, dst, dst, dst+1);
+    }
+  }
+
+  // Compile e into a program (hoisting its parameter and calcium subexpressions), returns its start in code
+  unsigned int emit_program(const ExprPtr &e, bool setup) {
+    std::vector<Instruction> outer;
+    outer.swap(pending);
+    emit_expression(e, setup, 0);
+    emit(OP_RETURN, 0, 0, 0);
+    if (nk > 65535 || nca > 65535) {
+      throw std::runtime_error("Too many parameter expressions");
+    }
+    unsigned int start = code.size();
+    code.insert(code.end(), pending.begin(), pending.end());
+    pending.swap(outer);
+    return start;
+  }
+
+  unsigned int compile(const ExprPtr &e) {
+    return emit_program(e, false);
+  }
+
+  std::vector<std::string> species;
+  std::vector<std::string> params;
+  std::vector<int> stoichiometry;
+  int nspecies;
+  int nreactions;
+  std::vector<char> dependencies;                             // (species + calcium) x reactions
+  int nk;                                                     // size of the parameter array
+  int nca;                                                    // calcium factors per input sample
+  std::vector<std::pair<int, double> > constants;             // slots of the constants in the parameter array
+  std::map<std::string, int> param_slots;                     // hoisted parameter expressions: slots in the parameter array ...
+  std::vector<std::pair<int, unsigned int> > param_code;      // ... and their programs
+  std::map<std::string, int> ca_slots;                        // hoisted calcium expressions: slots in the calcium factors ...
+  std::vector<unsigned int> ca_code;                          // ... and their programs
+  std::vector<unsigned int> propensity_code;                  // program of every reaction
+  std::vector<unsigned int> derivative_offset;                // derivatives of reaction j: derivative_offset[j] to derivative_offset[j+1]-1
+  std::vector<unsigned int> derivative_species;
+  std::vector<unsigned int> derivative_code;
+  std::vector<Instruction> code;
+  std::vector<Instruction> pending;                           // program being compiled
+};
+
+#endif
@@ -0,0 +1,410 @@
+#ifndef REACTION_SELECTION_HPP
+#define REACTION_SELECTION_HPP
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "rng.hpp"
+
+
+// Reaction selection strategies of the Direct Method (user_sim_params "selection").
+// Every selector keeps its own search structure over the propensities a[0], ..., a[n-1] and provides
+//   build(a):              set up the structure for all propensities
+//   update(a, j):          propensity a[j] has changed (called for the changed reactions in increasing order)
+//   total():               sum of all propensities
+//   select(a, total, rng): reaction j with probability a[j]/total
+//   search_depth():        average search depth per selection so far (reactions inspected by a linear search,
+//                          comparisons of a binary search, tree levels, or groups scanned plus rejection trials)
+
+
+// Linear or binary search over the cumulative propensities (linear: the reference implementation of the package).
+// The cumulative sums are only recalculated from the first changed reaction on, so both searches give identical results.
+template <bool BINARY>
+class CumulativeSelector {
+public:
+  void build(const std::vector<double> &a) {
+    n = a.size();
+    amu.assign(n, 0);
+    first_changed = 0;
+    nselect = 0;
+    depth_sum = 0;
+  }
+
+  inline void update(const std::vector<double> &a, unsigned int j) {
+    if (j < first_changed) {
+      first_changed = j;
+    }
+  }
+
+  inline double total(const std::vector<double> &a) {
+    if (first_changed < n) {
+      double sum = first_changed > 0 ? amu[first_changed-1] : 0;
+      for (unsigned int j = first_changed; j < n; j++) {
+        sum += a[j];
+        amu[j] = sum;
+      }
+      first_changed = n;
+    }
+    return amu[n-1];
+  }
+
+  inline unsigned int select(const std::vector<double> &a, double a0, SimRng &rng) {
+    double r2 = a0 * rng.uniform();
+    unsigned int rIndex;
+    if (BINARY) {
+      // first reaction with amu[rIndex] >= r2 (as found by the linear search)
+      unsigned int lo = 0, hi = n-1;
+      while (lo < hi) {
+        depth_sum++;
+        unsigned int mid = (lo+hi)/2;
+        if (amu[mid] < r2) {
+          lo = mid+1;
+        } else {
+          hi = mid;
+        }
+      }
+      rIndex = lo;
+    } else {
+      for (rIndex=0; amu[rIndex] < r2; rIndex++);
+      depth_sum += rIndex+1;
+    }
+    nselect++;
+    return rIndex;
+  }
+
+  double search_depth() const {
+    return nselect > 0 ? depth_sum/nselect : 0;
+  }
+
+private:
+  unsigned int n;
+  unsigned int first_changed;
+  std::vector<double> amu;  // cumulative propensities
+  double nselect;
+  double depth_sum;
+};
+
+
+// Linear search over the cumulative propensities in a reordered reaction list, so that frequently firing reactions are found early.
+// SORTING = false: Optimized Direct Method (Cao, Li & Petzold, J. Chem. Phys. 121, 2004) - the firings of the first 'warmup' selections
+//                  are counted, then the reactions are sorted once by decreasing firing frequency.
+// SORTING = true:  Sorting Direct Method (McCollum et al., Comput. Biol. Chem. 30, 2006) - a fired reaction is swapped with its predecessor
+//                  in the list, which keeps adapting the order to changing regimes (e.g. of the calcium signal).
+template <bool SORTING>
+class ReorderingSelector {
+public:
+  explicit ReorderingSelector(unsigned long warmup = 0) : warmup(warmup) {}
+
+  void build(const std::vector<double> &a) {
+    n = a.size();
+    order.resize(n);
+    position.resize(n);
+    for (unsigned int j = 0; j < n; j++) {
+      order[j] = j;
+      position[j] = j;
+    }
+    amu.assign(n, 0);
+    first_changed = 0;
+    count.assign(n, 0);
+    nselect = 0;
+    depth_sum = 0;
+  }
+
+  inline void update(const std::vector<double> &a, unsigned int j) {
+    if (position[j] < first_changed) {
+      first_changed = position[j];
+    }
+  }
+
+  inline double total(const std::vector<double> &a) {
+    if (first_changed < n) {
+      double sum = first_changed > 0 ? amu[first_changed-1] : 0;
+      for (unsigned int p = first_changed; p < n; p++) {
+        sum += a[order[p]];
+        amu[p] = sum;
+      }
+      first_changed = n;
+    }
+    return amu[n-1];
+  }
+
+  inline unsigned int select(const std::vector<double> &a, double a0, SimRng &rng) {
+    double r2 = a0 * rng.uniform();
+    unsigned int p;
+    for (p=0; amu[p] < r2; p++);
+    unsigned int j = order[p];
+    depth_sum += p+1;
+    nselect++;
+    if (SORTING) {
+      if (p > 0) {
+        // move the fired reaction one step to the front (cumulative sums change at p-1)
+        unsigned int predecessor = order[p-1];
+        order[p-1] = j;
+        order[p] = predecessor;
+        position[j] = p-1;
+        position[predecessor] = p;
+        if (p-1 < first_changed) {
+          first_changed = p-1;
+        }
+      }
+    } else if (nselect <= warmup) {
+      count[j]++;
+      if (nselect == warmup) {
+        sort_by_count();
+      }
+    }
+    return j;
+  }
+
+  double search_depth() const {
+    return nselect > 0 ? depth_sum/nselect : 0;
+  }
+
+private:
+  struct MoreFirings {
+    const std::vector<unsigned long> *count;
+    bool operator()(unsigned int i, unsigned int j) const {
+      return (*count)[i] > (*count)[j];
+    }
+  };
+
+  void sort_by_count() {
+    MoreFirings more_firings = {&count};
+    std::stable_sort(order.begin(), order.end(), more_firings);
+    for (unsigned int p = 0; p < n; p++) {
+      position[order[p]] = p;
+    }
+    first_changed = 0;
+  }
+
+  unsigned long warmup;
+  unsigned int n;
+  std::vector<unsigned int> order;     // reaction at every position of the search list
+  std::vector<unsigned int> position;  // position of every reaction in the search list
+  unsigned int first_changed;          // first position with outdated cumulative sum
+  std::vector<double> amu;             // cumulative propensities in list order
+  std::vector<unsigned long> count;    // firings during the warm-up (Optimized Direct Method)
+  double nselect;
+  double depth_sum;
+};
+
+
+// Partial sums tree: complete binary tree with the propensities as leaves and the sum of its children in every inner node.
+// Updates and selection are O(log(no. of reactions)); the sums are recalculated from the children on every update (no accumulating rounding errors).
+class TreeSelector {
+public:
+  void build(const std::vector<double> &a) {
+    nleaves = 1;
+    while (nleaves < a.size()) {
+      nleaves *= 2;
+    }
+    tree.assign(2*nleaves, 0);
+    for (unsigned int j = 0; j < a.size(); j++) {
+      tree[nleaves+j] = a[j];
+    }
+    for (unsigned int i = nleaves-1; i > 0; i--) {
+      tree[i] = tree[2*i] + tree[2*i+1];
+    }
+    levels = 0;
+    for (unsigned int i = nleaves; i > 1; i /= 2) {
+      levels++;
+    }
+  }
+
+  inline void update(const std::vector<double> &a, unsigned int j) {
+    unsigned int i = nleaves+j;
+    tree[i] = a[j];
+    for (i /= 2; i > 0; i /= 2) {
+      tree[i] = tree[2*i] + tree[2*i+1];
+    }
+  }
+
+  inline double total(const std::vector<double> &a) {
+    return tree[1];
+  }
+
+  inline unsigned int select(const std::vector<double> &a, double a0, SimRng &rng) {
+    double r = a0 * rng.uniform();
+    unsigned int i = 1;
+    while (i < nleaves) {
+      unsigned int left = 2*i;
+      // (never descend into a subtree without propensity because of rounding)
+      if (r < tree[left] || tree[left+1] <= 0) {
+        i = left;
+      } else {
+        r -= tree[left];
+        i = left+1;
+      }
+    }
+    return i - nleaves;
+  }
+
+  double search_depth() const {
+    return levels;
+  }
+
+private:
+  unsigned int nleaves;
+  unsigned int levels;
+  std::vector<double> tree;  // tree[1]: root, tree[nleaves+j]: propensity of reaction j
+};
+
+
+// Composition-rejection selection (Slepoy, Thompson & Plimpton, "A constant-time kinetic Monte Carlo algorithm for simulation
+// of large biochemical reaction networks", J. Chem. Phys. 128, 2008).
+// The reactions are grouped by the binary exponent of their propensity (group g: a in [2^(g-1), 2^g)). A group is selected by a linear search
+// over the (few) non-empty groups, a reaction within the group by rejection sampling (acceptance probability > 1/2).
+// Updates move a reaction between groups in O(1).
+class CompositionRejectionSelector {
+public:
+  void build(const std::vector<double> &a) {
+    n = a.size();
+    groups.assign(NGROUPS, Group());
+    active.clear();
+    group_of.assign(n, -1);
+    position.assign(n, 0);
+    old_value.assign(n, 0);
+    for (unsigned int j = 0; j < n; j++) {
+      insert(a, j);
+    }
+    nupdates = 0;
+    recalculate_sums(a);
+    nselect = 0;
+    depth_sum = 0;
+  }
+
+  inline void update(const std::vector<double> &a, unsigned int j) {
+    int g = group_index(a[j]);
+    if (g == group_of[j]) {
+      if (g >= 0) {
+        groups[g].sum += a[j] - old_value[j];
+        old_value[j] = a[j];
+      }
+    } else {
+      remove(j);
+      insert(a, j);
+    }
+    // recalculate the group sums from time to time (incremental updates accumulate rounding errors)
+    if (++nupdates >= 64*n) {
+      recalculate_sums(a);
+      nupdates = 0;
+    }
+  }
+
+  inline double total(const std::vector<double> &a) {
+    double sum = 0;
+    for (unsigned int k = 0; k < active.size(); k++) {
+      sum += groups[active[k]].sum;
+    }
+    return sum;
+  }
+
+  inline unsigned int select(const std::vector<double> &a, double a0, SimRng &rng) {
+    // composition: select a group
+    double r = a0 * rng.uniform();
+    unsigned int k = 0;
+    for (; k+1 < active.size(); k++) {
+      r -= groups[active[k]].sum;
+      if (r < 0) {
+        break;
+      }
+    }
+    const Group &group = groups[active[k]];
+    double bound = ldexp(1.0, active[k] - GROUP_OFFSET);
+    nselect++;
+    depth_sum += k+1;
+    // rejection: select a reaction of the group
+    while (true) {
+      depth_sum++;
+      unsigned int j = group.members[(unsigned int)(rng.uniform() * group.members.size())];
+      if (rng.uniform() * bound < a[j]) {
+        return j;
+      }
+    }
+  }
+
+  double search_depth() const {
+    return nselect > 0 ? depth_sum/nselect : 0;
+  }
+
+private:
+  struct Group {
+    Group() : sum(0), active_position(-1) {}
+    std::vector<unsigned int> members;
+    double sum;
+    int active_position;  // position in the list of non-empty groups
+  };
+  static const int NGROUPS = 2200;      // binary exponents of all finite doubles
+  static const int GROUP_OFFSET = 1100;
+
+  // group of a propensity (-1 for propensity 0)
+  static inline int group_index(double value) {
+    if (value <= 0) {
+      return -1;
+    }
+    int exponent;
+    frexp(value, &exponent);
+    return exponent + GROUP_OFFSET;
+  }
+
+  inline void insert(const std::vector<double> &a, unsigned int j) {
+    int g = group_index(a[j]);
+    group_of[j] = g;
+    old_value[j] = a[j];
+    if (g < 0) {
+      return;
+    }
+    Group &group = groups[g];
+    position[j] = group.members.size();
+    group.members.push_back(j);
+    group.sum += a[j];
+    if (group.active_position < 0) {
+      group.active_position = active.size();
+      active.push_back(g);
+    }
+  }
+
+  inline void remove(unsigned int j) {
+    int g = group_of[j];
+    if (g < 0) {
+      return;
+    }
+    Group &group = groups[g];
+    unsigned int last = group.members.back();
+    group.members[position[j]] = last;
+    position[last] = position[j];
+    group.members.pop_back();
+    group.sum -= old_value[j];
+    if (group.members.empty()) {
+      group.sum = 0;
+      int moved = active.back();
+      active[group.active_position] = moved;
+      groups[moved].active_position = group.active_position;
+      active.pop_back();
+      group.active_position = -1;
+    }
+    group_of[j] = -1;
+  }
+
+  void recalculate_sums(const std::vector<double> &a) {
+    for (unsigned int k = 0; k < active.size(); k++) {
+      Group &group = groups[active[k]];
+      group.sum = 0;
+      for (unsigned int m = 0; m < group.members.size(); m++) {
+        group.sum += a[group.members[m]];
+      }
+    }
+  }
+
+  unsigned int n;
+  std::vector<Group> groups;
+  std::vector<int> active;             // non-empty groups
+  std::vector<int> group_of;           // group of every reaction (-1: propensity 0)
+  std::vector<unsigned int> position;  // position of every reaction in its group
+  std::vector<double> old_value;       // propensity of every reaction at its last update
+  unsigned long nupdates;
+  double nselect;
+  double depth_sum;
+};
+
+#endif
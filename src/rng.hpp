@@ -0,0 +1,234 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <stdint.h>
+#include <cmath>
+#include <Rcpp.h>
+
+
+// Counter-based random number generator Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC 2011).
+// The output is a pure function of (key, counter): the 64 bit seed is used as key, the upper half of the 128 bit counter
+// selects an independent stream and the lower half counts the generated blocks. Streams therefore never overlap
+// and jumping ahead is a simple counter increment, which makes the generator suitable for independent parallel replicates.
+class Philox4x32 {
+public:
+  Philox4x32(uint64_t seed = 0, uint64_t stream = 0) {
+    set_seed(seed, stream);
+  }
+
+  // Select key (seed) and stream, and reset the block counter
+  void set_seed(uint64_t seed, uint64_t stream) {
+    key[0] = (uint32_t)seed;
+    key[1] = (uint32_t)(seed >> 32);
+    counter[0] = 0;
+    counter[1] = 0;
+    counter[2] = (uint32_t)stream;
+    counter[3] = (uint32_t)(stream >> 32);
+  }
+
+  // Skip the next n blocks (4 x 32 bit each) of the current stream
+  void jump(uint64_t n) {
+    uint64_t low = ((uint64_t)counter[1] << 32 | counter[0]) + n;
+    counter[0] = (uint32_t)low;
+    counter[1] = (uint32_t)(low >> 32);
+  }
+
+  // Generate the next block of four 32 bit random integers
+  void next_block(uint32_t out[4]) {
+    uint32_t c[4] = {counter[0], counter[1], counter[2], counter[3]};
+    uint32_t k[2] = {key[0], key[1]};
+    for (int round = 0; round < 10; round++) {
+      uint64_t p0 = (uint64_t)0xD2511F53 * c[0];
+      uint64_t p1 = (uint64_t)0xCD9E8D57 * c[2];
+      uint32_t hi0 = (uint32_t)(p0 >> 32), lo0 = (uint32_t)p0;
+      uint32_t hi1 = (uint32_t)(p1 >> 32), lo1 = (uint32_t)p1;
+      c[0] = hi1 ^ c[1] ^ k[0];
+      c[1] = lo1;
+      c[2] = hi0 ^ c[3] ^ k[1];
+      c[3] = lo0;
+      k[0] += 0x9E3779B9;
+      k[1] += 0xBB67AE85;
+    }
+    out[0] = c[0];
+    out[1] = c[1];
+    out[2] = c[2];
+    out[3] = c[3];
+    jump(1);
+  }
+
+private:
+  uint32_t key[2];
+  uint32_t counter[4];
+};
+
+
+// Random number generators available to the simulator
+enum RngType {
+  RNG_R,      // R's global generator (reproduces results of earlier package versions for a given set.seed())
+  RNG_NATIVE  // Philox4x32-10, seedable and splittable into independent streams
+};
+
+
+// Random number source of a simulation run.
+// Uniform numbers are drawn from the open interval (0,1). The native generator produces them in batches
+// of RNG_BUFFER_SIZE (two 32 bit words per 53 bit double), so that the per-step cost is a buffer read.
+#define RNG_BUFFER_SIZE 256
+class SimRng {
+public:
+  SimRng() : type(RNG_R), seed(0), stream(0), pos(RNG_BUFFER_SIZE), has_spare(false) {}
+
+  void use_r() {
+    type = RNG_R;
+    has_spare = false;
+  }
+
+  void use_native(uint64_t new_seed, uint64_t new_stream) {
+    type = RNG_NATIVE;
+    seed = new_seed;
+    stream = new_stream;
+    engine.set_seed(seed, stream);
+    pos = RNG_BUFFER_SIZE;
+    has_spare = false;
+  }
+
+  // Uniform random number in (0,1)
+  inline double uniform() {
+    if (type == RNG_R) {
+      // same rejection of the interval boundaries as Rcpp's runif()
+      double u;
+      do {
+        u = unif_rand();
+      } while (u <= 0.0 || u >= 1.0);
+      return u;
+    }
+    if (pos == RNG_BUFFER_SIZE) {
+      fill_uniform(buffer, RNG_BUFFER_SIZE);
+      pos = 0;
+    }
+    return buffer[pos++];
+  }
+
+  // Exponentially distributed random number (rate 1)
+  inline double exponential() {
+    return -log(uniform());
+  }
+
+  // Standard normal random number (Box-Muller; the second number of every pair is returned by the next call)
+  inline double normal() {
+    if (has_spare) {
+      has_spare = false;
+      return spare;
+    }
+    double radius = sqrt(-2*log(uniform()));
+    double angle = 6.283185307179586*uniform();
+    spare = radius*sin(angle);
+    has_spare = true;
+    return radius*cos(angle);
+  }
+
+  // Poisson distributed random number with the given mean (returned as double, means can exceed the integer range of a step)
+  // mean < 10: multiplication of uniforms (Knuth); otherwise transformed rejection with squeeze (PTRS, Hoermann 1993)
+  inline double poisson(double mean) {
+    if (mean <= 0) {
+      return 0;
+    }
+    if (mean < 10) {
+      double limit = exp(-mean);
+      double product = uniform();
+      double k = 0;
+      while (product > limit) {
+        product *= uniform();
+        k++;
+      }
+      return k;
+    }
+    double smu = sqrt(mean);
+    double b = 0.931 + 2.53*smu;
+    double a = -0.059 + 0.02483*b;
+    double inv_alpha = 1.1239 + 1.1328/(b-3.4);
+    double vr = 0.9277 - 3.6224/(b-2);
+    double log_mean = log(mean);
+    while (true) {
+      double u = uniform() - 0.5;
+      double v = uniform();
+      double us = 0.5 - fabs(u);
+      double k = floor((2*a/us + b)*u + mean + 0.43);
+      if (us >= 0.07 && v <= vr) {
+        return k;
+      }
+      if (k < 0 || (us < 0.013 && v > us)) {
+        continue;
+      }
+      if (log(v) + log(inv_alpha) - log(a/(us*us) + b) <= -mean + k*log_mean - lgamma(k+1)) {
+        return k;
+      }
+    }
+  }
+
+  // Batched generation of n uniform random numbers in (0,1)
+  void fill_uniform(double *out, int n) {
+    if (type == RNG_R) {
+      for (int i = 0; i < n; i++) {
+        out[i] = uniform();
+      }
+      return;
+    }
+    uint32_t block[4];
+    int i = 0;
+    while (i < n) {
+      engine.next_block(block);
+      out[i++] = to_double(block[0], block[1]);
+      if (i < n) {
+        out[i++] = to_double(block[2], block[3]);
+      }
+    }
+  }
+
+  // Batched generation of n exponentially distributed random numbers (rate 1)
+  void fill_exponential(double *out, int n) {
+    fill_uniform(out, n);
+    for (int i = 0; i < n; i++) {
+      out[i] = -log(out[i]);
+    }
+  }
+
+  RngType get_type() const {
+    return type;
+  }
+  uint64_t get_seed() const {
+    return seed;
+  }
+  uint64_t get_stream() const {
+    return stream;
+  }
+
+private:
+  // 53 random bits mapped to the midpoints of [0,1) -> never exactly 0 or 1
+  static inline double to_double(uint32_t a, uint32_t b) {
+    uint64_t bits = ((uint64_t)(a >> 5) << 26) | (b >> 6);
+    return ((double)bits + 0.5) * (1.0 / 9007199254740992.0);
+  }
+
+  RngType type;
+  uint64_t seed;
+  uint64_t stream;
+  Philox4x32 engine;
+  double buffer[RNG_BUFFER_SIZE];
+  int pos;
+  bool has_spare;
+  double spare;
+};
+
+
+// Seeds are passed to and from R as doubles, which hold the integers below 2^53 exactly
+const double RNG_SEED_LIMIT = 9007199254740992.0;
+
+// Draw a seed below 2^53 from R's generator (so that set.seed() also controls native runs without an explicit seed,
+// and the seed reported to R reproduces the run)
+inline uint64_t seed_from_r() {
+  uint64_t hi = (uint64_t)floor(unif_rand() * 2097152.0);
+  uint64_t lo = (uint64_t)floor(unif_rand() * 4294967296.0);
+  return (hi << 32) | lo;
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef SIMULATION_CONTEXT_HPP
+#define SIMULATION_CONTEXT_HPP
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include "sparse_stoichiometry.hpp"
+#include "dependency_graph.hpp"
+#include "tau_leaping.hpp"
+#include "langevin.hpp"
+#include "hybrid.hpp"
+#include "ode_solver.hpp"
+#include "output_sink.hpp"
+#include "summary_statistics.hpp"
+#include "rng.hpp"
+#include "calcium_trace.hpp"
+
+
+// Simulation methods (user_sim_params "method")
+enum SimMethod {
+  METHOD_DIRECT,  // "direct": Gillespie's Direct Method (default)
+  METHOD_NRM,     // "nrm": Gibson and Bruck's Next Reaction Method (dependency graph and indexed priority queue)
+  METHOD_TAU,     // "tau": adaptive tau-leaping (approximate, for high particle numbers, see tau_leaping.hpp)
+  METHOD_CLE,     // "cle": Chemical Langevin Equation (approximate, continuous particle numbers, see langevin.hpp)
+  METHOD_HYBRID   // "hybrid": fast reactions of high copy number species as ODE, the others exact (see hybrid.hpp)
+};
+
+// Reaction selection of the Direct Method (user_sim_params "selection", see reaction_selection.hpp)
+enum SelectionMethod {
+  SELECT_LINEAR,  // "linear": linear search over the cumulative propensities (default)
+  SELECT_BINARY,  // "binary": binary search over the cumulative propensities
+  SELECT_TREE,    // "tree": partial sums tree
+  SELECT_CR,      // "cr": composition-rejection
+  SELECT_ODM,     // "odm": Optimized Direct Method (reactions sorted by firing frequency after a warm-up)
+  SELECT_SDM      // "sdm": Sorting Direct Method (fired reaction swapped with its predecessor)
+};
+
+
+// State, parameters and buffers of one simulation run.
+// The simulation loop and all model functions (propensity, ...) operate on a context instead of global variables,
+// so that several simulations can run at the same time in one process (e.g. on worker threads), each with its own context.
+// A context is set up from the R input objects on the main thread; running it does not touch the R API
+// (except for R's random number generator and user interrupts, see 'rng' and 'check_interrupt').
+class ReactionNetwork;
+
+struct SimulationContext {
+  // ------------ Input calcium signal ------------
+  SampledSignal timevector;           // observation times [s]
+  SampledSignal calcium;              // cytosolic calcium concentration [nmol/l]
+  unsigned int ntimepoint;            // index of the current observation
+  // ------------ Simulation output times ------------
+  double timestep;                    // evenly spaced output: interval between two output samples
+  double endTime;                     // end of the simulation and its output
+  std::vector<double> timestep_vector;// user supplied output times: intervals between them (empty otherwise)
+  // ------------ Model ------------
+  int nspecies;
+  int nreactions;
+  std::shared_ptr<const ReactionNetwork> network; // model defined at runtime (see reaction_network.hpp; empty for the compiled models)
+  double vol;                         // volume [l]
+  double f;                           // conversion factor from concentration [nmol/l] to particle numbers (c*f = n)
+  std::vector<unsigned long long> x0; // initial particle numbers
+  std::map<std::string, double> prop_params; // propensity equation parameters (by name, used to set up the run)
+  std::vector<double> k;              // compiled propensity equation parameters (indexed, filled by the model's compile_params)
+  std::vector<double> ca_table;       // calcium dependent factors of the propensities for every input sample
+                                      // (filled by the model's calculate_ca_factors; the factors of sample t start at t*(no. of factors))
+  SparseStoichiometry stoich;
+  DependencyGraph deps;               // reactions to update after a firing / a change of the calcium signal
+  LeapStructure leap;                 // reactants, reaction orders and reversible pairs (tau-leaping step size selection)
+  // ------------ Run state ------------
+  std::vector<unsigned long long> x;  // particle numbers
+  std::vector<double> a;              // propensities
+  SimMethod method;
+  SelectionMethod selection;
+  unsigned long warmup;               // Optimized Direct Method: number of firings counted before the reactions are sorted
+  double search_depth;                // Direct Method: average search depth of the reaction selection (set at the end of a run)
+  TauLeapingSettings tau;
+  CleSettings cle;
+  HybridSettings hybrid;
+  OdeSettings ode;                    // deterministic simulation (det_simulator)
+  SimRng rng;
+  bool check_interrupt;               // only the thread running R may check for user interrupts (Rcpp::checkUserInterrupt throws,
+                                      // so the buffers and output files of the run are released by their destructors)
+  // ------------ Output ------------
+  // nintervals rows and nspecies+2 columns (time, calcium, species) of a column-major matrix with retval_nrow rows
+  // (retval_nrow > nintervals when several runs write into one stacked matrix).
+  // Streaming output (sink != NULL): retval only buffers retval_nrow rows, starting at output row output_offset,
+  // and is handed to the sink whenever it is full (the sink is owned by the caller and only used on the thread running R)
+  double *retval;
+  int retval_nrow;
+  int nintervals;
+  int noutput;
+  double outputTime;
+  // The species columns are the species output_species (all species by default) of output_type; the species of a reduced precision
+  // output type (float or integer) are written to retval_species (same layout, first species in column 0) instead of retval
+  std::vector<int> output_species;
+  OutputType output_type;
+  void *retval_species;
+  OutputSink *sink;
+  int output_offset;
+  // Summary output (summary != NULL): the states are accumulated into the summary statistics instead of written to retval
+  SummaryStatistics *summary;
+};
+
+
+// Value of a named propensity equation parameter (for compile_params; throws if the model has no such parameter)
+inline double prop_param(const SimulationContext &ctx, const char *name) {
+  std::map<std::string, double>::const_iterator it = ctx.prop_params.find(name);
+  if (it == ctx.prop_params.end()) {
+    throw std::invalid_argument(std::string("No such propensity equation parameter: ") + name);
+  }
+  return it->second;
+}
+
+#endif
@@ -0,0 +1,2165 @@
+#ifndef SIMULATOR_HPP
+#define SIMULATOR_HPP
+
+#include "simulation_context.hpp"
+#include "parallel.hpp"
+#include "indexed_priority_queue.hpp"
+#include "reaction_selection.hpp"
+#include "trajectory_file.hpp"
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <Rcpp.h>
+using namespace Rcpp;
+
+
+// Simulation engine, included by every C++ model file and instantiated for its model traits: a struct with
+//   static std::string name()                                           model name (header of compressed output files)
+//   static constexpr int nspecies, nreactions                           numbers of species and reactions
+//   static constexpr int stoichiometry[nspecies][nreactions]            stoichiometric matrix (rows: species, columns: reactions)
+//   static List init()                                                  default volumes, initial conditions and parameters
+//   static void compile_params(SimulationContext &ctx)                  parameter compilation into ctx.k
+//   static void calculate_ca_factors(SimulationContext &ctx)            calcium dependent factors of the input samples (ctx.ca_table)
+//   template <typename T>
+//   static double propensity(const SimulationContext &ctx, const T *x, unsigned int j)
+//                                                                       propensity of reaction j for the particle numbers x
+//   static double propensity_derivative(const SimulationContext &ctx, const double *x, unsigned int j, unsigned int i)
+//                                                                       its partial derivative by x[i]
+//   static NumericMatrix get_depM()                                     species (and calcium) the propensities depend on
+// The numbers of species and reactions are compile-time constants of every instantiation (the trip counts of the loops over species and
+// reactions), and the propensities are inlined into the simulation loops (the switch over the reaction index of the model's propensity).
+// The state updates are not generated per model: the stoichiometry and the dependency graph of the propensities are compiled at runtime
+// into sparse lists (see load_model), the same for all models.
+// Models defined at runtime (network_model.cpp) have the counts DYNAMIC_SIZE: their numbers of species and reactions, stoichiometry and
+// propensity dependencies are taken from the reaction network of the context (model_stoichiometry and model_dependencies are specialized).
+
+// Stoichiometric matrix of the model as R matrix
+template <typename Model>
+NumericMatrix stoichiometry_matrix() {
+  static_assert(sizeof(Model::stoichiometry) == sizeof(int)*Model::nspecies*Model::nreactions,
+                "The stoichiometric matrix must have nspecies rows and nreactions columns");
+  NumericMatrix stM(Model::nspecies, Model::nreactions);
+  for (int i = 0; i < Model::nspecies; i++) {
+    for (int j = 0; j < Model::nreactions; j++) {
+      stM(i, j) = Model::stoichiometry[i][j];
+    }
+  }
+  return stM;
+}
+
+// Species and reaction counts of models defined at runtime
+static const int DYNAMIC_SIZE = -1;
+
+// Number of species and reactions of a run: compile-time constants of the model traits (the context for models defined at runtime)
+template <typename Model>
+inline int species_count(const SimulationContext &ctx) {
+  return Model::nspecies != DYNAMIC_SIZE ? Model::nspecies : ctx.nspecies;
+}
+template <typename Model>
+inline int reaction_count(const SimulationContext &ctx) {
+  return Model::nreactions != DYNAMIC_SIZE ? Model::nreactions : ctx.nreactions;
+}
+
+// Stoichiometric matrix and propensity dependencies (see get_depM) of the model of a run
+template <typename Model>
+NumericMatrix model_stoichiometry(const SimulationContext &ctx) {
+  return stoichiometry_matrix<Model>();
+}
+template <typename Model>
+NumericMatrix model_dependencies(const SimulationContext &ctx) {
+  return Model::get_depM();
+}
+
+
+/* CONTEXT SETUP (main thread, reads R objects) */
+
+// Read the input calcium signal into the context: the data frame or, with user_sim_params "input_file", a calcium trace file
+// (see calcium_trace.hpp; binary traces are used memory-mapped, the calcium values are divided by "input_ca_factor", default 1)
+inline void read_input_signal(SimulationContext &ctx, DataFrame user_input_df, List user_sim_params) {
+  if (user_sim_params.containsElementNamed("input_file")) {
+    double ca_factor = 1;
+    if (user_sim_params.containsElementNamed("input_ca_factor")) {
+      ca_factor = as<double>(user_sim_params["input_ca_factor"]);
+    }
+    load_calcium_trace(as<std::string>(user_sim_params["input_file"]), ca_factor, ctx.timevector, ctx.calcium);
+  } else {
+    NumericVector calcium = user_input_df["Ca"];
+    NumericVector timevector = user_input_df["time"];
+    ctx.calcium.assign(calcium.begin(), calcium.end());
+    ctx.timevector.assign(timevector.begin(), timevector.end());
+  }
+  // (every run starts at the first input sample)
+  if (ctx.timevector.size() == 0) {
+    stop("The input calcium signal is empty.");
+  }
+  ctx.ntimepoint = 0;
+}
+
+// Read the simulation output times into the context
+inline void read_output_times(SimulationContext &ctx, List user_sim_params) {
+  //  ------------ Define sim output times: ------------
+  // 1.) sim output times can be generated from timestep and endTime (evenly spaced)
+  // (use default sim output params if none are supplied by user)
+  if (user_sim_params.containsElementNamed("timestep")) {
+    ctx.timestep = user_sim_params["timestep"];
+  } else {
+    ctx.timestep = 0.01;
+  }
+  if (user_sim_params.containsElementNamed("endTime")) {
+    ctx.endTime = user_sim_params["endTime"];
+  } else {
+    ctx.endTime = 100;
+  }
+  // 2.) sim output times can be supplied as vector by user (even or unevenly spaced)
+  // -> the output intervals are the differences between the supplied times, the simulation ends at the last one
+  // For a vector a = [1,2,3,10,87,...], the intervals between its items are given by a[2:end] - a[1:(end-1)]
+  ctx.timestep_vector.clear();
+  if (user_sim_params.containsElementNamed("outputTimes")) {
+    NumericVector user_output_times_vector = user_sim_params["outputTimes"];
+    int n = user_output_times_vector.length();
+    ctx.endTime = user_output_times_vector[n-1];
+    ctx.timestep_vector.assign(n, 0);
+    for (int id=0; id < n-1; id++) {
+      ctx.timestep_vector[id] = fabs(user_output_times_vector[id+1] - user_output_times_vector[id]);
+    }
+  }
+  ctx.sink = NULL;
+  ctx.output_offset = 0;
+  ctx.summary = NULL;
+  ctx.output_type = OUTPUT_DOUBLE;
+  ctx.retval_species = NULL;
+}
+
+// Seed or stream of the native generator supplied from R (whole numbers below 2^53, exact as doubles)
+inline uint64_t read_seed(double value, const std::string &name) {
+  if (!(value >= 0 && value < RNG_SEED_LIMIT && value == floor(value))) {
+    stop(name + " must be a whole number between 0 and 2^53-1.");
+  }
+  return (uint64_t)value;
+}
+
+// Read the simulation output times, the simulation method and its settings and the random number generator settings into the context
+// (after read_input_signal, whose signal has to cover the output times)
+inline void read_sim_params(SimulationContext &ctx, List user_sim_params) {
+  read_output_times(ctx, user_sim_params);
+  // (the simulation methods step from input sample to input sample: the input signal has to reach the end of the simulation)
+  if (ctx.timevector[ctx.timevector.size()-1] < ctx.endTime) {
+    stop("The input calcium signal ends before endTime (the last input sample must not precede the end of the simulation).");
+  }
+  // ------------ Simulation method ------------
+  std::string method_name = "direct";
+  if (user_sim_params.containsElementNamed("method")) {
+    method_name = as<std::string>(user_sim_params["method"]);
+  }
+  if (method_name == "direct") {
+    ctx.method = METHOD_DIRECT;
+  } else if (method_name == "nrm") {
+    ctx.method = METHOD_NRM;
+  } else if (method_name == "tau") {
+    ctx.method = METHOD_TAU;
+  } else if (method_name == "cle") {
+    ctx.method = METHOD_CLE;
+  } else if (method_name == "hybrid") {
+    ctx.method = METHOD_HYBRID;
+  } else {
+    stop("Unknown simulation method \"" + method_name + "\" (use \"direct\", \"nrm\", \"tau\", \"cle\" or \"hybrid\").");
+  }
+  // reaction selection of the Direct Method
+  std::string selection_name = "linear";
+  if (user_sim_params.containsElementNamed("selection")) {
+    selection_name = as<std::string>(user_sim_params["selection"]);
+  }
+  if (selection_name == "linear") {
+    ctx.selection = SELECT_LINEAR;
+  } else if (selection_name == "binary") {
+    ctx.selection = SELECT_BINARY;
+  } else if (selection_name == "tree") {
+    ctx.selection = SELECT_TREE;
+  } else if (selection_name == "cr") {
+    ctx.selection = SELECT_CR;
+  } else if (selection_name == "odm") {
+    ctx.selection = SELECT_ODM;
+  } else if (selection_name == "sdm") {
+    ctx.selection = SELECT_SDM;
+  } else {
+    stop("Unknown reaction selection \"" + selection_name + "\" (use \"linear\", \"binary\", \"tree\", \"cr\", \"odm\" or \"sdm\").");
+  }
+  ctx.warmup = 10000;
+  if (user_sim_params.containsElementNamed("warmup")) {
+    ctx.warmup = (unsigned long)as<double>(user_sim_params["warmup"]);
+  }
+  // tau-leaping scheme and step size control
+  std::string scheme_name = "adaptive";
+  if (user_sim_params.containsElementNamed("tau_scheme")) {
+    scheme_name = as<std::string>(user_sim_params["tau_scheme"]);
+  }
+  if (scheme_name == "explicit") {
+    ctx.tau.scheme = TAU_EXPLICIT;
+  } else if (scheme_name == "implicit") {
+    ctx.tau.scheme = TAU_IMPLICIT;
+  } else if (scheme_name == "adaptive") {
+    ctx.tau.scheme = TAU_ADAPTIVE;
+  } else {
+    stop("Unknown tau-leaping scheme \"" + scheme_name + "\" (use \"explicit\", \"implicit\" or \"adaptive\").");
+  }
+  ctx.tau.epsilon = 0.03;
+  if (user_sim_params.containsElementNamed("epsilon")) {
+    ctx.tau.epsilon = as<double>(user_sim_params["epsilon"]);
+  }
+  ctx.tau.ncritical = 10;
+  if (user_sim_params.containsElementNamed("ncritical")) {
+    ctx.tau.ncritical = (unsigned int)as<double>(user_sim_params["ncritical"]);
+  }
+  ctx.tau.nssa = 10;
+  ctx.tau.ssa_steps = 100;
+  ctx.tau.nstiff = 100;
+  ctx.tau.delta = 0.05;
+  // Chemical Langevin Equation: scheme, step (fixed or adaptive with "epsilon") and boundary at 0
+  std::string cle_scheme_name = "euler";
+  if (user_sim_params.containsElementNamed("cle_scheme")) {
+    cle_scheme_name = as<std::string>(user_sim_params["cle_scheme"]);
+  }
+  if (cle_scheme_name == "euler") {
+    ctx.cle.scheme = CLE_EULER;
+  } else if (cle_scheme_name == "heun") {
+    ctx.cle.scheme = CLE_HEUN;
+  } else {
+    stop("Unknown CLE scheme \"" + cle_scheme_name + "\" (use \"euler\" or \"heun\").");
+  }
+  std::string cle_boundary_name = "clamp";
+  if (user_sim_params.containsElementNamed("cle_boundary")) {
+    cle_boundary_name = as<std::string>(user_sim_params["cle_boundary"]);
+  }
+  if (cle_boundary_name == "clamp") {
+    ctx.cle.boundary = CLE_CLAMP;
+  } else if (cle_boundary_name == "reflect") {
+    ctx.cle.boundary = CLE_REFLECT;
+  } else {
+    stop("Unknown CLE boundary \"" + cle_boundary_name + "\" (use \"clamp\" or \"reflect\").");
+  }
+  ctx.cle.dt = 0;
+  if (user_sim_params.containsElementNamed("cle_dt")) {
+    ctx.cle.dt = as<double>(user_sim_params["cle_dt"]);
+    if (!(ctx.cle.dt > 0)) {
+      stop("cle_dt must be positive.");
+    }
+  }
+  // hybrid SSA/ODE method: partition threshold and tolerances of the ODE integration
+  ctx.hybrid.threshold = 100;
+  if (user_sim_params.containsElementNamed("hybrid_threshold")) {
+    ctx.hybrid.threshold = as<double>(user_sim_params["hybrid_threshold"]);
+  }
+  ctx.hybrid.rtol = 1e-3;
+  if (user_sim_params.containsElementNamed("rtol")) {
+    ctx.hybrid.rtol = as<double>(user_sim_params["rtol"]);
+  }
+  ctx.hybrid.atol = 0.1;
+  if (user_sim_params.containsElementNamed("atol")) {
+    ctx.hybrid.atol = as<double>(user_sim_params["atol"]);
+  }
+  if (!(ctx.hybrid.rtol > 0) || !(ctx.hybrid.atol > 0)) {
+    stop("rtol and atol must be positive.");
+  }
+  // ------------ Random number generator ------------
+  // "R" (default): R's global generator, "native": Philox4x32-10 with user supplied (or R drawn) seed and stream
+  std::string rng_name = "R";
+  if (user_sim_params.containsElementNamed("rng")) {
+    rng_name = as<std::string>(user_sim_params["rng"]);
+  }
+  if (rng_name == "native") {
+    uint64_t seed;
+    if (user_sim_params.containsElementNamed("seed")) {
+      seed = read_seed(as<double>(user_sim_params["seed"]), "seed");
+    } else {
+      seed = seed_from_r();
+    }
+    uint64_t stream = 0;
+    if (user_sim_params.containsElementNamed("stream")) {
+      stream = read_seed(as<double>(user_sim_params["stream"]), "stream");
+    }
+    ctx.rng.use_native(seed, stream);
+  } else if (rng_name == "R") {
+    ctx.rng.use_r();
+  } else {
+    stop("Unknown random number generator \"" + rng_name + "\" (use \"R\" or \"native\").");
+  }
+}
+
+// Set volume, initial particle numbers and propensity equation parameters of the context, and tabulate the calcium dependent factors
+// of the propensities for the input signal (requires read_input_signal; no R API, can run on any thread)
+template <typename Model>
+inline void set_model_values(SimulationContext &ctx,
+                             double vol,
+                             const std::vector<double> &init_conc,
+                             const std::vector<std::string> &param_names,
+                             const std::vector<double> &params) {
+  // ------------ Conversion from concentration (nmol/l) to particle numbers (factor: n/f = c <=> c*f = n) ------------
+  ctx.vol = vol;
+  ctx.f = 6.0221415e14*ctx.vol;
+  ctx.x0.assign(ctx.nspecies, 0);
+  for (unsigned int i=0; i < init_conc.size(); i++) {
+    ctx.x0[i] = (unsigned long long int)floor(init_conc[i]*ctx.f);
+  }
+  // ------------ Propensity equation parameters (compiled once into the flat array read by the propensity function) ------------
+  ctx.prop_params.clear();
+  for (unsigned int n = 0; n < params.size(); n++) {
+    ctx.prop_params[param_names[n]] = params[n];
+  }
+  Model::compile_params(ctx);
+  // ------------ Calcium dependent factors (calcium is constant between two input samples -> evaluated once per sample) ------------
+  Model::calculate_ca_factors(ctx);
+}
+
+// Load the model definition (dimensions, stoichiometry) and the updated default values of volume, initial conditions and parameters
+template <typename Model>
+inline void load_model(SimulationContext &ctx,
+                       NumericVector default_vols,
+                       NumericVector default_init_conc,
+                       NumericVector default_params) {
+  // ------------ Stoichiometry (compiled once per run into a sparse per-reaction update list) ------------
+  NumericMatrix stM = model_stoichiometry<Model>(ctx);
+  ctx.nspecies = stM.nrow();
+  ctx.nreactions = stM.ncol();
+  compile_stoichiometry(stM, ctx.stoich);
+  compile_dependency_graph(ctx.stoich, model_dependencies<Model>(ctx), ctx.deps);
+  compile_leap_structure(ctx.stoich, ctx.leap);
+  // all species are written to the output (see read_output_columns)
+  ctx.output_species.resize(ctx.nspecies);
+  for (int i = 0; i < ctx.nspecies; i++) {
+    ctx.output_species[i] = i;
+  }
+  // ------------ Volume, initial conditions and parameters ------------
+  std::vector<double> init_conc(default_init_conc.begin(), default_init_conc.end());
+  std::vector<double> params(default_params.begin(), default_params.end());
+  CharacterVector default_params_names = default_params.names();
+  std::vector<std::string> param_names(default_params.length());
+  for (int n = 0; n < default_params.length(); n++) {
+    param_names[n] = as<std::string>(default_params_names[n]);
+  }
+  set_model_values<Model>(ctx, default_vols[0], init_conc, param_names, params);
+}
+
+// Replace entries of the default volumes, initial conditions and parameters with the user-supplied values
+// (user_model_params can contain the vectors "vols", "init_conc" and "params"; the default vectors are updated in place)
+inline void update_default_params(NumericVector default_vols,
+                                  NumericVector default_init_conc,
+                                  NumericVector default_params,
+                                  List user_model_params) {
+  const char *vector_names[3] = {"vols", "init_conc", "params"};
+  const char *messages[3] = {"Default volume(s) have been used.",
+                             "Default initial condition(s) have been used.",
+                             "Default reaction parameter(s) have been used."};
+  NumericVector defaults[3] = {default_vols, default_init_conc, default_params};
+  for (int v = 0; v < 3; v++) {
+    if (!user_model_params.containsElementNamed(vector_names[v])) {
+      Rcout << messages[v] << std::endl;
+      continue;
+    }
+    NumericVector user_values = user_model_params[vector_names[v]];
+    CharacterVector user_names = user_values.names();
+    for (int i = 0; i < user_names.length(); i++) {
+      std::string current_name = as<std::string>(user_names[i]);
+      if (defaults[v].containsElementNamed(current_name.c_str())) {
+        // update default values
+        defaults[v][current_name] = user_values[i];
+      } else {
+        Rcout << "No such index! Default values have been used. Check input parameter vectors." << std::endl;
+      }
+    }
+  }
+}
+
+// Number of output rows (no. of output time points)
+inline int count_output_intervals(const SimulationContext &ctx) {
+  // 1.) timestep and endTime are used to generate a number (nintervals) of evenly spaced intervals
+  // 2.) take number of intervals from user supplied sim output times vector (can be unevenly spaced -> different timestep lengths)
+  if (ctx.timestep_vector.empty()) {
+    return (int)floor((ctx.endTime-ctx.timevector[0])/ctx.timestep+0.5)+1;
+  }
+  return ctx.timestep_vector.size();
+}
+
+
+
+/* SIMULATION (operates on the context only, can run on any thread) */
+
+// Output rows written since output row output_offset
+inline OutputChunk buffered_output(const SimulationContext &ctx) {
+  OutputChunk chunk = {ctx.retval, ctx.retval_species, ctx.output_type, ctx.noutput - ctx.output_offset, ctx.retval_nrow,
+                       (int)ctx.output_species.size()};
+  return chunk;
+}
+
+// Streaming output: hand the buffered output rows to the sink and start a new chunk
+inline void flush_output(SimulationContext &ctx) {
+  if (ctx.noutput > ctx.output_offset) {
+    ctx.sink->write(buffered_output(ctx));
+  }
+  ctx.output_offset = ctx.noutput;
+}
+
+// Write the state x (particle numbers) to the output row of the current output time and advance to the next output time
+template <typename T>
+inline void write_output_row(SimulationContext &ctx, const T *x) {
+  int r = ctx.noutput - ctx.output_offset;
+  int ld = ctx.retval_nrow;
+  double *row = ctx.retval + r;
+  row[0] = ctx.outputTime;
+  row[ld] = ctx.calcium[ctx.ntimepoint];
+  const int *species = ctx.output_species.data();
+  int n = ctx.output_species.size();
+  switch (ctx.output_type) {
+    case OUTPUT_FLOAT: {
+      float *values = static_cast<float *>(ctx.retval_species) + r;
+      for (int c = 0; c < n; c++) {
+        values[c*ld] = (float)(x[species[c]]/ctx.f);
+      }
+      break;
+    }
+    case OUTPUT_INTEGER: {
+      // particle numbers (rounded for the methods with real valued particle numbers)
+      int *values = static_cast<int *>(ctx.retval_species) + r;
+      for (int c = 0; c < n; c++) {
+        double value = x[species[c]] + 0.5;
+        if (!(value < (double)std::numeric_limits<int>::max() + 1)) {
+          throw std::overflow_error("A particle number exceeds the range of the output type \"integer\" (use \"double\" or the compressed output format).");
+        }
+        values[c*ld] = (int)value;
+      }
+      break;
+    }
+    case OUTPUT_COUNT: {
+      int64_t *values = static_cast<int64_t *>(ctx.retval_species) + r;
+      for (int c = 0; c < n; c++) {
+        values[c*ld] = (int64_t)(x[species[c]] + 0.5);
+      }
+      break;
+    }
+    default:
+      for (int c = 0; c < n; c++) {
+        row[(c+2)*ld] = x[species[c]]/ctx.f;
+      }
+  }
+  if (!ctx.timestep_vector.empty()) {
+    ctx.outputTime += ctx.timestep_vector[ctx.noutput];
+  } else {
+    ctx.outputTime += ctx.timestep;
+  }
+  ctx.noutput++;
+  if (ctx.sink != NULL && ctx.noutput - ctx.output_offset == ctx.retval_nrow) {
+    flush_output(ctx);
+  }
+}
+
+// Write the state x (particle numbers) to the output for all output times up to currentTime
+// (while final == false: output times before currentTime, and before endTime)
+// Summary output: the state x is accumulated until currentTime (the simulation methods call this before every change of the state)
+template <typename T>
+inline void write_output(SimulationContext &ctx, const T *x, double currentTime, bool final) {
+  if (ctx.summary != NULL) {
+    ctx.summary->add(x, ctx.f, currentTime);
+    return;
+  }
+  while (ctx.noutput < ctx.nintervals &&
+         (final ? floor(ctx.outputTime*10000) <= floor(ctx.endTime*10000)
+                : (currentTime > ctx.outputTime) && (ctx.outputTime < ctx.endTime))) {
+    write_output_row(ctx, x);
+  }
+}
+
+// Write the current state to the output for all output times up to currentTime
+inline void update_output(SimulationContext &ctx, double currentTime, bool final) {
+  write_output(ctx, ctx.x.data(), currentTime, final);
+}
+
+// Calculate the propensity of every reaction for the current state
+template <typename Model>
+inline void calculate_propensities(SimulationContext &ctx) {
+  const unsigned long long *x = ctx.x.data();
+  for (int j = 0; j < reaction_count<Model>(ctx); j++) {
+    ctx.a[j] = Model::propensity(ctx, x, j);
+  }
+}
+
+// Recalculate the propensities of the reactions reactions[0], ..., reactions[n-1] (the ones affected by a firing or a calcium change, in increasing order)
+template <typename Model>
+inline void update_propensities(SimulationContext &ctx, const unsigned int *reactions, unsigned int n) {
+  const unsigned long long *x = ctx.x.data();
+  for (unsigned int k = 0; k < n; k++) {
+    ctx.a[reactions[k]] = Model::propensity(ctx, x, reactions[k]);
+  }
+}
+
+// ... and pass the changes on to the reaction selection
+template <typename Model, typename Selector>
+inline void update_propensities(SimulationContext &ctx, Selector &selector, const unsigned int *reactions, unsigned int n) {
+  update_propensities<Model>(ctx, reactions, n);
+  for (unsigned int k = 0; k < n; k++) {
+    selector.update(ctx.a, reactions[k]);
+  }
+}
+
+// Gillespie's Direct Method
+// The propensities are kept between steps: after a firing only the reactions depending on the changed species are recalculated
+// (dependency graph), at a sample boundary of the input signal only the calcium dependent ones.
+// The reaction to fire is chosen by the Selector (reaction_selection.hpp).
+template <typename Model, typename Selector>
+inline void run_direct_method(SimulationContext &ctx, Selector &selector) {
+  // ------------ Run state ------------
+  ctx.x = ctx.x0;
+  ctx.a.assign(reaction_count<Model>(ctx), 0);
+  ctx.ntimepoint = 0;
+  ctx.noutput = 0;
+  const DependencyGraph &deps = ctx.deps;
+  // ------------ Variables for random steps ------------
+  double tau;
+  double a0;
+  unsigned int rIndex;
+  // ------------ Time variables ------------
+  double currentTime = ctx.timevector[0];
+  ctx.outputTime = currentTime;
+  // Calculate propensity a for every reaction
+  calculate_propensities<Model>(ctx);
+  selector.build(ctx.a);
+
+  /* SIMULATION LOOP */
+  while (currentTime < ctx.endTime) {
+    if (ctx.check_interrupt) {
+      Rcpp::checkUserInterrupt();
+    }
+    // Calculate time step tau
+    a0 = selector.total(ctx.a);
+    tau = ctx.rng.exponential()/a0;
+    // Check if reaction time exceeds time until the next observation
+    if ((currentTime+tau)>=ctx.timevector[ctx.ntimepoint+1]) {
+      // Set current simulation time to next timepoint in input calcium time series
+      currentTime = ctx.timevector[ctx.ntimepoint+1];
+      // Update output
+      update_output(ctx, currentTime, false);
+      ctx.ntimepoint++;
+      // Update the calcium dependent propensities
+      update_propensities<Model>(ctx, selector, deps.calcium_reactions.data(), deps.calcium_reactions.size());
+    } else {
+      // Select reaction to fire
+      rIndex = selector.select(ctx.a, a0, ctx.rng);
+      // Propagate time
+      currentTime += tau;
+      // Update output
+      update_output(ctx, currentTime, false);
+      // Update system state
+      // add the non-zero stoich coefficients of the selected reaction to x
+      fire_reaction(ctx.stoich, rIndex, ctx.x.data());
+      // Update the propensities depending on the changed species
+      update_propensities<Model>(ctx, selector, &deps.reaction[deps.offset[rIndex]], deps.offset[rIndex+1] - deps.offset[rIndex]);
+    }
+  }
+  // Update output
+  update_output(ctx, currentTime, true);
+  ctx.search_depth = selector.search_depth();
+}
+
+// Next Reaction Method: recalculate the propensity of reaction j (not the one that fired) at time t and rescale its firing time
+template <typename Model>
+inline void update_firing_time(SimulationContext &ctx, IndexedPriorityQueue &queue, unsigned int j, double t) {
+  double a_new = Model::propensity(ctx, ctx.x.data(), j);
+  double a_old = ctx.a[j];
+  ctx.a[j] = a_new;
+  if (a_new == a_old) {
+    return;
+  }
+  if (a_new <= 0) {
+    queue.update(j, std::numeric_limits<double>::infinity());
+  } else if (a_old <= 0) {
+    // the reaction was disabled: draw a new firing time (memoryless)
+    queue.update(j, t + ctx.rng.exponential()/a_new);
+  } else {
+    queue.update(j, t + a_old/a_new*(queue.time(j) - t));
+  }
+}
+
+// Gibson and Bruck's Next Reaction Method
+// Every reaction keeps an absolute putative firing time in an indexed priority queue. After a firing, only the propensities
+// of the dependent reactions are recalculated and their firing times rescaled (t + a_old/a_new * (t_i - t)), the fired reaction draws a new one.
+// The propensities are constant between two samples of the input calcium signal: at a sample boundary the firing times of the calcium dependent
+// reactions are rescaled in the same way, which keeps the method exact for the piecewise constant input.
+template <typename Model>
+inline void run_next_reaction_method(SimulationContext &ctx) {
+  const double infinity = std::numeric_limits<double>::infinity();
+  // ------------ Run state ------------
+  ctx.x = ctx.x0;
+  ctx.ntimepoint = 0;
+  ctx.noutput = 0;
+  unsigned long long *x = ctx.x.data();
+  const DependencyGraph &deps = ctx.deps;
+  // ------------ Time variables ------------
+  double currentTime = ctx.timevector[0];
+  ctx.outputTime = currentTime;
+  // ------------ Propensities and putative firing times ------------
+  ctx.a.assign(reaction_count<Model>(ctx), 0);
+  calculate_propensities<Model>(ctx);
+  std::vector<double> &a = ctx.a;
+  std::vector<double> firing_time(reaction_count<Model>(ctx));
+  for (int j = 0; j < reaction_count<Model>(ctx); j++) {
+    firing_time[j] = a[j] > 0 ? currentTime + ctx.rng.exponential()/a[j] : infinity;
+  }
+  IndexedPriorityQueue queue;
+  queue.build(firing_time);
+  unsigned int rIndex;
+
+  /* SIMULATION LOOP */
+  while (currentTime < ctx.endTime) {
+    if (ctx.check_interrupt) {
+      Rcpp::checkUserInterrupt();
+    }
+    rIndex = queue.top();
+    // Check if the next reaction time exceeds the time until the next observation
+    if (queue.top_time() >= ctx.timevector[ctx.ntimepoint+1]) {
+      // Set current simulation time to next timepoint in input calcium time series
+      currentTime = ctx.timevector[ctx.ntimepoint+1];
+      // Update output
+      update_output(ctx, currentTime, false);
+      ctx.ntimepoint++;
+      // Update the calcium dependent reactions
+      for (unsigned int k = 0; k < deps.calcium_reactions.size(); k++) {
+        update_firing_time<Model>(ctx, queue, deps.calcium_reactions[k], currentTime);
+      }
+    } else {
+      // Propagate time
+      currentTime = queue.top_time();
+      // Update output
+      update_output(ctx, currentTime, false);
+      // Update system state
+      fire_reaction(ctx.stoich, rIndex, x);
+      // Update the dependent reactions (the fired reaction draws a new firing time)
+      for (unsigned int k = deps.offset[rIndex]; k < deps.offset[rIndex+1]; k++) {
+        unsigned int j = deps.reaction[k];
+        if (j == rIndex) {
+          a[j] = Model::propensity(ctx, x, j);
+          queue.update(j, a[j] > 0 ? currentTime + ctx.rng.exponential()/a[j] : infinity);
+        } else {
+          update_firing_time<Model>(ctx, queue, j, currentTime);
+        }
+      }
+    }
+  }
+  // Update output
+  update_output(ctx, currentTime, true);
+}
+
+// Exact SSA step of the tau-leaping method (Direct Method with linear search; ctx.a holds the current propensities and is kept up to date)
+template <typename Model>
+inline void tau_leaping_ssa_step(SimulationContext &ctx, double &currentTime) {
+  const DependencyGraph &deps = ctx.deps;
+  double a0 = 0;
+  for (int j = 0; j < reaction_count<Model>(ctx); j++) {
+    a0 += ctx.a[j];
+  }
+  double tau = ctx.rng.exponential()/a0;
+  if ((currentTime+tau)>=ctx.timevector[ctx.ntimepoint+1]) {
+    currentTime = ctx.timevector[ctx.ntimepoint+1];
+    update_output(ctx, currentTime, false);
+    ctx.ntimepoint++;
+    update_propensities<Model>(ctx, deps.calcium_reactions.data(), deps.calcium_reactions.size());
+  } else {
+    double r2 = a0 * ctx.rng.uniform();
+    unsigned int rIndex = 0;
+    double sum = ctx.a[0];
+    while (sum < r2 && rIndex+1 < (unsigned int)reaction_count<Model>(ctx)) {
+      sum += ctx.a[++rIndex];
+    }
+    currentTime += tau;
+    update_output(ctx, currentTime, false);
+    fire_reaction(ctx.stoich, rIndex, ctx.x.data());
+    update_propensities<Model>(ctx, &deps.reaction[deps.offset[rIndex]], deps.offset[rIndex+1] - deps.offset[rIndex]);
+  }
+}
+
+// Implicit tau-leaping (Rathinam et al. 2003): on entry, firings[j] holds the Poisson number P_j of every leaping reaction (leap[j] != 0).
+// Solves y = x + sum_j v_j (P_j - a_j(x) tau + a_j(y) tau) with Newton's method (finite difference Jacobian of the propensities)
+// and returns the rounded firing numbers k_j = P_j + tau (a_j(y) - a_j(x)) (at least 0) in firings.
+template <typename Model>
+inline void implicit_firings(SimulationContext &ctx, const std::vector<char> &leap, double tau, std::vector<double> &firings) {
+  const SparseStoichiometry &st = ctx.stoich;
+  const int ns = species_count<Model>(ctx);
+  const int nr = reaction_count<Model>(ctx);
+  std::vector<double> c(ns), y(ns), ay(nr), ay_h(nr), F(ns), J((size_t)ns*ns);
+  // constant part c = x + sum_j v_j (P_j - a_j(x) tau), explicit predictor y = x + sum_j v_j P_j
+  for (int i = 0; i < ns; i++) {
+    c[i] = (double)ctx.x[i];
+    y[i] = (double)ctx.x[i];
+  }
+  for (int j = 0; j < nr; j++) {
+    if (!leap[j]) {
+      continue;
+    }
+    for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+      c[st.species[k]] += st.delta[k]*(firings[j] - ctx.a[j]*tau);
+      y[st.species[k]] += st.delta[k]*firings[j];
+    }
+  }
+  for (int iteration = 0; iteration < 20; iteration++) {
+    // residual F = y - c - tau sum_j v_j a_j(y) and Jacobian dF/dy
+    for (int j = 0; j < nr; j++) {
+      ay[j] = leap[j] ? Model::propensity(ctx, y.data(), j) : 0;
+    }
+    for (int i = 0; i < ns; i++) {
+      F[i] = c[i] - y[i];
+    }
+    std::fill(J.begin(), J.end(), 0.0);
+    for (int i = 0; i < ns; i++) {
+      J[i*ns+i] = 1;
+    }
+    for (int j = 0; j < nr; j++) {
+      for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+        F[st.species[k]] += tau*st.delta[k]*ay[j];
+      }
+    }
+    for (int i = 0; i < ns; i++) {
+      double yi = y[i];
+      double h = 1e-7*std::max(fabs(yi), 1.0);
+      y[i] = yi + h;
+      for (int j = 0; j < nr; j++) {
+        if (!leap[j]) {
+          continue;
+        }
+        double derivative = (Model::propensity(ctx, y.data(), j) - ay[j])/h;
+        for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+          J[st.species[k]*ns+i] -= tau*st.delta[k]*derivative;
+        }
+      }
+      y[i] = yi;
+    }
+    // Newton step (F holds -residual)
+    if (!solve_dense(ns, J, F)) {
+      break;
+    }
+    double change = 0;
+    for (int i = 0; i < ns; i++) {
+      y[i] += F[i];
+      change = std::max(change, fabs(F[i])/(fabs(y[i])+1));
+    }
+    if (change < 1e-10) {
+      break;
+    }
+  }
+  for (int j = 0; j < nr; j++) {
+    if (leap[j]) {
+      firings[j] = std::max(0.0, floor(firings[j] + tau*(Model::propensity(ctx, y.data(), j) - ctx.a[j]) + 0.5));
+    }
+  }
+}
+
+// Adaptive tau-leaping (Cao, Gillespie & Petzold 2006; implicit and adaptive explicit-implicit schemes 2007)
+// Every step the reactions that could exhaust a reactant within ncritical firings are treated as critical: they fire at most once per leap,
+// with exact waiting time. All other reactions leap: their firing numbers over tau are drawn from Poisson distributions (explicit) or
+// from the implicit scheme, where tau bounds the relative change of the propensities (epsilon). Reversible pairs in partial equilibrium do not
+// limit the implicit step. Leaps that would make a population negative are rejected and retried with half the step; leaps shorter than a few
+// SSA steps are replaced by exact SSA steps. Leaps end at the samples of the input signal, so the calcium dependent propensities are exact.
+template <typename Model>
+inline void run_tau_leaping(SimulationContext &ctx) {
+  const TauLeapingSettings &settings = ctx.tau;
+  const LeapStructure &ls = ctx.leap;
+  const SparseStoichiometry &st = ctx.stoich;
+  // ------------ Run state ------------
+  ctx.x = ctx.x0;
+  ctx.a.assign(reaction_count<Model>(ctx), 0);
+  ctx.ntimepoint = 0;
+  ctx.noutput = 0;
+  const int ns = species_count<Model>(ctx);
+  const int nr = reaction_count<Model>(ctx);
+  unsigned long long *x = ctx.x.data();
+  std::vector<double> &a = ctx.a;
+  // ------------ Step size selection and firings ------------
+  std::vector<char> critical(nr), leap(nr), leap_im(nr);
+  std::vector<double> mu(ns), sigma2(ns), g(ns);
+  std::vector<double> firings(nr);
+  std::vector<double> change(ns);
+  // ------------ Time variables ------------
+  double currentTime = ctx.timevector[0];
+  ctx.outputTime = currentTime;
+
+  /* SIMULATION LOOP */
+  while (currentTime < ctx.endTime) {
+    if (ctx.check_interrupt) {
+      Rcpp::checkUserInterrupt();
+    }
+    calculate_propensities<Model>(ctx);
+    // Critical and leaping reactions
+    double a0 = 0, a0_critical = 0;
+    for (int j = 0; j < nr; j++) {
+      a0 += a[j];
+      critical[j] = a[j] > 0 && is_critical(ls, j, x, settings.ncritical);
+      leap[j] = a[j] > 0 && !critical[j];
+      if (critical[j]) {
+        a0_critical += a[j];
+      }
+    }
+    // Leap size: explicit, or implicit (reactions in partial equilibrium do not limit the step)
+    double tau1 = select_leap(ls, st, x, a, leap, settings.epsilon, mu, sigma2, g);
+    bool implicit = false;
+    if (settings.scheme != TAU_EXPLICIT) {
+      for (int j = 0; j < nr; j++) {
+        leap_im[j] = leap[j] && !in_partial_equilibrium(ls, a, j, settings.delta);
+      }
+      double tau_im = select_leap(ls, st, x, a, leap_im, settings.epsilon, mu, sigma2, g);
+      implicit = settings.scheme == TAU_IMPLICIT || tau_im > settings.nstiff*tau1;
+      if (implicit) {
+        tau1 = tau_im;
+      }
+    }
+    // Too short leaps: exact SSA steps instead
+    if (tau1 < settings.nssa/a0) {
+      for (unsigned int step = 0; step < settings.ssa_steps && currentTime < ctx.endTime; step++) {
+        tau_leaping_ssa_step<Model>(ctx, currentTime);
+      }
+      continue;
+    }
+    while (true) {
+      // Leap size and critical firing
+      double tau2 = a0_critical > 0 ? ctx.rng.exponential()/a0_critical : std::numeric_limits<double>::infinity();
+      double tau = std::min(tau1, tau2);
+      bool fire_critical = tau2 <= tau1;
+      bool sample_boundary = currentTime+tau >= ctx.timevector[ctx.ntimepoint+1];
+      if (sample_boundary) {
+        tau = ctx.timevector[ctx.ntimepoint+1] - currentTime;
+        fire_critical = false;
+      }
+      // Firings of the leaping reactions
+      for (int j = 0; j < nr; j++) {
+        firings[j] = leap[j] ? ctx.rng.poisson(a[j]*tau) : 0;
+      }
+      if (implicit) {
+        implicit_firings<Model>(ctx, leap, tau, firings);
+      }
+      // One critical reaction
+      if (fire_critical) {
+        double r2 = a0_critical * ctx.rng.uniform();
+        int jc = -1;
+        double sum = 0;
+        for (int j = 0; j < nr; j++) {
+          if (critical[j]) {
+            jc = j;
+            sum += a[j];
+            if (sum >= r2) {
+              break;
+            }
+          }
+        }
+        firings[jc] += 1;
+      }
+      // State change; reject leaps that make a population negative
+      std::fill(change.begin(), change.end(), 0.0);
+      for (int j = 0; j < nr; j++) {
+        if (firings[j] > 0) {
+          for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+            change[st.species[k]] += st.delta[k]*firings[j];
+          }
+        }
+      }
+      bool negative = false;
+      for (int i = 0; i < ns; i++) {
+        negative = negative || (double)x[i] + change[i] < 0;
+      }
+      if (negative) {
+        tau1 /= 2;
+        continue;
+      }
+      // Propagate time
+      currentTime += tau;
+      // Update output
+      update_output(ctx, currentTime, false);
+      // Update system state
+      for (int i = 0; i < ns; i++) {
+        x[i] = (unsigned long long)((long long)x[i] + (long long)change[i]);
+      }
+      if (sample_boundary) {
+        ctx.ntimepoint++;
+      }
+      break;
+    }
+  }
+  // Update output
+  update_output(ctx, currentTime, true);
+}
+
+// Chemical Langevin Equation dX = sum_j v_j a_j(X) dt + sum_j v_j sqrt(a_j(X)) dW_j (Gillespie, J. Chem. Phys. 113, 2000)
+// Real valued particle numbers, integrated with Euler-Maruyama or the Heun predictor-corrector (the drift is averaged over the start and the
+// Euler prediction, the noise is taken at the start as required for the Ito interpretation). The step is fixed ("cle_dt") or chosen like
+// a tau-leap (expected relative change of the reactant species below epsilon); steps end at the samples of the input signal.
+// Particle numbers are kept non-negative by clamping or reflecting the extent of every reaction in a step (see apply_extent).
+template <typename Model>
+inline void run_langevin(SimulationContext &ctx) {
+  const CleSettings &settings = ctx.cle;
+  const SparseStoichiometry &st = ctx.stoich;
+  // ------------ Run state ------------
+  ctx.a.assign(reaction_count<Model>(ctx), 0);
+  ctx.ntimepoint = 0;
+  ctx.noutput = 0;
+  const int ns = species_count<Model>(ctx);
+  const int nr = reaction_count<Model>(ctx);
+  std::vector<double> y(ctx.x0.begin(), ctx.x0.end());
+  std::vector<double> y_new(ns), a_new(nr), noise(nr);
+  std::vector<double> &a = ctx.a;
+  // ------------ Step size control ------------
+  std::vector<char> all_reactions(nr, 1);
+  std::vector<double> mu(ns), sigma2(ns), g(ns);
+  // ------------ Time variables ------------
+  double currentTime = ctx.timevector[0];
+  ctx.outputTime = currentTime;
+
+  /* SIMULATION LOOP */
+  while (currentTime < ctx.endTime) {
+    if (ctx.check_interrupt) {
+      Rcpp::checkUserInterrupt();
+    }
+    for (int j = 0; j < nr; j++) {
+      a[j] = std::max(Model::propensity(ctx, y.data(), j), 0.0);
+    }
+    // Step size (ending at the next sample of the input signal)
+    double dt = settings.dt > 0 ? settings.dt : select_leap(ctx.leap, st, y.data(), a, all_reactions, ctx.tau.epsilon, mu, sigma2, g);
+    bool sample_boundary = currentTime+dt >= ctx.timevector[ctx.ntimepoint+1];
+    if (sample_boundary) {
+      dt = ctx.timevector[ctx.ntimepoint+1] - currentTime;
+    }
+    // Euler-Maruyama step
+    double sqrt_dt = sqrt(dt);
+    y_new = y;
+    for (int j = 0; j < nr; j++) {
+      noise[j] = a[j] > 0 ? sqrt(a[j])*sqrt_dt*ctx.rng.normal() : 0;
+      apply_extent(settings.boundary, st, j, a[j]*dt + noise[j], y_new.data());
+    }
+    // Heun corrector: drift averaged over the start and the predicted state
+    if (settings.scheme == CLE_HEUN) {
+      for (int j = 0; j < nr; j++) {
+        a_new[j] = std::max(Model::propensity(ctx, y_new.data(), j), 0.0);
+      }
+      y_new = y;
+      for (int j = 0; j < nr; j++) {
+        apply_extent(settings.boundary, st, j, 0.5*(a[j] + a_new[j])*dt + noise[j], y_new.data());
+      }
+    }
+    // Propagate time
+    currentTime += dt;
+    // Update output
+    write_output(ctx, y.data(), currentTime, false);
+    // Update system state
+    y.swap(y_new);
+    if (sample_boundary) {
+      ctx.ntimepoint++;
+    }
+  }
+  // Update output
+  write_output(ctx, y.data(), currentTime, true);
+}
+
+// Hybrid SSA/ODE method (Haseltine & Rawlings, J. Chem. Phys. 117, 2002; partitioning similar to Salis & Kaznessis, J. Chem. Phys. 122, 2005)
+// The reactions are repartitioned every step (see partition_reactions): fast reactions of high copy number species are integrated as
+// ODE dy/dt = sum_fast v_j a_j(y) with the Rosenbrock method ROS2 (step size control "rtol", "atol"; stable for the stiff fast subsystems),
+// the slow ones fire exactly: the next one fires when the integral of the total slow propensity along the ODE solution (trapezoidal rule)
+// reaches an exponentially distributed random number, and is chosen in proportion to the propensities at that time. ODE steps end at the
+// predicted firing time (and are shortened by linear interpolation if the integral passes the random number earlier). A changed partition
+// draws a new random number (the waiting time of the slow reactions is memoryless). Steps end at the samples of the input signal.
+template <typename Model>
+inline void run_hybrid(SimulationContext &ctx) {
+  const HybridSettings &settings = ctx.hybrid;
+  const SparseStoichiometry &st = ctx.stoich;
+  // ------------ Run state ------------
+  ctx.a.assign(reaction_count<Model>(ctx), 0);
+  ctx.ntimepoint = 0;
+  ctx.noutput = 0;
+  const int ns = species_count<Model>(ctx);
+  const int nr = reaction_count<Model>(ctx);
+  std::vector<double> y(ctx.x0.begin(), ctx.x0.end());
+  std::vector<double> y_new(ns), a_new(nr);
+  std::vector<double> &a = ctx.a;
+  for (int j = 0; j < nr; j++) {
+    a[j] = std::max(Model::propensity(ctx, y.data(), j), 0.0);
+  }
+  // ------------ Partition ------------
+  std::vector<char> fast(nr, 0), changed(ns);
+  std::vector<unsigned int> fast_reactions, slow_reactions;
+  std::vector<unsigned int> continuous;  // species changed by a fast reaction
+  bool first = true;
+  // ------------ ODE of the fast reactions ------------
+  struct FastDrift {
+    const SimulationContext &ctx;
+    const std::vector<unsigned int> &reactions;
+    FastDrift(const SimulationContext &c, const std::vector<unsigned int> &r) : ctx(c), reactions(r) {}
+    void operator()(const double *y, double *dydt) {
+      const SparseStoichiometry &st = ctx.stoich;
+      std::fill(dydt, dydt+species_count<Model>(ctx), 0.0);
+      for (unsigned int n = 0; n < reactions.size(); n++) {
+        unsigned int j = reactions[n];
+        double aj = std::max(Model::propensity(ctx, y, j), 0.0);
+        for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+          dydt[st.species[k]] += st.delta[k]*aj;
+        }
+      }
+    }
+  } drift(ctx, fast_reactions);
+  RosenbrockWorkspace workspace;
+  double h = 1e-6;
+  // ------------ Slow reactions: integrated total propensity and its threshold ------------
+  double slow_integral = 0;
+  double slow_threshold = ctx.rng.exponential();
+  // ------------ Time variables ------------
+  double currentTime = ctx.timevector[0];
+  ctx.outputTime = currentTime;
+
+  /* SIMULATION LOOP */
+  while (currentTime < ctx.endTime) {
+    if (ctx.check_interrupt) {
+      Rcpp::checkUserInterrupt();
+    }
+    // Repartition
+    if (partition_reactions(st, y.data(), a, settings.threshold, fast) || first) {
+      first = false;
+      fast_reactions.clear();
+      slow_reactions.clear();
+      std::fill(changed.begin(), changed.end(), 0);
+      for (int j = 0; j < nr; j++) {
+        if (fast[j]) {
+          fast_reactions.push_back(j);
+          for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+            changed[st.species[k]] = 1;
+          }
+        } else {
+          slow_reactions.push_back(j);
+        }
+      }
+      continuous.clear();
+      for (int i = 0; i < ns; i++) {
+        if (changed[i]) {
+          continuous.push_back(i);
+        }
+      }
+      slow_integral = 0;
+      slow_threshold = ctx.rng.exponential();
+      workspace.jacobian_valid = false;
+    }
+    double a0_slow = 0;
+    for (unsigned int n = 0; n < slow_reactions.size(); n++) {
+      a0_slow += a[slow_reactions[n]];
+    }
+    // Step: to the sample boundary, the predicted firing of a slow reaction or (ODE) the step size of the error control
+    double sample_time = ctx.timevector[ctx.ntimepoint+1];
+    double dt_slow = a0_slow > 0 ? (slow_threshold - slow_integral)/a0_slow : std::numeric_limits<double>::infinity();
+    double dt = std::min(sample_time - currentTime, dt_slow);
+    bool sample_boundary = dt == sample_time - currentTime;
+    bool fire = !sample_boundary;
+    if (fast_reactions.empty()) {
+      // Exact SSA step: the slow propensities are constant until the next firing or sample
+      slow_integral += a0_slow*dt;
+      y_new = y;
+      a_new = a;
+    } else {
+      if (h < dt) {
+        dt = h;
+        sample_boundary = false;
+        fire = false;
+      }
+      bool shortened = false;
+      while (true) {
+        double error = rosenbrock2_step(drift, ns, continuous, y.data(), dt, settings.rtol, settings.atol, y_new.data(), workspace);
+        if (!(error <= 1)) {
+          dt *= error < std::numeric_limits<double>::infinity() ? std::max(0.2, 0.9/sqrt(error)) : 0.2;
+          h = dt;
+          sample_boundary = false;
+          fire = false;
+          workspace.jacobian_valid = false;
+          continue;
+        }
+        for (int i = 0; i < ns; i++) {
+          y_new[i] = std::max(y_new[i], 0.0);
+        }
+        double a0_slow_new = 0;
+        for (int j = 0; j < nr; j++) {
+          a_new[j] = std::max(Model::propensity(ctx, y_new.data(), j), 0.0);
+          if (!fast[j]) {
+            a0_slow_new += a_new[j];
+          }
+        }
+        double integral = slow_integral + 0.5*dt*(a0_slow + a0_slow_new);
+        if (integral > slow_threshold && !fire && !shortened) {
+          dt *= (slow_threshold - slow_integral)/(integral - slow_integral);
+          sample_boundary = false;
+          fire = true;
+          shortened = true;
+          continue;
+        }
+        if (dt == h) {
+          h = dt*std::min(5.0, 0.9/sqrt(std::max(error, 1e-10)));
+        }
+        slow_integral = integral;
+        break;
+      }
+    }
+    // Propagate time
+    currentTime += dt;
+    // Update output
+    write_output(ctx, y.data(), currentTime, false);
+    // Update system state
+    y.swap(y_new);
+    a.swap(a_new);
+    if (sample_boundary) {
+      ctx.ntimepoint++;
+      for (unsigned int n = 0; n < ctx.deps.calcium_reactions.size(); n++) {
+        unsigned int j = ctx.deps.calcium_reactions[n];
+        a[j] = std::max(Model::propensity(ctx, y.data(), j), 0.0);
+      }
+      workspace.jacobian_valid = false;
+    }
+    // Fire a slow reaction (the propensities depending on the changed species are recalculated)
+    if (fire) {
+      double a0 = 0;
+      for (unsigned int n = 0; n < slow_reactions.size(); n++) {
+        a0 += a[slow_reactions[n]];
+      }
+      if (a0 > 0) {
+        double r2 = a0 * ctx.rng.uniform();
+        unsigned int j = slow_reactions.back();
+        double sum = 0;
+        for (unsigned int n = 0; n < slow_reactions.size(); n++) {
+          sum += a[slow_reactions[n]];
+          if (sum >= r2) {
+            j = slow_reactions[n];
+            break;
+          }
+        }
+        for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+          double &yi = y[st.species[k]];
+          yi = std::max(yi + st.delta[k], 0.0);
+        }
+        for (unsigned int k = ctx.deps.offset[j]; k < ctx.deps.offset[j+1]; k++) {
+          unsigned int r = ctx.deps.reaction[k];
+          a[r] = std::max(Model::propensity(ctx, y.data(), r), 0.0);
+        }
+      }
+      slow_integral = 0;
+      slow_threshold = ctx.rng.exponential();
+    }
+  }
+  // Update output
+  write_output(ctx, y.data(), currentTime, true);
+}
+
+// Deterministic simulation: the reaction rate equations dx/dt = sum_j v_j a_j(x) of the model (the propensities evaluated for real valued
+// particle numbers, so that the right-hand side is the deterministic limit of the stochastic model), integrated with ROS2 or RK45 and error
+// control ("rtol", and "atol" in nmol/l). The input signal is piecewise constant: steps end at its samples (the calcium dependent
+// propensities change there), but the integration continues across them with the step size and Jacobian of the last segment
+// (only f(y) is re-evaluated). The output times do not limit the steps, the solution at them is interpolated (dense output).
+// ROS2 uses the analytic Jacobian of the reaction network (the model's propensity_derivative) and a sparse LU decomposition of its iteration
+// matrix, which is reused while the Jacobian and the step size do not change.
+template <typename Model>
+inline void run_ode(SimulationContext &ctx) {
+  const OdeSettings &settings = ctx.ode;
+  const SparseStoichiometry &st = ctx.stoich;
+  // ------------ Run state ------------
+  ctx.ntimepoint = 0;
+  ctx.noutput = 0;
+  const int ns = species_count<Model>(ctx);
+  std::vector<double> y(ctx.x0.begin(), ctx.x0.end());
+  std::vector<double> y_new(ns);
+  double atol = settings.atol*ctx.f;
+  // ------------ Right-hand side ------------
+  std::vector<unsigned int> active;  // species changed by a reaction
+  for (int i = 0; i < ns; i++) {
+    bool changed = false;
+    for (unsigned int k = 0; k < st.species.size(); k++) {
+      changed = changed || st.species[k] == (unsigned int)i;
+    }
+    if (changed) {
+      active.push_back(i);
+    }
+  }
+  struct ReactionRates {
+    const SimulationContext &ctx;
+    ReactionRates(const SimulationContext &c) : ctx(c) {}
+    void operator()(const double *y, double *dydt) {
+      const SparseStoichiometry &st = ctx.stoich;
+      std::fill(dydt, dydt+species_count<Model>(ctx), 0.0);
+      for (int j = 0; j < reaction_count<Model>(ctx); j++) {
+        double aj = Model::propensity(ctx, y, j);
+        for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+          dydt[st.species[k]] += st.delta[k]*aj;
+        }
+      }
+    }
+  } rates(ctx);
+  // Analytic Jacobian of the active species (ROS2): d f_r / d y_c = sum_j v_rj d a_j / d y_c over the reactions j that change species r
+  // and whose propensity depends on species c (sparse: pattern from the stoichiometry and the propensity dependencies, see get_depM)
+  int m = active.size();
+  std::vector<int> position(ns, -1);  // of a species in active
+  for (int r = 0; r < m; r++) {
+    position[active[r]] = r;
+  }
+  struct ReactionJacobian {
+    const SimulationContext &ctx;
+    const std::vector<int> &position;
+    int m;
+    void operator()(const double *y, const double *f0, double *J) {
+      const SparseStoichiometry &st = ctx.stoich;
+      const DependencyGraph &deps = ctx.deps;
+      for (int j = 0; j < reaction_count<Model>(ctx); j++) {
+        for (unsigned int d = deps.species_offset[j]; d < deps.species_offset[j+1]; d++) {
+          int c = position[deps.species[d]];
+          if (c < 0) {
+            continue;
+          }
+          double da = Model::propensity_derivative(ctx, y, j, deps.species[d]);
+          for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+            J[position[st.species[k]]*m + c] += st.delta[k]*da;
+          }
+        }
+      }
+    }
+  } jacobian = {ctx, position, m};
+  RosenbrockWorkspace rosenbrock;
+  std::vector<char> pattern((size_t)m*m, 0);
+  for (int j = 0; j < reaction_count<Model>(ctx); j++) {
+    for (unsigned int d = ctx.deps.species_offset[j]; d < ctx.deps.species_offset[j+1]; d++) {
+      int c = position[ctx.deps.species[d]];
+      for (unsigned int k = st.offset[j]; c >= 0 && k < st.offset[j+1]; k++) {
+        pattern[position[st.species[k]]*m + c] = 1;
+      }
+    }
+  }
+  sparse_lu_pattern(m, pattern, rosenbrock.lu);
+  DormandPrinceWorkspace dormand_prince;
+  std::vector<double> f_new(ns);  // ROS2: f(y_new) of the dense output
+  std::vector<double> y_out(ns);
+  double order = settings.solver == ODE_RK45 ? 5 : 2;  // (order of the error estimate + 1)
+  // ------------ Time variables ------------
+  double currentTime = ctx.timevector[0];
+  ctx.outputTime = currentTime;
+  double h = 0;
+
+  /* SIMULATION LOOP */
+  while (currentTime < ctx.endTime) {
+    if (ctx.check_interrupt) {
+      Rcpp::checkUserInterrupt();
+    }
+    // Next stop: input sample or end
+    double stop = ctx.endTime;
+    if (ctx.ntimepoint+1 < ctx.timevector.size()) {
+      stop = std::min(stop, ctx.timevector[ctx.ntimepoint+1]);
+    }
+    if (h <= 0) {
+      h = 1e-3*(stop - currentTime);
+    }
+    double dt = std::min(h, stop - currentTime);
+    while (true) {
+      double error = settings.solver == ODE_RK45
+                     ? dormand_prince_step(rates, ns, active, y.data(), dt, settings.rtol, atol, y_new.data(), dormand_prince)
+                     : rosenbrock2_step(rates, jacobian, ns, active, y.data(), dt, settings.rtol, atol, y_new.data(), rosenbrock);
+      if (!(error <= 1)) {
+        dt *= error < std::numeric_limits<double>::infinity() ? std::max(0.2, 0.9*pow(error, -1/order)) : 0.2;
+        h = dt;
+        rosenbrock.jacobian_valid = false;
+        rosenbrock.f0_valid = true;  // (f(y) is unchanged)
+        continue;
+      }
+      if (dt == h) {
+        double factor = std::min(5.0, 0.9*pow(std::max(error, 1e-10), -1/order));
+        // ROS2: keep the step size, and with it the factors of the iteration matrix, unless it can grow substantially
+        if (settings.solver == ODE_RK45 || factor < 1 || factor > 1.2) {
+          h = dt*factor;
+        }
+      }
+      break;
+    }
+    // Propagate time
+    double t_new = dt == stop - currentTime ? stop : currentTime + dt;
+    // Update output (interpolated at the output times of the step)
+    if (settings.solver == ODE_ROSENBROCK) {
+      rates(y_new.data(), f_new.data());
+    }
+    while (ctx.noutput < ctx.nintervals && ctx.outputTime < t_new && ctx.outputTime < ctx.endTime) {
+      double theta = std::max(0.0, (ctx.outputTime - currentTime)/dt);
+      if (settings.solver == ODE_RK45) {
+        dormand_prince_dense(dormand_prince, ns, active, y.data(), y_new.data(), dt, theta, y_out.data());
+      } else {
+        hermite_interpolation(ns, active, y.data(), rosenbrock.f0.data(), y_new.data(), f_new.data(), dt, theta, y_out.data());
+      }
+      write_output_row(ctx, y_out.data());
+    }
+    if (settings.solver == ODE_RK45) {
+      dormand_prince.accept();
+    } else {
+      rosenbrock.f0.swap(f_new);
+      rosenbrock.f0_valid = true;
+    }
+    // Update system state
+    currentTime = t_new;
+    y.swap(y_new);
+    // Calcium dependent propensities change: f(y) of the new segment
+    while (ctx.ntimepoint+1 < ctx.timevector.size() && currentTime >= ctx.timevector[ctx.ntimepoint+1]) {
+      ctx.ntimepoint++;
+      dormand_prince.fsal_valid = false;
+      rosenbrock.f0_valid = false;
+    }
+  }
+  // Update output
+  write_output(ctx, y.data(), currentTime, true);
+}
+
+// Run the simulation method selected in the context
+template <typename Model>
+inline void run_simulation(SimulationContext &ctx) {
+  ctx.search_depth = std::numeric_limits<double>::quiet_NaN();
+  switch (ctx.method) {
+    case METHOD_NRM:
+      run_next_reaction_method<Model>(ctx);
+      break;
+    case METHOD_TAU:
+      run_tau_leaping<Model>(ctx);
+      break;
+    case METHOD_CLE:
+      run_langevin<Model>(ctx);
+      break;
+    case METHOD_HYBRID:
+      run_hybrid<Model>(ctx);
+      break;
+    default:
+      switch (ctx.selection) {
+        case SELECT_BINARY: {
+          CumulativeSelector<true> selector;
+          run_direct_method<Model>(ctx, selector);
+          break;
+        }
+        case SELECT_TREE: {
+          TreeSelector selector;
+          run_direct_method<Model>(ctx, selector);
+          break;
+        }
+        case SELECT_CR: {
+          CompositionRejectionSelector selector;
+          run_direct_method<Model>(ctx, selector);
+          break;
+        }
+        case SELECT_ODM: {
+          ReorderingSelector<false> selector(ctx.warmup);
+          run_direct_method<Model>(ctx, selector);
+          break;
+        }
+        case SELECT_SDM: {
+          ReorderingSelector<true> selector;
+          run_direct_method<Model>(ctx, selector);
+          break;
+        }
+        default: {
+          CumulativeSelector<false> selector;
+          run_direct_method<Model>(ctx, selector);
+        }
+      }
+  }
+}
+
+
+
+// Data frame of the columns of a column-major matrix with nrow rows (one column per name)
+inline DataFrame stacked_data_frame(NumericVector buffer, int nrow, CharacterVector names) {
+  List columns(names.length());
+  for (int c = 0; c < names.length(); c++) {
+    columns[c] = NumericVector(buffer.begin() + (size_t)c*nrow, buffer.begin() + (size_t)(c+1)*nrow);
+  }
+  columns.names() = names;
+  return DataFrame(columns);
+}
+
+// Streaming output to an R function, called with every chunk as data frame (only on the thread running R)
+// Output columns (user_sim_params "output_species": names of the species to output, default all, and "output_type": "double" (default),
+// "float" or "integer", limited to particle numbers up to INT_MAX); returns the output column names
+inline CharacterVector read_output_columns(SimulationContext &ctx, List user_sim_params, NumericVector default_init_conc) {
+  CharacterVector species_names = default_init_conc.names();
+  if (user_sim_params.containsElementNamed("output_species")) {
+    CharacterVector selected = user_sim_params["output_species"];
+    ctx.output_species.clear();
+    for (int n = 0; n < selected.length(); n++) {
+      std::string name = as<std::string>(selected[n]);
+      int xID = 0;
+      while (xID < species_names.length() && as<std::string>(species_names[xID]) != name) {
+        xID++;
+      }
+      if (xID == species_names.length()) {
+        stop("Unknown output species \"" + name + "\".");
+      }
+      ctx.output_species.push_back(xID);
+    }
+  }
+  // (compressed output files store particle numbers)
+  std::string type_name = "double";
+  if (user_sim_params.containsElementNamed("output_format") && as<std::string>(user_sim_params["output_format"]) == "compressed") {
+    type_name = "integer";
+  }
+  if (user_sim_params.containsElementNamed("output_type")) {
+    type_name = as<std::string>(user_sim_params["output_type"]);
+  }
+  if (type_name == "double") {
+    ctx.output_type = OUTPUT_DOUBLE;
+  } else if (type_name == "float") {
+    ctx.output_type = OUTPUT_FLOAT;
+  } else if (type_name == "integer") {
+    ctx.output_type = OUTPUT_INTEGER;
+  } else {
+    stop("Unknown output type \"" + type_name + "\" (use \"double\", \"float\" or \"integer\").");
+  }
+  // compressed output files store the particle numbers as 64 bit integers
+  if (ctx.output_type == OUTPUT_INTEGER && user_sim_params.containsElementNamed("output_format") &&
+      as<std::string>(user_sim_params["output_format"]) == "compressed") {
+    ctx.output_type = OUTPUT_COUNT;
+  }
+  // (particle numbers beyond the int range only fit in the double output or the 64 bit counts of compressed files)
+  if (ctx.output_type == OUTPUT_INTEGER) {
+    for (unsigned int c = 0; c < ctx.output_species.size(); c++) {
+      if (ctx.x0[ctx.output_species[c]] > (unsigned long long)std::numeric_limits<int>::max()) {
+        stop("The particle number of species \"" + as<std::string>(species_names[ctx.output_species[c]]) +
+             "\" exceeds the range of the output type \"integer\" (use \"double\" or the compressed output format).");
+      }
+    }
+  }
+  CharacterVector names(ctx.output_species.size()+2);
+  names[0] = "time";
+  names[1] = "Ca";
+  for (unsigned int c = 0; c < ctx.output_species.size(); c++) {
+    names[c+2] = species_names[ctx.output_species[c]];
+  }
+  return names;
+}
+
+// Output columns of the ensemble and sweep simulators (user_sim_params "output_species" as for simulator()); their results are
+// held in memory as doubles, so the reduced precision output types, summary output and streaming output are rejected
+inline CharacterVector read_parallel_output_columns(SimulationContext &ctx, List user_sim_params, NumericVector default_init_conc,
+                                                   const std::string &simulator_name) {
+  const char *unsupported[] = {"output", "summary_threshold", "output_file", "output_format", "output_callback", "chunk_size"};
+  for (unsigned int n = 0; n < sizeof(unsupported)/sizeof(unsupported[0]); n++) {
+    if (user_sim_params.containsElementNamed(unsupported[n])) {
+      stop("The " + simulator_name + " does not support the simulation parameter \"" + unsupported[n] + "\" (see its output arguments).");
+    }
+  }
+  CharacterVector names = read_output_columns(ctx, user_sim_params, default_init_conc);
+  if (ctx.output_type != OUTPUT_DOUBLE) {
+    stop("The " + simulator_name + " only supports the output type \"double\".");
+  }
+  return names;
+}
+
+// Buffers of the species columns of a reduced precision output type (retval_species, retval_nrow rows)
+inline void allocate_species_output(SimulationContext &ctx, std::vector<float> &float_buffer, std::vector<int> &int_buffer,
+                                    std::vector<int64_t> &count_buffer) {
+  size_t size = (size_t)ctx.retval_nrow*ctx.output_species.size();
+  if (ctx.output_type == OUTPUT_FLOAT) {
+    float_buffer.assign(size, 0);
+    ctx.retval_species = float_buffer.data();
+  } else if (ctx.output_type == OUTPUT_INTEGER) {
+    int_buffer.assign(size, 0);
+    ctx.retval_species = int_buffer.data();
+  } else if (ctx.output_type == OUTPUT_COUNT) {
+    count_buffer.assign(size, 0);
+    ctx.retval_species = count_buffer.data();
+  }
+}
+
+// Data frame of output rows (integer species columns: particle numbers, with the conversion factor to concentrations as attribute "f")
+inline DataFrame chunk_data_frame(const OutputChunk &chunk, CharacterVector names, double f) {
+  List columns(chunk.nspecies+2);
+  for (int c = 0; c < 2; c++) {
+    columns[c] = NumericVector(chunk.values + (size_t)c*chunk.ld, chunk.values + (size_t)c*chunk.ld + chunk.nrow);
+  }
+  for (int c = 0; c < chunk.nspecies; c++) {
+    if (chunk.type == OUTPUT_INTEGER) {
+      const int *values = static_cast<const int *>(chunk.species) + (size_t)c*chunk.ld;
+      columns[c+2] = IntegerVector(values, values + chunk.nrow);
+    } else {
+      NumericVector values(chunk.nrow);
+      for (int r = 0; r < chunk.nrow; r++) {
+        values[r] = chunk.species_value(r, c);
+      }
+      columns[c+2] = values;
+    }
+  }
+  columns.names() = names;
+  DataFrame df(columns);
+  if (chunk.type == OUTPUT_INTEGER || chunk.type == OUTPUT_COUNT) {
+    df.attr("f") = f;
+  }
+  return df;
+}
+
+// Streaming output to an R function, called with every chunk as data frame (only on the thread running R)
+class CallbackSink : public OutputSink {
+public:
+  CallbackSink(Function callback, CharacterVector names, double f) : callback(callback), names(names), f(f) {}
+  void write(const OutputChunk &chunk) {
+    callback(chunk_data_frame(chunk, names, f));
+  }
+private:
+  Function callback;
+  CharacterVector names;
+  double f;
+};
+
+// Streaming output of a run (NULL: the whole output is returned): user_sim_params "output_file" with "output_format" "csv" (default),
+// "binary" (see output_sink.hpp) or "compressed" (see trajectory_file.hpp), or "output_callback";
+// the output is written in chunks of "chunk_size" rows (default 10000)
+template <typename Model>
+inline OutputSink *open_output_sink(const SimulationContext &ctx, List user_sim_params, CharacterVector names, int &chunk_size) {
+  chunk_size = 10000;
+  if (user_sim_params.containsElementNamed("chunk_size")) {
+    chunk_size = as<int>(user_sim_params["chunk_size"]);
+    if (chunk_size < 1) {
+      stop("chunk_size must be positive.");
+    }
+  }
+  if (user_sim_params.containsElementNamed("output_callback")) {
+    return new CallbackSink(as<Function>(user_sim_params["output_callback"]), names, ctx.f);
+  }
+  if (!user_sim_params.containsElementNamed("output_file")) {
+    return NULL;
+  }
+  std::string path = as<std::string>(user_sim_params["output_file"]);
+  std::string format = "csv";
+  if (user_sim_params.containsElementNamed("output_format")) {
+    format = as<std::string>(user_sim_params["output_format"]);
+  }
+  std::vector<std::string> column_names;
+  for (int c = 0; c < names.length(); c++) {
+    column_names.push_back(as<std::string>(names[c]));
+  }
+  if (format == "csv") {
+    return new CsvSink(path, column_names);
+  } else if (format == "binary") {
+    return new BinarySink(path, column_names, ctx.output_type);
+  } else if (format == "compressed") {
+    if (ctx.output_type != OUTPUT_COUNT) {
+      stop("The compressed output format stores particle numbers (output_type \"integer\").");
+    }
+    // header: model, species, volume, parameters, seed and stream of the run
+    TrajectoryMetadata meta;
+    meta.model = Model::name();
+    meta.species.assign(column_names.begin()+2, column_names.end());
+    meta.vol = ctx.vol;
+    meta.f = ctx.f;
+    for (std::map<std::string, double>::const_iterator it = ctx.prop_params.begin(); it != ctx.prop_params.end(); ++it) {
+      meta.param_names.push_back(it->first);
+      meta.param_values.push_back(it->second);
+    }
+    meta.has_seed = ctx.rng.get_type() == RNG_NATIVE;
+    meta.seed = ctx.rng.get_seed();
+    meta.stream = ctx.rng.get_stream();
+    return new CompressedSink(path, meta);
+  }
+  stop("Unknown output format \"" + format + "\" (use \"csv\", \"binary\" or \"compressed\").");
+  return NULL;
+}
+
+// Summary output (user_sim_params "output" = "summary", default "trajectory"): set up the summary statistics of the output species of a run
+// with the concentration thresholds "summary_threshold" (one for all species or one per species, default 0). Returns false for trajectory output.
+inline bool read_summary_settings(const SimulationContext &ctx, List user_sim_params, SummaryStatistics &summary) {
+  std::string output_name = "trajectory";
+  if (user_sim_params.containsElementNamed("output")) {
+    output_name = as<std::string>(user_sim_params["output"]);
+  }
+  if (output_name == "trajectory") {
+    return false;
+  } else if (output_name != "summary") {
+    stop("Unknown output \"" + output_name + "\" (use \"trajectory\" or \"summary\").");
+  }
+  int nspecies = ctx.output_species.size();
+  summary.threshold.assign(nspecies, 0.0);
+  if (user_sim_params.containsElementNamed("summary_threshold")) {
+    NumericVector threshold = user_sim_params["summary_threshold"];
+    if (threshold.length() != 1 && threshold.length() != nspecies) {
+      stop("summary_threshold must have length 1 or one value per output species.");
+    }
+    for (int i = 0; i < nspecies; i++) {
+      summary.threshold[i] = threshold[threshold.length() == 1 ? 0 : i];
+    }
+  }
+  summary.reset(ctx.output_species, ctx.timevector[0], ctx.endTime);
+  return true;
+}
+
+// Result of a run with summary output: one row per species (names: output column names)
+inline DataFrame summary_data_frame(const SummaryStatistics &summary, CharacterVector names) {
+  int n = summary.mean.size();
+  CharacterVector species(n);
+  NumericVector variance(n);
+  double total_time = summary.time - summary.start;
+  for (int i = 0; i < n; i++) {
+    species[i] = names[i+2];
+    variance[i] = total_time > 0 ? summary.m2[i]/total_time : 0;
+  }
+  List columns(7);
+  columns[0] = species;
+  columns[1] = NumericVector(summary.mean.begin(), summary.mean.end());
+  columns[2] = variance;
+  columns[3] = NumericVector(summary.peak.begin(), summary.peak.end());
+  columns[4] = NumericVector(summary.peak_time.begin(), summary.peak_time.end());
+  columns[5] = NumericVector(summary.threshold.begin(), summary.threshold.end());
+  columns[6] = NumericVector(summary.time_above.begin(), summary.time_above.end());
+  columns.names() = CharacterVector::create("species", "mean", "variance", "peak", "peak_time", "threshold", "time_above");
+  DataFrame df(columns);
+  df.attr("time") = total_time;
+  return df;
+}
+
+// Result of a run with streaming output: a data frame without rows, with the number of rows written as attribute "nrow_written"
+inline DataFrame streamed_data_frame(const SimulationContext &ctx, CharacterVector names) {
+  DataFrame df = stacked_data_frame(NumericVector(0), 0, names);
+  df.attr("nrow_written") = ctx.noutput;
+  return df;
+}
+
+
+
+//' Stochastic Simulator (Gillespie's Direct Method or Next Reaction Method).
+//'
+//' Simulate a calcium dependent protein coupled to an input calcium time series using an implementation of Gillespie's Direct Method SSA
+//' or of Gibson and Bruck's Next Reaction Method.
+//'
+//' @param user_input_df A data frame: contains the times of the observations (column "time") and the cytosolic calcium concentration [nmol/l] (column "Ca")
+//'                      (not used if user_sim_params contains an "input_file").
+//' @param user_sim_params A List: contains parameters defining the simulation output times
+//'                        (can either be a) a user supplied vector with sim output time points or b) parameters to generate an evenly spaced sim output times vector:
+//'                        "timestep": the time interval between two output samples, "endTime": the time at which to end the simulation and its output,
+//'                        at most the time of the last input sample).
+//'                        "input_file" reads the input calcium signal natively from a file instead of user_input_df: a binary calcium trace
+//'                        (see write_calcium_trace(), used memory-mapped) or a whitespace delimited text file as the ".out" files (columns "time" and "Ca"
+//'                        of the '#' header line); its calcium values are divided by "input_ca_factor" (default 1, e.g. 6.0221415e14*vol for particle numbers).
+//'                        Optionally, "rng" selects the random number generator: "R" (default, R's global generator as in earlier versions) or
+//'                        "native" (built-in Philox4x32-10 generator; its "seed" and "stream", whole numbers below 2^53, can be supplied, otherwise the seed is drawn from R's generator).
+//'                        "method" selects the simulation method: "direct" (default, Gillespie's Direct Method),
+//'                        "nrm" (Next Reaction Method: only the propensities affected by a firing are recalculated) or
+//'                        "tau" (adaptive tau-leaping, approximate: many firings per step for high particle numbers; "tau_scheme" "explicit", "implicit"
+//'                        or "adaptive" (default, implicit leaps for stiff states), error control "epsilon" (default 0.03) and "ncritical" (default 10):
+//'                        reactions that could exhaust a reactant within ncritical firings are simulated exactly) or
+//'                        "cle" (Chemical Langevin Equation, approximate: continuous particle numbers with Gaussian noise; "cle_scheme" "euler" (default,
+//'                        Euler-Maruyama) or "heun" (predictor-corrector), fixed step "cle_dt" or an adaptive step controlled by "epsilon",
+//'                        "cle_boundary" "clamp" (default) or "reflect": the extent of a reaction in a step is limited to or reflected at the
+//'                        available particles, which keeps the particle numbers non-negative and conserved quantities constant) or
+//'                        "hybrid" (hybrid SSA/ODE: reactions whose reactants and products all have at least "hybrid_threshold" particles (default 100)
+//'                        are integrated as ODE (Rosenbrock method with tolerances "rtol", default 1e-3, and "atol", default 0.1 particles), all others
+//'                        fire exactly; the partition follows the particle numbers during the run).
+//'                        "selection" selects how the Direct Method chooses the reaction to fire: "linear" (default, linear search over the cumulative propensities),
+//'                        "binary" (binary search, same results as "linear"), "tree" (partial sums tree), "cr" (composition-rejection, for large networks),
+//'                        "odm" (Optimized Direct Method: linear search with the reactions sorted by their firing frequency during the first "warmup" firings, default 10000)
+//'                        or "sdm" (Sorting Direct Method: a fired reaction moves one place to the front of the search list).
+//'                        "output_species" selects the species written to the output by name (default all) and "output_type" their values:
+//'                        "double" (default, concentrations), "float" (concentrations in single precision, stored as such in binary output files)
+//'                        or "integer" (particle numbers as integer columns, concentration = particle number/f with f the attribute "f").
+//'                        Streaming output for long runs: with "output_file" the output is written to a file in the "output_format" "csv" (default),
+//'                        "binary" (header "CMLTRAJ1", the number of columns and the output type (0: double, 1: float, 2: integer) as 32 bit integers
+//'                        and the null terminated column names, then the rows: time and Ca as doubles, the species of the output type),
+//'                        or "compressed" (particle numbers, output type "integer", column by column as varint coded differences between
+//'                        consecutive rows, with the model, species, volume, parameters, seed and stream in the header; see read_trajectory()),
+//'                        with "output_callback" a function is called with every chunk as data frame;
+//'                        only "chunk_size" rows (default 10000) are held in memory.
+//'                        With "output" = "summary" (default "trajectory") only summary statistics of the species are returned, accumulated during the run
+//'                        with every state weighted by its exact dwell time (not sampled at the output times): the time-averaged concentration and
+//'                        its variance, the peak concentration and the time it was reached and the time above the concentration "summary_threshold"
+//'                        (one value for all species or one per species, default 0).
+//' @param default_vols A numeric vector: contains updated default values of all volumes [l].
+//' @param default_init_conc A numeric vector: contains updated default values of all initial concentrations [nmol/l].
+//' @param default_params A numeric vector: contains updated default values of all propensity equation parameters.
+//' @param network The reaction network of a model defined at runtime (see network_model(); empty for the compiled models).
+//' @return A dataframe with time and the active protein time series as columns
+//'         (Direct Method: with the average search depth of the reaction selection as attribute "search_depth").
+//'         With "output_species" or a reduced precision "output_type": named columns time, Ca and the output species.
+//'         Streaming output: a data frame without rows, the number of rows written is its attribute "nrow_written".
+//'         Summary output: a data frame with one row per species (columns "species", "mean", "variance", "peak", "peak_time", "threshold" and "time_above")
+//'         and the simulated time as attribute "time".
+//' @examples
+//' simulator()
+template <typename Model>
+DataFrame simulator(DataFrame user_input_df,
+                    List user_sim_params,
+                    NumericVector default_vols,
+                    NumericVector default_init_conc,
+                    NumericVector default_params,
+                    std::shared_ptr<const ReactionNetwork> network = std::shared_ptr<const ReactionNetwork>()) {
+
+  // get R random generator state
+  GetRNGstate();
+
+  // Set up the context of this run
+  SimulationContext ctx;
+  read_input_signal(ctx, user_input_df, user_sim_params);
+  read_sim_params(ctx, user_sim_params);
+  ctx.network = network;
+  load_model<Model>(ctx, default_vols, default_init_conc, default_params);
+  ctx.check_interrupt = true;
+
+  // Output columns and summary output (statistics of the species accumulated during the run instead of the trajectory)
+  CharacterVector names = read_output_columns(ctx, user_sim_params, default_init_conc);
+  SummaryStatistics summary;
+  if (read_summary_settings(ctx, user_sim_params, summary)) {
+    ctx.summary = &summary;
+  }
+
+  // Define return value (numeric matrix; no. of rows = no. of output time point; no. of cols. = time + ca + no. of output species)
+  // or, for streaming output, the buffer of one chunk (no rows for summary output); the species of a reduced precision output type
+  // are buffered separately
+  ctx.nintervals = ctx.summary ? 0 : count_output_intervals(ctx);
+  int chunk_size;
+  std::unique_ptr<OutputSink> sink(ctx.summary ? NULL : open_output_sink<Model>(ctx, user_sim_params, names, chunk_size));
+  int ncol = ctx.output_type == OUTPUT_DOUBLE ? names.length() : 2;
+  NumericMatrix retval(sink ? std::min(chunk_size, ctx.nintervals) : ctx.nintervals, ncol);
+  ctx.retval = retval.begin();
+  ctx.retval_nrow = retval.nrow();
+  std::vector<float> float_buffer;
+  std::vector<int> int_buffer;
+  std::vector<int64_t> count_buffer;
+  allocate_species_output(ctx, float_buffer, int_buffer, count_buffer);
+  ctx.sink = sink.get();
+
+  // Simulate
+  run_simulation<Model>(ctx);
+  if (sink) {
+    flush_output(ctx);
+    sink->close();
+  }
+
+  // Send random generator state back to R
+  PutRNGstate();
+
+  // Convert NumericMatrix retval to DataFrame (with column names for a selection of the species or a reduced precision output type)
+  DataFrame df_retval;
+  if (ctx.summary) {
+    df_retval = summary_data_frame(summary, names);
+  } else if (sink) {
+    df_retval = streamed_data_frame(ctx, names);
+  } else if (user_sim_params.containsElementNamed("output_species") || ctx.output_type != OUTPUT_DOUBLE) {
+    df_retval = chunk_data_frame(buffered_output(ctx), names, ctx.f);
+  } else {
+    df_retval = DataFrame(retval);
+  }
+  // Record the seed of native runs (for reproduction with user_sim_params "seed")
+  if (ctx.rng.get_type() == RNG_NATIVE) {
+    df_retval.attr("seed") = (double)ctx.rng.get_seed();
+  }
+  if (ctx.method == METHOD_DIRECT) {
+    df_retval.attr("search_depth") = ctx.search_depth;
+  }
+
+  return df_retval;
+}
+
+
+
+//' Stochastic Ensemble Simulator.
+//'
+//' Simulate n_replicates independent realisations of the model coupled to the same input calcium time series
+//' (simulation method as for simulator()) on a pool of threads.
+//' Every replicate uses its own stream of the native random number generator: replicate r (counted from 0) uses
+//' stream "stream" + r of seed "seed" (the seed is drawn from R's generator if not supplied), so results do not depend on the number of threads.
+//'
+//' @param user_input_df A data frame: contains the times of the observations (column "time") and the cytosolic calcium concentration [nmol/l] (column "Ca")
+//'                      (not used if user_sim_params contains an "input_file", see simulator()).
+//' @param user_sim_params A List: simulation output times as for simulator() (plus optional "seed", "stream" and "output_species";
+//'                        the output types and the summary and streaming output of simulator() are not supported).
+//' @param default_vols A numeric vector: contains updated default values of all volumes [l].
+//' @param default_init_conc A numeric vector: contains updated default values of all initial concentrations [nmol/l].
+//' @param default_params A numeric vector: contains updated default values of all propensity equation parameters.
+//' @param n_replicates An integer: the number of replicates.
+//' @param threads An integer: the number of threads (<= 0: all available cores).
+//' @param output_format A string: "long" for a data frame of the stacked replicates (column "replicate", counted from 1, followed by time, Ca and the species)
+//'                      or "array" for a 3-D array (output times x (time, Ca, species) x replicates).
+//' @param network The reaction network of a model defined at runtime (see network_model(); empty for the compiled models).
+//' @return The replicates in the chosen output format (with the seed as attribute "seed" and, for the Direct Method,
+//'         the average search depth of the reaction selection of every replicate as attribute "search_depth").
+template <typename Model>
+RObject ensemble_simulator(DataFrame user_input_df,
+                           List user_sim_params,
+                           NumericVector default_vols,
+                           NumericVector default_init_conc,
+                           NumericVector default_params,
+                           int n_replicates,
+                           int threads,
+                           std::string output_format,
+                           std::shared_ptr<const ReactionNetwork> network = std::shared_ptr<const ReactionNetwork>()) {
+
+  if (n_replicates < 1) {
+    stop("n_replicates must be at least 1.");
+  }
+  if (output_format != "long" && output_format != "array") {
+    stop("Unknown output format \"" + output_format + "\" (use \"long\" or \"array\").");
+  }
+
+  // Set up the context shared by all replicates (seed and stream of the native generator, drawn from R's generator if not supplied)
+  GetRNGstate();
+  SimulationContext base;
+  read_input_signal(base, user_input_df, user_sim_params);
+  read_sim_params(base, user_sim_params);
+  base.network = network;
+  load_model<Model>(base, default_vols, default_init_conc, default_params);
+  uint64_t seed = base.rng.get_type() == RNG_NATIVE ? base.rng.get_seed() : seed_from_r();
+  if (user_sim_params.containsElementNamed("seed")) {
+    seed = read_seed(as<double>(user_sim_params["seed"]), "seed");
+  }
+  uint64_t stream = base.rng.get_stream();
+  PutRNGstate();
+  base.check_interrupt = false;
+  base.nintervals = count_output_intervals(base);
+  CharacterVector colnames = read_parallel_output_columns(base, user_sim_params, default_init_conc, "ensemble simulator");
+  int ncols = colnames.length();
+
+  // Output buffer: stacked matrix (replicate blocks of rows, plus a replicate column) or 3-D array (one slice per replicate)
+  NumericVector retval;
+  double *first;
+  int retval_nrow;
+  int replicate_offset;
+  if (output_format == "long") {
+    retval_nrow = n_replicates*base.nintervals;
+    retval = NumericVector(retval_nrow*(ncols+1));
+    for (int r = 0; r < n_replicates; r++) {
+      std::fill(retval.begin() + r*base.nintervals, retval.begin() + (r+1)*base.nintervals, (double)(r+1));
+    }
+    first = retval.begin() + retval_nrow;
+    replicate_offset = base.nintervals;
+  } else {
+    retval_nrow = base.nintervals;
+    retval = NumericVector(base.nintervals*ncols*n_replicates);
+    first = retval.begin();
+    replicate_offset = base.nintervals*ncols;
+  }
+
+  // Simulate the replicates (worker threads only touch their own context and output block)
+  struct ReplicateTask {
+    const SimulationContext *base;
+    uint64_t seed;
+    uint64_t stream;
+    double *first;
+    int retval_nrow;
+    int replicate_offset;
+    double *search_depth;
+    void operator()(int r) {
+      SimulationContext ctx = *base;
+      ctx.rng.use_native(seed, stream + r);
+      ctx.retval = first + (size_t)r*replicate_offset;
+      ctx.retval_nrow = retval_nrow;
+      run_simulation<Model>(ctx);
+      search_depth[r] = ctx.search_depth;
+    }
+  };
+  NumericVector search_depth(n_replicates);
+  ReplicateTask task = {&base, seed, stream, first, retval_nrow, replicate_offset, search_depth.begin()};
+  try {
+    parallel_for(n_replicates, threads, task);
+  } catch (std::exception &e) {
+    stop(std::string("Ensemble simulation failed: ") + e.what());
+  }
+
+  if (output_format == "array") {
+    retval.attr("dim") = IntegerVector::create(base.nintervals, ncols, n_replicates);
+    retval.attr("dimnames") = List::create(R_NilValue, colnames, R_NilValue);
+    retval.attr("seed") = (double)seed;
+    if (base.method == METHOD_DIRECT) {
+      retval.attr("search_depth") = search_depth;
+    }
+    return retval;
+  }
+  CharacterVector names(ncols+1);
+  names[0] = "replicate";
+  for (int c = 0; c < ncols; c++) {
+    names[c+1] = colnames[c];
+  }
+  DataFrame df_retval = stacked_data_frame(retval, retval_nrow, names);
+  df_retval.attr("seed") = (double)seed;
+  if (base.method == METHOD_DIRECT) {
+    df_retval.attr("search_depth") = search_depth;
+  }
+  return df_retval;
+}
+
+
+
+//' Parallel Parameter Sweep.
+//'
+//' Simulate the model once for every row of a table of parameter sets (simulation method as for simulator()) on a pool of threads.
+//' The columns of param_sets are named like the entries of the default volumes ("vol"), initial conditions or propensity equation parameters
+//' and replace these values row by row; the names are resolved once before the simulations start. An optional column "seed"
+//' sets the seed of the native random number generator per row. Row r (counted from 0) uses stream "stream" + r, so results do not depend on the number of threads.
+//'
+//' @param user_input_df A data frame: contains the times of the observations (column "time") and the cytosolic calcium concentration [nmol/l] (column "Ca")
+//'                      (not used if user_sim_params contains an "input_file", see simulator()).
+//' @param user_sim_params A List: simulation output times as for simulator() (plus optional "seed", "stream" and "output_species";
+//'                        the output types and the summary and streaming output of simulator() are not supported).
+//' @param default_vols A numeric vector: contains updated default values of all volumes [l].
+//' @param default_init_conc A numeric vector: contains updated default values of all initial concentrations [nmol/l].
+//' @param default_params A numeric vector: contains updated default values of all propensity equation parameters.
+//' @param param_sets A data frame: one parameter set per row.
+//' @param threads An integer: the number of threads (<= 0: all available cores).
+//' @param output A string: "summary" for one row per parameter set (column "set", counted from 1, followed by the time average ("<species>_mean")
+//'               and final value ("<species>_final") of every output species over the output time points)
+//'               or "trajectory" for a data frame of the stacked trajectories (column "set" followed by time, Ca and the output species).
+//' @param network The reaction network of a model defined at runtime (see network_model(); empty for the compiled models).
+//' @return The sweep result in the chosen output format (with the seed as attribute "seed").
+template <typename Model>
+RObject sweep_simulator(DataFrame user_input_df,
+                        List user_sim_params,
+                        NumericVector default_vols,
+                        NumericVector default_init_conc,
+                        NumericVector default_params,
+                        DataFrame param_sets,
+                        int threads,
+                        std::string output,
+                        std::shared_ptr<const ReactionNetwork> network = std::shared_ptr<const ReactionNetwork>()) {
+
+  if (output != "summary" && output != "trajectory") {
+    stop("Unknown output \"" + output + "\" (use \"summary\" or \"trajectory\").");
+  }
+  int nsets = param_sets.nrows();
+  if (nsets < 1) {
+    stop("param_sets must contain at least one row.");
+  }
+
+  // Set up the context shared by all parameter sets (as for the ensemble simulator)
+  GetRNGstate();
+  SimulationContext base;
+  read_input_signal(base, user_input_df, user_sim_params);
+  read_sim_params(base, user_sim_params);
+  base.network = network;
+  load_model<Model>(base, default_vols, default_init_conc, default_params);
+  uint64_t seed = base.rng.get_type() == RNG_NATIVE ? base.rng.get_seed() : seed_from_r();
+  if (user_sim_params.containsElementNamed("seed")) {
+    seed = read_seed(as<double>(user_sim_params["seed"]), "seed");
+  }
+  uint64_t stream = base.rng.get_stream();
+  PutRNGstate();
+  base.check_interrupt = false;
+  base.nintervals = count_output_intervals(base);
+  CharacterVector colnames = read_parallel_output_columns(base, user_sim_params, default_init_conc, "parameter sweep");
+  int ncols = colnames.length();
+
+  // Resolve the column names of param_sets once: every column replaces one entry of the volume, initial condition or parameter vector
+  // (kind 0: volume, 1: initial condition, 2: parameter, 3: seed)
+  CharacterVector set_names = param_sets.names();
+  int nsetcols = set_names.length();
+  std::vector<int> kind(nsetcols);
+  std::vector<int> index(nsetcols);
+  std::vector<const double *> column(nsetcols);
+  NumericVector defaults[3] = {default_vols, default_init_conc, default_params};
+  std::vector<NumericVector> set_columns(nsetcols);
+  for (int c = 0; c < nsetcols; c++) {
+    std::string current_name = as<std::string>(set_names[c]);
+    kind[c] = -1;
+    if (current_name == "seed") {
+      kind[c] = 3;
+    }
+    for (int v = 0; v < 3; v++) {
+      CharacterVector default_names = defaults[v].names();
+      for (int i = 0; i < default_names.length(); i++) {
+        if (current_name == as<std::string>(default_names[i])) {
+          if (kind[c] != -1) {
+            stop("Ambiguous parameter set column \"" + current_name + "\".");
+          }
+          kind[c] = v;
+          index[c] = i;
+        }
+      }
+    }
+    if (kind[c] == -1) {
+      stop("No such index: parameter set column \"" + current_name + "\" is not a volume, initial condition or parameter of the model.");
+    }
+    set_columns[c] = as<NumericVector>(param_sets[c]);
+    column[c] = set_columns[c].begin();
+    if (kind[c] == 3) {
+      for (int r = 0; r < set_columns[c].length(); r++) {
+        read_seed(set_columns[c][r], "seed");
+      }
+    }
+  }
+
+  // Default values as plain vectors (copied and modified per parameter set on the worker threads)
+  std::vector<double> vols(default_vols.begin(), default_vols.end());
+  std::vector<double> init_conc(default_init_conc.begin(), default_init_conc.end());
+  std::vector<double> params(default_params.begin(), default_params.end());
+  CharacterVector default_params_names = default_params.names();
+  std::vector<std::string> param_names(default_params.length());
+  for (int n = 0; n < default_params.length(); n++) {
+    param_names[n] = as<std::string>(default_params_names[n]);
+  }
+
+  // Output buffer: stacked trajectories (plus a set column) or the summary matrix (set, mean and final value of every output species)
+  bool summary = (output == "summary");
+  int retval_nrow = summary ? nsets : nsets*base.nintervals;
+  int retval_ncol = summary ? 2*(ncols-2)+1 : ncols+1;
+  NumericVector retval(retval_nrow*retval_ncol);
+  for (int r = 0; r < nsets; r++) {
+    if (summary) {
+      retval[r] = r+1;
+    } else {
+      std::fill(retval.begin() + r*base.nintervals, retval.begin() + (r+1)*base.nintervals, (double)(r+1));
+    }
+  }
+
+  // Simulate the parameter sets (worker threads only touch their own context and output rows)
+  struct SweepTask {
+    const SimulationContext *base;
+    uint64_t seed;
+    uint64_t stream;
+    const std::vector<int> *kind;
+    const std::vector<int> *index;
+    const std::vector<const double *> *column;
+    const std::vector<double> *vols;
+    const std::vector<double> *init_conc;
+    const std::vector<double> *params;
+    const std::vector<std::string> *param_names;
+    bool summary;
+    double *retval;
+    int retval_nrow;
+    void operator()(int r) {
+      SimulationContext ctx = *base;
+      // values of this parameter set
+      std::vector<double> set_vols(*vols), set_init_conc(*init_conc), set_params(*params);
+      std::vector<double> *values[3] = {&set_vols, &set_init_conc, &set_params};
+      uint64_t set_seed = seed;
+      for (unsigned int c = 0; c < kind->size(); c++) {
+        double value = (*column)[c][r];
+        if ((*kind)[c] == 3) {
+          set_seed = (uint64_t)value;
+        } else {
+          (*values[(*kind)[c]])[(*index)[c]] = value;
+        }
+      }
+      set_model_values<Model>(ctx, set_vols[0], set_init_conc, *param_names, set_params);
+      ctx.rng.use_native(set_seed, stream + r);
+      // simulate into the output rows of this set, or into a scratch matrix to be summarised
+      std::vector<double> trajectory;
+      int noutput_species = ctx.output_species.size();
+      if (summary) {
+        trajectory.assign((size_t)ctx.nintervals*(noutput_species+2), 0);
+        ctx.retval = trajectory.data();
+        ctx.retval_nrow = ctx.nintervals;
+      } else {
+        ctx.retval = retval + retval_nrow + (size_t)r*ctx.nintervals;
+        ctx.retval_nrow = retval_nrow;
+      }
+      run_simulation<Model>(ctx);
+      if (summary) {
+        for (int c = 0; c < noutput_species; c++) {
+          const double *species = ctx.retval + (size_t)(c+2)*ctx.nintervals;
+          double sum = 0;
+          for (int t = 0; t < ctx.nintervals; t++) {
+            sum += species[t];
+          }
+          retval[(size_t)(2*c+1)*retval_nrow + r] = sum/ctx.nintervals;
+          retval[(size_t)(2*c+2)*retval_nrow + r] = species[ctx.nintervals-1];
+        }
+      }
+    }
+  };
+  SweepTask task = {&base, seed, stream, &kind, &index, &column, &vols, &init_conc, &params, &param_names,
+                    summary, retval.begin(), retval_nrow};
+  try {
+    parallel_for(nsets, threads, task);
+  } catch (std::exception &e) {
+    stop(std::string("Parameter sweep failed: ") + e.what());
+  }
+
+  CharacterVector names(retval_ncol);
+  names[0] = "set";
+  if (summary) {
+    for (int c = 0; c < ncols-2; c++) {
+      names[2*c+1] = as<std::string>(colnames[c+2]) + "_mean";
+      names[2*c+2] = as<std::string>(colnames[c+2]) + "_final";
+    }
+  } else {
+    for (int c = 0; c < ncols; c++) {
+      names[c+1] = colnames[c];
+    }
+  }
+  DataFrame df_retval = stacked_data_frame(retval, retval_nrow, names);
+  df_retval.attr("seed") = (double)seed;
+  return df_retval;
+}
+
+
+
+//' Deterministic Simulator.
+//'
+//' Integrate the reaction rate equations of the model coupled to an input calcium time series. The right-hand side is the deterministic limit
+//' of the stochastic model simulated by simulator() (same propensities, stoichiometry, parameters and initial conditions, with real valued particle numbers).
+//' The calcium signal is constant between its observations; the integrator keeps its step size across them and interpolates the solution at the output times.
+//'
+//' @param user_input_df A data frame: contains the times of the observations (column "time") and the cytosolic calcium concentration [nmol/l] (column "Ca")
+//'                      (not used if user_sim_params contains an "input_file", see simulator()).
+//' @param user_sim_params A List: simulation output times as for simulator(). Optionally, "solver" selects the integrator: "rosenbrock" (default,
+//'                        L-stable Rosenbrock method ROS2 for stiff models) or "rk45" (Runge-Kutta method of Dormand and Prince for non-stiff models);
+//'                        "rtol" (default 1e-6) and "atol" (default 1e-6 nmol/l) are the relative and absolute error tolerances.
+//'                        Output species and types ("output_species", "output_type") and streaming output ("output_file", "output_format",
+//'                        "output_callback", "chunk_size") as for simulator().
+//' @param default_vols A numeric vector: contains updated default values of all volumes [l].
+//' @param default_init_conc A numeric vector: contains updated default values of all initial concentrations [nmol/l].
+//' @param default_params A numeric vector: contains updated default values of all propensity equation parameters.
+//' @param network The reaction network of a model defined at runtime (see network_model(); empty for the compiled models).
+//' @return A data frame with the output times, the input calcium concentration and the concentrations of all species [nmol/l] as columns (as detSim_<model>;
+//'         streaming output: without rows, as for simulator()).
+template <typename Model>
+DataFrame det_simulator(DataFrame user_input_df,
+                        List user_sim_params,
+                        NumericVector default_vols,
+                        NumericVector default_init_conc,
+                        NumericVector default_params,
+                        std::shared_ptr<const ReactionNetwork> network = std::shared_ptr<const ReactionNetwork>()) {
+
+  // Set up the context of this run
+  SimulationContext ctx;
+  read_input_signal(ctx, user_input_df, user_sim_params);
+  read_output_times(ctx, user_sim_params);
+  std::string solver_name = "rosenbrock";
+  if (user_sim_params.containsElementNamed("solver")) {
+    solver_name = as<std::string>(user_sim_params["solver"]);
+  }
+  if (solver_name == "rosenbrock") {
+    ctx.ode.solver = ODE_ROSENBROCK;
+  } else if (solver_name == "rk45") {
+    ctx.ode.solver = ODE_RK45;
+  } else {
+    stop("Unknown ODE solver \"" + solver_name + "\" (use \"rosenbrock\" or \"rk45\").");
+  }
+  ctx.ode.rtol = 1e-6;
+  if (user_sim_params.containsElementNamed("rtol")) {
+    ctx.ode.rtol = as<double>(user_sim_params["rtol"]);
+  }
+  ctx.ode.atol = 1e-6;
+  if (user_sim_params.containsElementNamed("atol")) {
+    ctx.ode.atol = as<double>(user_sim_params["atol"]);
+  }
+  if (!(ctx.ode.rtol > 0) || !(ctx.ode.atol > 0)) {
+    stop("rtol and atol must be positive.");
+  }
+  ctx.network = network;
+  load_model<Model>(ctx, default_vols, default_init_conc, default_params);
+  ctx.check_interrupt = true;
+
+  // Define return value (columns time, calcium and output species) or, for streaming output, the buffer of one chunk
+  ctx.nintervals = count_output_intervals(ctx);
+  int chunk_size;
+  CharacterVector names = read_output_columns(ctx, user_sim_params, default_init_conc);
+  std::unique_ptr<OutputSink> sink(open_output_sink<Model>(ctx, user_sim_params, names, chunk_size));
+  ctx.retval_nrow = sink ? std::min(chunk_size, ctx.nintervals) : ctx.nintervals;
+  int ncol = ctx.output_type == OUTPUT_DOUBLE ? names.length() : 2;
+  std::vector<double> retval((size_t)ctx.retval_nrow*ncol);
+  ctx.retval = retval.data();
+  std::vector<float> float_buffer;
+  std::vector<int> int_buffer;
+  std::vector<int64_t> count_buffer;
+  allocate_species_output(ctx, float_buffer, int_buffer, count_buffer);
+  ctx.sink = sink.get();
+
+  // Integrate
+  run_ode<Model>(ctx);
+  if (sink) {
+    flush_output(ctx);
+    sink->close();
+    return streamed_data_frame(ctx, names);
+  }
+
+  OutputChunk output = buffered_output(ctx);
+  output.nrow = ctx.nintervals;
+  return chunk_data_frame(output, names, ctx.f);
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef SPARSE_LU_HPP
+#define SPARSE_LU_HPP
+
+#include <vector>
+
+
+// LU decomposition of n x n matrices with a fixed sparsity pattern (e.g. the iteration matrices I - gamma h J of a reaction network),
+// without pivoting: the pattern of the factors (fill-in included) is computed once, every factorization and solve only visits its entries.
+// The diagonal is factored in its natural order, which is stable for the diagonally dominant iteration matrices of small steps
+// (a zero pivot is reported, callers then retry with a smaller step).
+// The values are stored densely (row-major, overwritten by L and U).
+struct SparseLU {
+  int n;
+  std::vector<double> A;
+  std::vector<unsigned int> lower_offset;  // row i of L (below the unit diagonal): columns lower[k], k in [lower_offset[i], lower_offset[i+1]), ascending
+  std::vector<unsigned int> lower;
+  std::vector<unsigned int> upper_offset;  // row i of U (right of the diagonal): columns upper[k], k in [upper_offset[i], upper_offset[i+1])
+  std::vector<unsigned int> upper;
+  SparseLU() : n(0) {}
+};
+
+
+// Symbolic factorization: pattern of L and U for the nonzero pattern of A (row-major n x n, the diagonal is always included)
+inline void sparse_lu_pattern(int n, std::vector<char> pattern, SparseLU &lu) {
+  for (int i = 0; i < n; i++) {
+    pattern[i*n+i] = 1;
+  }
+  // fill-in of the elimination
+  for (int k = 0; k < n; k++) {
+    for (int i = k+1; i < n; i++) {
+      if (!pattern[i*n+k]) {
+        continue;
+      }
+      for (int c = k+1; c < n; c++) {
+        if (pattern[k*n+c]) {
+          pattern[i*n+c] = 1;
+        }
+      }
+    }
+  }
+  lu.n = n;
+  lu.A.assign((size_t)n*n, 0.0);
+  lu.lower_offset.assign(n+1, 0);
+  lu.upper_offset.assign(n+1, 0);
+  lu.lower.clear();
+  lu.upper.clear();
+  for (int i = 0; i < n; i++) {
+    for (int c = 0; c < n; c++) {
+      if (pattern[i*n+c] && c < i) {
+        lu.lower.push_back(c);
+      } else if (pattern[i*n+c] && c > i) {
+        lu.upper.push_back(c);
+      }
+    }
+    lu.lower_offset[i+1] = lu.lower.size();
+    lu.upper_offset[i+1] = lu.upper.size();
+  }
+}
+
+
+// Numeric factorization of lu.A (entries outside the pattern must be zero). Returns false for a zero pivot.
+inline bool sparse_lu_factor(SparseLU &lu) {
+  int n = lu.n;
+  double *A = lu.A.data();
+  for (int i = 0; i < n; i++) {
+    for (unsigned int l = lu.lower_offset[i]; l < lu.lower_offset[i+1]; l++) {
+      unsigned int k = lu.lower[l];
+      double factor = A[i*n+k] /= A[k*n+k];
+      if (factor == 0) {
+        continue;
+      }
+      for (unsigned int u = lu.upper_offset[k]; u < lu.upper_offset[k+1]; u++) {
+        A[i*n+lu.upper[u]] -= factor*A[k*n+lu.upper[u]];
+      }
+    }
+    if (A[i*n+i] == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+// Solve A z = b with the factors of sparse_lu_factor (z returned in b)
+inline void sparse_lu_solve(const SparseLU &lu, double *b) {
+  int n = lu.n;
+  const double *A = lu.A.data();
+  for (int i = 0; i < n; i++) {
+    double sum = b[i];
+    for (unsigned int l = lu.lower_offset[i]; l < lu.lower_offset[i+1]; l++) {
+      sum -= A[i*n+lu.lower[l]]*b[lu.lower[l]];
+    }
+    b[i] = sum;
+  }
+  for (int i = n-1; i >= 0; i--) {
+    double sum = b[i];
+    for (unsigned int u = lu.upper_offset[i]; u < lu.upper_offset[i+1]; u++) {
+      sum -= A[i*n+lu.upper[u]]*b[lu.upper[u]];
+    }
+    b[i] = sum/A[i*n+i];
+  }
+}
+
+#endif
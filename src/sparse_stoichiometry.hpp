@@ -0,0 +1,46 @@
+#ifndef SPARSE_STOICHIOMETRY_HPP
+#define SPARSE_STOICHIOMETRY_HPP
+
+#include <vector>
+#include <Rcpp.h>
+
+
+// Sparse representation of a stoichiometric matrix (compressed by reaction):
+// firing reaction j changes species[k] by delta[k] for all k in [offset[j], offset[j+1]).
+// Built once per simulation run from the dense matrix returned by the model's get_stM(),
+// so that a reaction firing only touches the (usually one to three) affected species.
+struct SparseStoichiometry {
+  std::vector<unsigned int> offset;
+  std::vector<unsigned int> species;
+  std::vector<long long> delta;
+};
+
+
+// Compile the dense stoichiometric matrix (rows = species, columns = reactions) into its sparse form.
+inline void compile_stoichiometry(Rcpp::NumericMatrix stM, SparseStoichiometry &st) {
+  int nrow = stM.nrow();
+  int ncol = stM.ncol();
+  st.offset.assign(ncol+1, 0);
+  st.species.clear();
+  st.delta.clear();
+  for (int j = 0; j < ncol; j++) {
+    for (int i = 0; i < nrow; i++) {
+      if (stM(i, j) != 0) {
+        st.species.push_back(i);
+        st.delta.push_back((long long)stM(i, j));
+      }
+    }
+    st.offset[j+1] = st.species.size();
+  }
+}
+
+
+// Apply the state change of reaction rIndex to the particle numbers x.
+// (adding a negative delta to an unsigned particle number wraps around as intended)
+inline void fire_reaction(const SparseStoichiometry &st, unsigned int rIndex, unsigned long long *x) {
+  for (unsigned int k = st.offset[rIndex]; k < st.offset[rIndex+1]; k++) {
+    x[st.species[k]] += (unsigned long long)st.delta[k];
+  }
+}
+
+#endif
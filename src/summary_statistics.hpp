@@ -0,0 +1,65 @@
+#ifndef SUMMARY_STATISTICS_HPP
+#define SUMMARY_STATISTICS_HPP
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+
+// Summary statistics of the species concentrations over a simulation run (user_sim_params "output" = "summary"),
+// accumulated online instead of the trajectory. Every state is weighted by its exact dwell time, i.e. the time until the next
+// change of the state, which the simulation methods report through the output (write_output), not by sampling on the output grid.
+// Mean and variance use the weighted form of Welford's algorithm (West, Commun. ACM 22, 1979).
+struct SummaryStatistics {
+  double start;                    // start of the accumulation (first sample of the input signal)
+  double time;                     // time up to which the trajectory has been accumulated
+  double end;                      // end of the accumulation (endTime)
+  std::vector<int> species;        // indices of the species
+  std::vector<double> threshold;   // concentration thresholds of the species [nmol/l]
+  std::vector<double> mean;        // time-averaged concentrations [nmol/l]
+  std::vector<double> m2;          // weighted sums of squared deviations from the mean (variance = m2/total time)
+  std::vector<double> peak;        // maximum concentrations [nmol/l] ...
+  std::vector<double> peak_time;   // ... and the times they were first reached
+  std::vector<double> time_above;  // total time above the threshold [s]
+
+  // Start the accumulation for the given species (the thresholds are set by the caller)
+  void reset(const std::vector<int> &species_indices, double start_time, double end_time) {
+    int nspecies = species_indices.size();
+    species = species_indices;
+    start = start_time;
+    time = start_time;
+    end = end_time;
+    mean.assign(nspecies, 0.0);
+    m2.assign(nspecies, 0.0);
+    peak.assign(nspecies, -std::numeric_limits<double>::infinity());
+    peak_time.assign(nspecies, start_time);
+    time_above.assign(nspecies, 0.0);
+  }
+
+  // Accumulate the state x (particle numbers, f: particles per concentration unit) from the current time until t
+  template <typename T>
+  void add(const T *x, double f, double t) {
+    double t_end = std::min(t, end);
+    double w = t_end - time;
+    if (w <= 0) {
+      return;
+    }
+    double total = t_end - start;
+    for (unsigned int i = 0; i < species.size(); i++) {
+      double c = x[species[i]]/f;
+      double delta = c - mean[i];
+      mean[i] += w/total*delta;
+      m2[i] += w*delta*(c - mean[i]);
+      if (c > peak[i]) {
+        peak[i] = c;
+        peak_time[i] = time;
+      }
+      if (c > threshold[i]) {
+        time_above[i] += w;
+      }
+    }
+    time = t_end;
+  }
+};
+
+#endif
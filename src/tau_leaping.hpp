@@ -0,0 +1,193 @@
+#ifndef TAU_LEAPING_HPP
+#define TAU_LEAPING_HPP
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "sparse_stoichiometry.hpp"
+
+
+// Tau-leaping schemes (user_sim_params "tau_scheme")
+enum TauScheme {
+  TAU_EXPLICIT,  // "explicit": explicit tau-leaping with the step size selection of Cao, Gillespie & Petzold (J. Chem. Phys. 124, 2006)
+  TAU_IMPLICIT,  // "implicit": implicit tau-leaping (Rathinam et al., J. Chem. Phys. 119, 2003) for stiff systems
+  TAU_ADAPTIVE   // "adaptive": explicit or implicit leap chosen per step (Cao, Gillespie & Petzold, J. Chem. Phys. 126, 2007) (default)
+};
+
+
+// Settings of the tau-leaping method
+struct TauLeapingSettings {
+  TauScheme scheme;
+  double epsilon;          // error control: bound of the expected relative change of the reactant species per leap ("epsilon")
+  unsigned int ncritical;  // reactions that can fire fewer than ncritical more times before exhausting a reactant are critical ("ncritical")
+  double nssa;             // leaps shorter than nssa/a0 are replaced by ...
+  unsigned int ssa_steps;  // ... ssa_steps exact SSA steps
+  double nstiff;           // adaptive scheme: implicit leap if its step is more than nstiff times longer than the explicit one
+  double delta;            // a reversible reaction pair with |a_j - a_r| <= delta*min(a_j, a_r) is in partial equilibrium
+};
+
+
+// Stoichiometric structure of the step size selection, compiled once per run from the sparse stoichiometry
+struct LeapStructure {
+  std::vector<unsigned int> offset;   // reactants of reaction j: species[k] is consumed coef[k] times, k in [offset[j], offset[j+1])
+  std::vector<unsigned int> species;
+  std::vector<long long> coef;
+  std::vector<int> order;             // order of every reaction (no. of consumed molecules)
+  std::vector<int> reverse;           // reaction with the opposite state change (-1: none)
+};
+
+
+// Compile the reactants, reaction orders and reversible reaction pairs from the sparse stoichiometry
+inline void compile_leap_structure(const SparseStoichiometry &st, LeapStructure &ls) {
+  int nreactions = st.offset.size()-1;
+  ls.offset.assign(nreactions+1, 0);
+  ls.species.clear();
+  ls.coef.clear();
+  ls.order.assign(nreactions, 0);
+  ls.reverse.assign(nreactions, -1);
+  for (int j = 0; j < nreactions; j++) {
+    for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+      if (st.delta[k] < 0) {
+        ls.species.push_back(st.species[k]);
+        ls.coef.push_back(-st.delta[k]);
+        ls.order[j] += (int)-st.delta[k];
+      }
+    }
+    ls.offset[j+1] = ls.species.size();
+  }
+  // (the entries of every reaction are ordered by species)
+  for (int j = 0; j < nreactions; j++) {
+    for (int r = 0; r < nreactions && ls.reverse[j] < 0; r++) {
+      unsigned int n = st.offset[j+1] - st.offset[j];
+      if (r == j || n == 0 || st.offset[r+1] - st.offset[r] != n) {
+        continue;
+      }
+      bool opposite = true;
+      for (unsigned int k = 0; opposite && k < n; k++) {
+        opposite = st.species[st.offset[j]+k] == st.species[st.offset[r]+k] && st.delta[st.offset[j]+k] == -st.delta[st.offset[r]+k];
+      }
+      if (opposite) {
+        ls.reverse[j] = r;
+      }
+    }
+  }
+}
+
+
+// Highest order factor g_i of a species consumed coef times by a reaction of the given order (Cao et al. 2006, eq. 27)
+inline double order_factor(int order, long long coef, double xi) {
+  double x1 = std::max(xi-1, 1.0);
+  double x2 = std::max(xi-2, 1.0);
+  if (coef == 2) {
+    return order == 2 ? 2 + 1/x1 : 1.5*(2 + 1/x1);
+  }
+  if (coef >= 3) {
+    return 3 + 1/x1 + 2/x2;
+  }
+  return order;
+}
+
+
+// A reaction with positive propensity is critical if it can fire fewer than ncritical more times before exhausting one of its reactants
+inline bool is_critical(const LeapStructure &ls, unsigned int j, const unsigned long long *x, unsigned int ncritical) {
+  for (unsigned int k = ls.offset[j]; k < ls.offset[j+1]; k++) {
+    if (x[ls.species[k]]/(unsigned long long)ls.coef[k] < ncritical) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// Reaction j and its reverse reaction are in partial equilibrium
+inline bool in_partial_equilibrium(const LeapStructure &ls, const std::vector<double> &a, unsigned int j, double delta) {
+  int r = ls.reverse[j];
+  return r >= 0 && fabs(a[j] - a[r]) <= delta*std::min(a[j], a[r]);
+}
+
+
+// Leap size of Cao et al. 2006 (eq. 33): largest tau for which the expected change (mean and standard deviation) of every reactant species i
+// stays below max(epsilon*x_i/g_i, 1), taking into account the reactions j with use[j] != 0 (infinity if there are none).
+// Unlike the original, the reactants of all reactions are bounded (not only those of the leaping ones): otherwise low copy number intermediates
+// that are only consumed by critical or currently disabled reactions can be filled up by a single leap, which biases e.g. the open channel states of Ano1.
+// mu, sigma2 and g are scratch vectors. (Also the step size control of the Chemical Langevin Equation, with real valued x.)
+template <typename T>
+inline double select_leap(const LeapStructure &ls, const SparseStoichiometry &st, const T *x, const std::vector<double> &a,
+                          const std::vector<char> &use, double epsilon,
+                          std::vector<double> &mu, std::vector<double> &sigma2, std::vector<double> &g) {
+  int nspecies = mu.size();
+  std::fill(mu.begin(), mu.end(), 0.0);
+  std::fill(sigma2.begin(), sigma2.end(), 0.0);
+  std::fill(g.begin(), g.end(), 0.0);
+  for (unsigned int j = 0; j < use.size(); j++) {
+    if (use[j]) {
+      for (unsigned int k = st.offset[j]; k < st.offset[j+1]; k++) {
+        double v = (double)st.delta[k];
+        mu[st.species[k]] += v*a[j];
+        sigma2[st.species[k]] += v*v*a[j];
+      }
+    }
+    for (unsigned int k = ls.offset[j]; k < ls.offset[j+1]; k++) {
+      unsigned int i = ls.species[k];
+      g[i] = std::max(g[i], order_factor(ls.order[j], ls.coef[k], (double)x[i]));
+    }
+  }
+  double tau = std::numeric_limits<double>::infinity();
+  for (int i = 0; i < nspecies; i++) {
+    if (g[i] <= 0) {
+      continue;
+    }
+    double bound = std::max(epsilon*x[i]/g[i], 1.0);
+    if (mu[i] != 0) {
+      tau = std::min(tau, bound/fabs(mu[i]));
+    }
+    if (sigma2[i] > 0) {
+      tau = std::min(tau, bound*bound/sigma2[i]);
+    }
+  }
+  return tau;
+}
+
+
+// Solve the dense n x n system A z = b (A row-major, overwritten; z returned in b) by Gaussian elimination with partial pivoting.
+// Returns false for a singular matrix.
+inline bool solve_dense(int n, std::vector<double> &A, std::vector<double> &b) {
+  for (int c = 0; c < n; c++) {
+    int pivot = c;
+    for (int r = c+1; r < n; r++) {
+      if (fabs(A[r*n+c]) > fabs(A[pivot*n+c])) {
+        pivot = r;
+      }
+    }
+    if (A[pivot*n+c] == 0) {
+      return false;
+    }
+    if (pivot != c) {
+      for (int k = 0; k < n; k++) {
+        std::swap(A[c*n+k], A[pivot*n+k]);
+      }
+      std::swap(b[c], b[pivot]);
+    }
+    for (int r = c+1; r < n; r++) {
+      double factor = A[r*n+c]/A[c*n+c];
+      if (factor == 0) {
+        continue;
+      }
+      for (int k = c; k < n; k++) {
+        A[r*n+k] -= factor*A[c*n+k];
+      }
+      b[r] -= factor*b[c];
+    }
+  }
+  for (int r = n-1; r >= 0; r--) {
+    double sum = b[r];
+    for (int k = r+1; k < n; k++) {
+      sum -= A[r*n+k]*b[k];
+    }
+    b[r] = sum/A[r*n+r];
+  }
+  return true;
+}
+
+#endif
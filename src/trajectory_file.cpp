@@ -0,0 +1,95 @@
+#include "trajectory_file.hpp"
+#include <algorithm>
+#include <climits>
+#include <Rcpp.h>
+using namespace Rcpp;
+
+
+//' Read a Compressed Trajectory.
+//'
+//' Read a trajectory written by the simulators with user_sim_params "output_format" = "compressed". Only the blocks of the
+//' time window and the columns of the selected species are decoded.
+//' @param file A string: the path of the trajectory file.
+//' @param species A character vector: the species to read (default: all species of the file).
+//' @param from A number: the start of the time window [s] (default: the first output time).
+//' @param to A number: the end of the time window [s] (default: the last output time).
+//' @return A data frame with the columns "time", "Ca" and the particle numbers of the species (integer columns, numeric columns for
+//'         species with more particles than the integer range; concentration [nmol/l] = particle number/f with f the attribute "f").
+//' @examples
+//' \dontrun{
+//' read_trajectory("pkc.traj", species = "AADAGPKC_act", from = 10, to = 20)
+//' }
+//' @export
+// [[Rcpp::export]]
+DataFrame read_trajectory(std::string file, CharacterVector species = CharacterVector::create(), double from = R_NegInf, double to = R_PosInf) {
+  TrajectoryFile trajectory(file);
+  const TrajectoryMetadata &meta = trajectory.metadata();
+  std::vector<int> columns;
+  if (species.length() == 0) {
+    for (unsigned int i = 0; i < meta.species.size(); i++) {
+      columns.push_back(i);
+    }
+  } else {
+    for (int n = 0; n < species.length(); n++) {
+      std::string name = as<std::string>(species[n]);
+      unsigned int i = std::find(meta.species.begin(), meta.species.end(), name) - meta.species.begin();
+      if (i == meta.species.size()) {
+        stop("No species \"" + name + "\" in " + file + ".");
+      }
+      columns.push_back(i);
+    }
+  }
+  std::vector<double> time;
+  std::vector<double> calcium;
+  std::vector<std::vector<int64_t> > counts;
+  trajectory.read(from, to, columns, time, calcium, counts);
+  List df(columns.size()+2);
+  CharacterVector names(columns.size()+2);
+  df[0] = NumericVector(time.begin(), time.end());
+  df[1] = NumericVector(calcium.begin(), calcium.end());
+  names[0] = "time";
+  names[1] = "Ca";
+  for (unsigned int c = 0; c < columns.size(); c++) {
+    // integer columns, numeric for particle numbers beyond the integer range
+    if (counts[c].empty() || (*std::max_element(counts[c].begin(), counts[c].end()) <= INT_MAX &&
+                              *std::min_element(counts[c].begin(), counts[c].end()) > INT_MIN)) {
+      df[c+2] = IntegerVector(counts[c].begin(), counts[c].end());
+    } else {
+      df[c+2] = NumericVector(counts[c].begin(), counts[c].end());
+    }
+    names[c+2] = meta.species[columns[c]];
+  }
+  df.names() = names;
+  DataFrame result(df);
+  result.attr("f") = meta.f;
+  return result;
+}
+
+//' Compressed Trajectory Information.
+//'
+//' Read the header of a trajectory written with user_sim_params "output_format" = "compressed".
+//' @param file A string: the path of the trajectory file.
+//' @return A list with the model name ("model"), the species names ("species"), the volume ("vol") and the conversion factor from
+//'         concentrations to particle numbers ("f"), the propensity equation parameters ("params", named), the seed and stream of the native
+//'         random number generator ("seed" and "stream", NA for R's generator; user_sim_params "seed" and "stream" reproduce the run)
+//'         and the number of output rows ("nrow").
+//' @examples
+//' \dontrun{
+//' trajectory_info("pkc.traj")
+//' }
+//' @export
+// [[Rcpp::export]]
+List trajectory_info(std::string file) {
+  TrajectoryFile trajectory(file);
+  const TrajectoryMetadata &meta = trajectory.metadata();
+  NumericVector params(meta.param_values.begin(), meta.param_values.end());
+  params.names() = CharacterVector(meta.param_names.begin(), meta.param_names.end());
+  return List::create(_["model"] = meta.model,
+                      _["species"] = CharacterVector(meta.species.begin(), meta.species.end()),
+                      _["vol"] = meta.vol,
+                      _["f"] = meta.f,
+                      _["params"] = params,
+                      _["seed"] = meta.has_seed ? (double)meta.seed : NA_REAL,
+                      _["stream"] = meta.has_seed ? (double)meta.stream : NA_REAL,
+                      _["nrow"] = (double)trajectory.rows());
+}
@@ -0,0 +1,297 @@
+#ifndef TRAJECTORY_FILE_HPP
+#define TRAJECTORY_FILE_HPP
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+#include "output_sink.hpp"
+#include "calcium_trace.hpp"
+
+
+// Compressed trajectory file (user_sim_params "output_format" = "compressed"): particle numbers (64 bit) stored column by column,
+// every column as differences between consecutive rows in zigzag varint encoding (a change of +-1 takes one byte).
+// Layout (integers little endian as written by the platform, strings as 32 bit length and characters):
+//   header:  the 8 bytes "CMLTRAJ2", the model name, the number of species and their names, vol and f (doubles),
+//            the number of parameters and their names and values (doubles), a flag (32 bit), the seed and the stream (64 bit each)
+//            of the native generator (files of the first version, "CMLTRAJZ", have no stream: it was 0 unless set by the user)
+//   blocks:  one per output chunk: the number of rows and the size in bytes of every column (32 bit each), then the columns:
+//            time and calcium (doubles), the species (varint differences, the first row relative to 0: every block decodes on its own)
+//   index:   per block its offset and number of rows (64 bit each) and its first and last time (doubles)
+//   trailer: the offset of the index and the number of blocks (64 bit each) and the 8 bytes "CMLTRIDX"
+// The index lets readers decode only the blocks of a time window, the column sizes only the columns of the requested species.
+
+// Description of a trajectory (header of a compressed trajectory file)
+struct TrajectoryMetadata {
+  std::string model;
+  std::vector<std::string> species;
+  double vol;
+  double f;
+  std::vector<std::string> param_names;
+  std::vector<double> param_values;
+  bool has_seed;
+  uint64_t seed;
+  uint64_t stream;
+};
+
+// Zigzag varint encoding of a signed integer
+inline void put_varint(std::vector<unsigned char> &out, int64_t value) {
+  uint64_t v = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+  while (v >= 0x80) {
+    out.push_back((unsigned char)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((unsigned char)v);
+}
+
+template <typename T>
+inline void put_value(std::vector<unsigned char> &out, T value) {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+inline void put_string(std::vector<unsigned char> &out, const std::string &s) {
+  put_value<uint32_t>(out, s.size());
+  out.insert(out.end(), s.begin(), s.end());
+}
+
+
+class CompressedSink : public OutputSink {
+public:
+  CompressedSink(const std::string &path, const TrajectoryMetadata &meta) : file(path), offset(0), nblocks(0) {
+    std::vector<unsigned char> header(reinterpret_cast<const unsigned char *>("CMLTRAJ2"), reinterpret_cast<const unsigned char *>("CMLTRAJ2") + 8);
+    put_string(header, meta.model);
+    put_value<uint32_t>(header, meta.species.size());
+    for (unsigned int i = 0; i < meta.species.size(); i++) {
+      put_string(header, meta.species[i]);
+    }
+    put_value(header, meta.vol);
+    put_value(header, meta.f);
+    put_value<uint32_t>(header, meta.param_names.size());
+    for (unsigned int k = 0; k < meta.param_names.size(); k++) {
+      put_string(header, meta.param_names[k]);
+      put_value(header, meta.param_values[k]);
+    }
+    put_value<uint32_t>(header, meta.has_seed);
+    put_value<uint64_t>(header, meta.seed);
+    put_value<uint64_t>(header, meta.stream);
+    write_bytes(header);
+  }
+  void write(const OutputChunk &chunk) {
+    if (chunk.type != OUTPUT_COUNT) {
+      throw std::runtime_error("The compressed output format stores particle numbers (output type integer)");
+    }
+    int ncol = chunk.nspecies+2;
+    std::vector<unsigned char> &block = buffer;
+    block.assign(sizeof(uint32_t)*(ncol+1), 0);
+    std::vector<uint32_t> sizes(ncol+1);
+    sizes[0] = chunk.nrow;
+    for (int c = 0; c < 2; c++) {
+      size_t start = block.size();
+      for (int r = 0; r < chunk.nrow; r++) {
+        put_value(block, chunk.values[r + (size_t)c*chunk.ld]);
+      }
+      sizes[c+1] = block.size() - start;
+    }
+    for (int c = 0; c < chunk.nspecies; c++) {
+      size_t start = block.size();
+      const int64_t *counts = static_cast<const int64_t *>(chunk.species) + (size_t)c*chunk.ld;
+      int64_t previous = 0;
+      for (int r = 0; r < chunk.nrow; r++) {
+        put_varint(block, counts[r] - previous);
+        previous = counts[r];
+      }
+      sizes[c+3] = block.size() - start;
+    }
+    std::memcpy(block.data(), sizes.data(), sizeof(uint32_t)*sizes.size());
+    put_value<uint64_t>(index, offset);
+    put_value<uint64_t>(index, chunk.nrow);
+    put_value(index, chunk.values[0]);
+    put_value(index, chunk.values[chunk.nrow-1]);
+    nblocks++;
+    write_bytes(block);
+  }
+  void close() {
+    uint64_t index_offset = offset;
+    std::vector<unsigned char> trailer = index;
+    put_value<uint64_t>(trailer, index_offset);
+    put_value<uint64_t>(trailer, nblocks);
+    trailer.insert(trailer.end(), reinterpret_cast<const unsigned char *>("CMLTRIDX"), reinterpret_cast<const unsigned char *>("CMLTRIDX") + 8);
+    write_bytes(trailer);
+  }
+private:
+  void write_bytes(const std::vector<unsigned char> &bytes) {
+    file.write(bytes.data(), bytes.size());
+    offset += bytes.size();
+  }
+  OutputFile file;
+  uint64_t offset;
+  uint64_t nblocks;
+  std::vector<unsigned char> buffer;
+  std::vector<unsigned char> index;
+};
+
+
+// Reader of a compressed trajectory file (memory-mapped)
+class TrajectoryFile {
+public:
+  explicit TrajectoryFile(const std::string &path) : file(path) {
+    const char *p = file.data();
+    const char *end = p + file.size();
+    bool has_stream = file.size() >= 32 && std::memcmp(p, "CMLTRAJ2", 8) == 0;
+    if (file.size() < 32 || (!has_stream && std::memcmp(p, "CMLTRAJZ", 8) != 0)) {
+      throw std::runtime_error("Not a compressed trajectory file: " + path);
+    }
+    if (std::memcmp(end - 8, "CMLTRIDX", 8) != 0) {
+      throw std::runtime_error("Incomplete compressed trajectory file (the simulation did not finish): " + path);
+    }
+    p += 8;
+    meta.model = get_string(p, end);
+    uint32_t nspecies = get_value<uint32_t>(p, end);
+    for (uint32_t i = 0; i < nspecies; i++) {
+      meta.species.push_back(get_string(p, end));
+    }
+    meta.vol = get_value<double>(p, end);
+    meta.f = get_value<double>(p, end);
+    uint32_t nparams = get_value<uint32_t>(p, end);
+    for (uint32_t k = 0; k < nparams; k++) {
+      meta.param_names.push_back(get_string(p, end));
+      meta.param_values.push_back(get_value<double>(p, end));
+    }
+    meta.has_seed = get_value<uint32_t>(p, end) != 0;
+    meta.seed = get_value<uint64_t>(p, end);
+    meta.stream = has_stream ? get_value<uint64_t>(p, end) : 0;
+    const char *trailer = end - 24;
+    uint64_t index_offset = get_value<uint64_t>(trailer, end);
+    uint64_t nblocks = get_value<uint64_t>(trailer, end);
+    if (index_offset > file.size() - 24 || (file.size() - 24 - index_offset) != nblocks*32) {
+      throw std::runtime_error("Invalid compressed trajectory file: " + path);
+    }
+    const char *q = file.data() + index_offset;
+    nrow = 0;
+    for (uint64_t b = 0; b < nblocks; b++) {
+      Block block;
+      block.offset = get_value<uint64_t>(q, end);
+      block.nrow = get_value<uint64_t>(q, end);
+      block.first = get_value<double>(q, end);
+      block.last = get_value<double>(q, end);
+      blocks.push_back(block);
+      nrow += block.nrow;
+    }
+  }
+
+  const TrajectoryMetadata &metadata() const {
+    return meta;
+  }
+  uint64_t rows() const {
+    return nrow;
+  }
+
+  // Rows with from <= time <= to: times, calcium and the particle numbers of the given species (indices into the species names);
+  // only the blocks of the window and the columns of the species are decoded
+  void read(double from, double to, const std::vector<int> &species, std::vector<double> &time, std::vector<double> &calcium,
+            std::vector<std::vector<int64_t> > &counts) const {
+    int ncol = meta.species.size()+2;
+    counts.assign(species.size(), std::vector<int64_t>());
+    for (unsigned int b = 0; b < blocks.size(); b++) {
+      const Block &block = blocks[b];
+      if (block.last < from || block.first > to) {
+        continue;
+      }
+      const char *end = file.data() + file.size();
+      const char *p = file.data() + block.offset;
+      std::vector<uint32_t> sizes(ncol+1);
+      for (int c = 0; c <= ncol; c++) {
+        sizes[c] = get_value<uint32_t>(p, end);
+      }
+      int n = sizes[0];
+      size_t block_size = 0;
+      std::vector<const char *> columns(ncol);
+      for (int c = 0; c < ncol; c++) {
+        columns[c] = p + block_size;
+        block_size += sizes[c+1];
+      }
+      if (block_size > (size_t)(end - p) || sizes[1] != n*sizeof(double) || sizes[2] != n*sizeof(double)) {
+        throw std::runtime_error("Invalid block in compressed trajectory file");
+      }
+      // rows of the window
+      int r0 = 0;
+      int r1 = n;
+      std::vector<double> t(n);
+      std::memcpy(t.data(), columns[0], n*sizeof(double));
+      while (r0 < n && t[r0] < from) {
+        r0++;
+      }
+      while (r1 > r0 && t[r1-1] > to) {
+        r1--;
+      }
+      time.insert(time.end(), t.begin() + r0, t.begin() + r1);
+      for (int r = r0; r < r1; r++) {
+        double ca;
+        std::memcpy(&ca, columns[1] + r*sizeof(double), sizeof(double));
+        calcium.push_back(ca);
+      }
+      for (unsigned int s = 0; s < species.size(); s++) {
+        const char *q = columns[species[s]+2];
+        const char *column_end = q + sizes[species[s]+3];
+        int64_t value = 0;
+        for (int r = 0; r < r1; r++) {
+          value += get_varint(q, column_end);
+          if (r >= r0) {
+            counts[s].push_back(value);
+          }
+        }
+      }
+    }
+  }
+
+private:
+  struct Block {
+    uint64_t offset;
+    uint64_t nrow;
+    double first;
+    double last;
+  };
+
+  template <typename T>
+  static T get_value(const char *&p, const char *end) {
+    if (p + sizeof(T) > end) {
+      throw std::runtime_error("Truncated compressed trajectory file");
+    }
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+  }
+  static std::string get_string(const char *&p, const char *end) {
+    uint32_t n = get_value<uint32_t>(p, end);
+    if (p + n > end) {
+      throw std::runtime_error("Truncated compressed trajectory file");
+    }
+    std::string s(p, n);
+    p += n;
+    return s;
+  }
+  static int64_t get_varint(const char *&p, const char *end) {
+    uint64_t v = 0;
+    for (int shift = 0; ; shift += 7) {
+      if (p >= end || shift > 63) {
+        throw std::runtime_error("Invalid varint in compressed trajectory file");
+      }
+      unsigned char byte = *p++;
+      v |= (uint64_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        break;
+      }
+    }
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+  }
+
+  MappedFile file;
+  TrajectoryMetadata meta;
+  std::vector<Block> blocks;
+  uint64_t nrow;
+};
+
+#endif